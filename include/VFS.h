@@ -7,8 +7,8 @@
 //============================================================================
 //    INTERFACE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
 //============================================================================
-// The Handle Type.
-enum VFS_Handle { VFS_HANDLE_FORCE_DWORD = 0xFFFFFFFF };
+// The Handle Type (as wide as a VFS_DWORD, since it holds a Pointer).
+enum VFS_Handle : VFS_DWORD { VFS_HANDLE_FORCE_DWORD = 0xFFFFFFFF };
 
 // Various Constants.
 static const VFS_WORD VFS_VERSION = VFS_MAKE_WORD(0, 1);	// Version 1.0
@@ -23,7 +23,12 @@ static const VFS_LONG VFS_INVALID_LONG_VALUE = -1;
 // The File_Open/Create() Flags.
 enum VFS_OpenFlags {
     VFS_READ = 0x0001,
-    VFS_WRITE = 0x0002
+    VFS_WRITE = 0x0002,
+
+    // Checksum Verification of archived Files (overrides the Default set with VFS_Archive_SetVerifyMode(); the strongest Mode wins if several are given).
+    VFS_VERIFY_OFF = 0x0004,	// Don't verify the File.
+    VFS_VERIFY_FIRST_READ = 0x0008,	// Verify the File the first Time it's read from its Archive.
+    VFS_VERIFY_ALWAYS = 0x0010	// Verify the File each Time it's read from its Archive.
 };
 
 // The File_Seek() Origin.
@@ -50,6 +55,7 @@ enum VFS_ErrorCode {
     VFS_ERROR_NOT_AN_ARCHIVE,
     VFS_ERROR_INVALID_ARCHIVE_FORMAT,
     VFS_ERROR_MISSING_FILTERS,
+    VFS_ERROR_CHECKSUM_MISMATCH,
     VFS_NUM_ERRORS
 };
 
@@ -60,6 +66,50 @@ enum VFS_EntityType {
     VFS_ARCHIVE
 };
 
+// The Operations whose Latency is tracked (see VFS_GetLatencyHistogram()).
+enum VFS_Operation {
+    // Public Entry Points.
+    VFS_OP_FILE_CREATE,
+    VFS_OP_FILE_OPEN,
+    VFS_OP_FILE_CLOSE,
+    VFS_OP_FILE_READ,
+    VFS_OP_FILE_WRITE,
+    VFS_OP_FILE_READ_ENTIRE_FILE,
+    VFS_OP_FILE_WRITE_ENTIRE_FILE,
+    VFS_OP_FILE_SEEK,
+    VFS_OP_FILE_RESIZE,
+    VFS_OP_FILE_EXISTS,
+    VFS_OP_FILE_GET_INFO,
+    VFS_OP_FILE_DELETE,
+    VFS_OP_FILE_COPY,
+    VFS_OP_FILE_MOVE,
+    VFS_OP_FILE_RENAME,
+    VFS_OP_ARCHIVE_CREATE_FROM_DIRECTORY,
+    VFS_OP_ARCHIVE_CREATE_FROM_FILE_LIST,
+    VFS_OP_ARCHIVE_EXTRACT,
+    VFS_OP_ARCHIVE_EXTRACT_FILE,
+    VFS_OP_ARCHIVE_GET_INFO,
+    VFS_OP_ARCHIVE_FLUSH,
+    VFS_OP_DIR_CREATE,
+    VFS_OP_DIR_DELETE,
+    VFS_OP_DIR_MOVE,
+    VFS_OP_DIR_EXISTS,
+    VFS_OP_DIR_GET_INFO,
+    VFS_OP_DIR_ITERATE,
+    VFS_OP_DIR_GET_CONTENTS,
+    VFS_OP_EXISTS_ENTITY,
+    VFS_OP_GET_ENTITY_INFO,
+    VFS_OP_FLUSH,
+
+    // Internal Phases (to attribute the Latency of the Entry Points to Lookup, I/O and Decoding).
+    VFS_OP_ARCHIVE_LOOKUP,
+    VFS_OP_ARCHIVE_PARSE,
+    VFS_OP_ARCHIVE_READ,
+    VFS_OP_DECODE,
+
+    VFS_NUM_OPERATIONS
+};
+
 // The Filter Reader and Writer Procedures.
 typedef VFS_BOOL(*VFS_FilterReadProc) (VFS_BYTE * pBuffer, VFS_DWORD dwBytesToRead, VFS_DWORD * pBytesRead);
 typedef VFS_BOOL(*VFS_FilterWriteProc) (const VFS_BYTE * pBuffer, VFS_DWORD dwBytesToWrite, VFS_DWORD * pBytesWritten);
@@ -67,12 +117,22 @@ typedef VFS_BOOL(*VFS_FilterWriteProc) (const VFS_BYTE * pBuffer, VFS_DWORD dwBy
 // An Iteration Procedure (return VFS_FALSE to cancel Iteration).
 typedef VFS_BOOL(*VFS_DirIterationProc) (const struct VFS_EntityInfo & Info, void *pParam);
 
+// A Statistics Export Procedure, called once per Line of Text (return VFS_FALSE to cancel the Export, VFS_ExportStats() fails then).
+typedef VFS_BOOL(*VFS_StatsExportProc) (const char *pszLine, void *pParam);
+
 // A List of Filter Names.
 typedef std::vector < const class VFS_Filter *>VFS_FilterList;
 typedef std::vector < VFS_String > VFS_FilterNameList;
 typedef std::vector < VFS_String > VFS_RootPathList;
 typedef std::vector < struct VFS_EntityInfo >VFS_EntityInfoList;
 typedef std::map < VFS_String, VFS_String > VFS_FileNameMap;
+typedef std::vector < VFS_String > VFS_FileNameList;
+
+// Samples for training a Filter (the Contents of the Sample Files one after the other and their Sizes).
+struct VFS_FilterSamples {
+    std::vector < VFS_BYTE > Data;
+    std::vector < VFS_DWORD > Sizes;
+};
 
 //============================================================================
 //    INTERFACE COMPONENT HEADERS
@@ -100,6 +160,11 @@ class VFS_Filter {
     virtual VFS_BOOL SaveConfigData(VFS_FilterWriteProc Writer) const = 0;
     virtual VFS_DWORD GetConfigDataSize() const = 0;
 
+    // Training (the Archive Builder passes Samples of the small Files of the Archive before it saves the Configuration Data, so the Filter can derive it from them, e.g. a Compression Dictionary which is stored once per Archive and used for each File; does nothing by default).
+    virtual VFS_BOOL Train(const VFS_FilterSamples & /* Samples */) {
+	return VFS_TRUE;
+    }
+
     // Information.
     virtual VFS_PCSTR GetName() const = 0;
     virtual VFS_PCSTR GetDescription() const = 0;
@@ -121,6 +186,187 @@ struct VFS_EntityInfo {
     VFS_LONG lSize;
 };
 
+// Runtime Statistics of the VFS (see VFS_GetStats()).
+struct VFS_Stats {
+    // The Number of Files opened (or created) per Backend.
+    VFS_QWORD qwStdIOFileOpens;
+    VFS_QWORD qwArchiveFileOpens;
+
+    // The Number of Bytes read from / written to Standard Files and produced by the Filters.
+    VFS_QWORD qwBytesRead;
+    VFS_QWORD qwBytesWritten;
+    VFS_QWORD qwBytesDecoded;
+
+    // The Time spent decoding archived Files (in Nanoseconds).
+    VFS_QWORD qwDecodeNanoseconds;
+
+    // The Number of Bytes checked against their Checksums and the Number of Checksum Mismatches.
+    VFS_QWORD qwBytesVerified;
+    VFS_QWORD qwChecksumMismatches;
+
+    // The Number of Bytes read ahead by the Prefetcher (see VFS_Trace_Prefetch()).
+    VFS_QWORD qwBytesPrefetched;
+
+    // The Number of Solid Blocks found in / missing from the Block Cache.
+    VFS_QWORD qwBlockCacheHits;
+    VFS_QWORD qwBlockCacheMisses;
+
+    // The Number of parsed Archives, of Archive Dirs whose Files were loaded on Demand, probed Root Paths and issued File System Calls.
+    VFS_QWORD qwArchiveParses;
+    VFS_QWORD qwArchiveDirLoads;
+    VFS_QWORD qwArchiveEvictions;	// Archives closed because there were too many open ones.
+    VFS_QWORD qwRootPathProbes;
+    VFS_QWORD qwSyscalls;
+
+    // The Number of currently open Files and Archives.
+    VFS_DWORD dwOpenFiles;
+    VFS_DWORD dwOpenArchives;
+};
+
+// A log-bucketed Latency Histogram of an Operation (see VFS_GetLatencyHistogram()).
+struct VFS_Histogram {
+    // The Number of Calls and the Sum of their Latencies (in Nanoseconds).
+    VFS_QWORD qwCount;
+    VFS_QWORD qwSumNanoseconds;
+
+    // The Number of Calls per Bucket and the (exclusive) upper Limit of each Bucket (in Nanoseconds).
+    std::vector < VFS_QWORD > Counts;
+    std::vector < VFS_QWORD > Limits;
+};
+
+// A normalized File Name (without a trailing Path Separator) with Views of its Components, a lower-cased Key and a precomputed Hash.
+// Looking up a VFS_Path doesn't allocate any Memory, and reassigning a VFS_Path reuses its Storage.
+class VFS_Path {
+    VFS_String m_strPath;	// In its original Case (the File System needn't ignore the Case).
+    VFS_String m_strKey;	// Lower-cased (the open Files etc. are looked up by it).
+    VFS_QWORD m_qwHash;
+    VFS_DWORD m_dwPathLength;	// The Length of the Path without the Name.
+    VFS_DWORD m_dwNameOffset;
+    VFS_DWORD m_dwExtensionOffset;	// The Offset of the last '.' in the Name (the Length of the whole String if there isn't any).
+
+    // Strip the trailing Separator, lower-case the Key and find the Components.
+    VFS_Path & Normalize();
+
+  public:
+    // Constructors (the second one joins a Directory and a Name).
+    VFS_Path() {
+	Assign(VFS_StringView());
+    }
+    explicit VFS_Path(VFS_StringView strPath) {
+	Assign(strPath);
+    }
+    VFS_Path(VFS_StringView strDir, VFS_StringView strName) {
+	Assign(strDir, strName);
+    }
+
+    // Assignment.
+    VFS_Path & Assign(VFS_StringView strPath);
+    VFS_Path & Assign(VFS_StringView strDir, VFS_StringView strName);
+
+    // The normalized File Name (for the File System) / its Key and the Hash of the Key (for Lookups).
+    const VFS_String & Get() const {
+	return m_strPath;
+    }
+    VFS_StringView GetView() const {
+	return m_strPath;
+    }
+    const VFS_String & GetKey() const {
+	return m_strKey;
+    }
+    VFS_StringView GetKeyView() const {
+	return m_strKey;
+    }
+    VFS_QWORD GetHash() const {
+	return m_qwHash;
+    }
+    VFS_BOOL IsEmpty() const {
+	return m_strPath.empty();
+    }
+    VFS_BOOL IsAbsolute() const;
+
+    // The Components (with the same Semantics as VFS_Util_GetPath() etc.).
+    VFS_StringView GetPath() const {
+	return GetView().substr(0, m_dwPathLength);
+    }
+    VFS_StringView GetName() const {
+	return GetView().substr(m_dwNameOffset);
+    }
+    VFS_StringView GetBaseName() const {
+	return GetView().substr(m_dwNameOffset, m_dwExtensionOffset - m_dwNameOffset);
+    }
+    VFS_StringView GetExtension() const {
+	return m_dwExtensionOffset < m_strPath.size() ? GetView().substr(m_dwExtensionOffset + 1) : VFS_StringView();
+    }
+
+    // Comparison (ignoring the Case).
+    VFS_BOOL operator ==(const VFS_Path & Other) const {
+	return m_qwHash == Other.m_qwHash && m_strKey == Other.m_strKey;
+    }
+    VFS_BOOL operator !=(const VFS_Path & Other) const {
+	return !(*this == Other);
+    }
+};
+
+// A Filter for the Entries of a VFS_DirIterator, checked before an Entry is built (the Defaults accept everything; the
+// Extension and the Size Range only apply to Files).
+struct VFS_DirFilter {
+    VFS_DWORD dwTypes;		// A Combination of ( 1 << VFS_FILE ) etc. (0 accepts all Types).
+    VFS_String strExtension;	// Without the '.', compared ignoring the Case (empty accepts all Extensions).
+    VFS_LONG lMinSize;
+    VFS_LONG lMaxSize;		// VFS_INVALID_LONG_VALUE means there's no upper Limit.
+
+    VFS_DirFilter():dwTypes(0), lMinSize(0), lMaxSize(VFS_INVALID_LONG_VALUE) {
+    }
+};
+
+// A pull-style Iterator over the Contents of a Directory (in the Order of VFS_Dir_Iterate()). The Name of the current Entry
+// is a View into the Archive Index or into the Entries read from the Directory, its Path a View into a Buffer of the Iterator,
+// so both are only valid until the next Call of Next(); the VFS mustn't be flushed during the Iteration.
+class VFS_DirIterator {
+    struct VFS_DirIteratorState *m_pState;
+
+    // The current Entry.
+    VFS_EntityType m_eType;
+    VFS_BOOL m_bArchived;
+    VFS_StringView m_strPath;
+    VFS_StringView m_strName;
+    VFS_LONG m_lSize;
+
+    // Copying is not allowed.
+    VFS_DirIterator(const VFS_DirIterator &);
+    VFS_DirIterator & operator =(const VFS_DirIterator &);
+
+  public:
+    // Constructor / Destructor.
+    VFS_DirIterator();
+    ~VFS_DirIterator();
+
+    // Start iterating a Directory (an Iterator may be opened again, it keeps its Buffers) / stop it.
+    VFS_BOOL Open(const VFS_String & strDirName, VFS_BOOL bRecursive = VFS_FALSE, const VFS_DirFilter * pFilter = NULL);
+    void Close();
+
+    // Advance to the next Entry (returns VFS_FALSE at the End, where the last Error is VFS_ERROR_NONE, or if an Error occured).
+    VFS_BOOL Next();
+
+    // The current Entry (GetInfo() copies it).
+    VFS_EntityType GetType() const {
+	return m_eType;
+    }
+    VFS_BOOL IsArchived() const {
+	return m_bArchived;
+    }
+    VFS_StringView GetPath() const {
+	return m_strPath;
+    }
+    VFS_StringView GetName() const {
+	return m_strName;
+    }
+    VFS_LONG GetSize() const {
+	return m_lSize;
+    }
+    void GetInfo(VFS_EntityInfo & Info) const;
+};
+
 //============================================================================
 //    INTERFACE DATA DECLARATIONS
 //============================================================================
@@ -163,16 +409,30 @@ VFS_BOOL VFS_ExistsEntity(const VFS_String & strPath);
 VFS_BOOL VFS_GetEntityInfo(const VFS_String & strPath, VFS_EntityInfo & Info);
 VFS_WORD VFS_GetVersion();
 
-// Error Handling.
+// Error Handling (the Last Error is kept per Thread).
 VFS_ErrorCode VFS_GetLastError();
 VFS_PCSTR VFS_GetErrorString(VFS_ErrorCode eError);
 
+// Statistics (the Counters are kept per Thread and summed up by VFS_GetStats(); both functions may be called even if the VFS isn't initialized yet).
+VFS_BOOL VFS_GetStats(VFS_Stats & Stats);
+VFS_BOOL VFS_ResetStats();
+
+// Latency Histograms (VFS_ResetStats() resets them as well; the Percentile is in the Range [0..100], the Result is the upper Limit of the Bucket in Nanoseconds).
+VFS_BOOL VFS_GetLatencyHistogram(VFS_Operation eOperation, VFS_Histogram & Histogram);
+VFS_QWORD VFS_GetLatencyPercentile(VFS_Operation eOperation, double dPercentile);
+VFS_PCSTR VFS_GetOperationName(VFS_Operation eOperation);
+
+// Export the Counters and Histograms in the Prometheus Text Format (the File is written to a temporary File which is then renamed, so Scrapers never see partial Files).
+VFS_BOOL VFS_ExportStats(VFS_StatsExportProc pExportProc, void *pParam = NULL);
+VFS_BOOL VFS_ExportStatsToFile(const VFS_String & strFileName);
+
 ///////////////////////////////////////////////////////////////////////////////
-// The File Interface (the file interface will try to create a file in each root path. If no root path has been added, the current directory will be used instead. You can't manipulate Archive Files.).
+// The File Interface (the file interface will try to create a file in each root path. If no root path has been added, the current directory will be used instead. You can't manipulate Archive Files. The lookup functions take String Views, so C Strings don't have to be copied, and VFS_Path objects, which are looked up without allocating any Memory.).
 ///////////////////////////////////////////////////////////////////////////////
 // Create / Open / Close a File.
 VFS_Handle VFS_File_Create(const VFS_String & strFileName, VFS_DWORD dwFlags);
-VFS_Handle VFS_File_Open(const VFS_String & strFileName, VFS_DWORD dwFlags);
+VFS_Handle VFS_File_Open(VFS_StringView strFileName, VFS_DWORD dwFlags);
+VFS_Handle VFS_File_Open(const VFS_Path & FileName, VFS_DWORD dwFlags);
 VFS_BOOL VFS_File_Close(VFS_Handle hFile);
 
 // Read / Write from / to the File.
@@ -180,34 +440,50 @@ VFS_BOOL VFS_File_Read(VFS_Handle hFile, VFS_BYTE * pBuffer, VFS_DWORD dwToRead,
 VFS_BOOL VFS_File_Write(VFS_Handle hFile, const VFS_BYTE * pBuffer, VFS_DWORD dwToWrite, VFS_DWORD * pWritten = NULL);
 
 // Direct File Reading / Writing.
-VFS_BOOL VFS_File_ReadEntireFile(const VFS_String & strFileName, VFS_BYTE * pBuffer, VFS_DWORD dwToRead = VFS_INVALID_DWORD_VALUE, VFS_DWORD * pRead = NULL);
+VFS_BOOL VFS_File_ReadEntireFile(VFS_StringView strFileName, VFS_BYTE * pBuffer, VFS_DWORD dwToRead = VFS_INVALID_DWORD_VALUE, VFS_DWORD * pRead = NULL);
+VFS_BOOL VFS_File_ReadEntireFile(const VFS_Path & FileName, VFS_BYTE * pBuffer, VFS_DWORD dwToRead = VFS_INVALID_DWORD_VALUE, VFS_DWORD * pRead = NULL);
 VFS_BOOL VFS_File_WriteEntireFile(const VFS_String & strFileName, const VFS_BYTE * pBuffer, VFS_DWORD dwToWrite, VFS_DWORD * pWritten = NULL);
 
+// Read the entire File into a Buffer of its exact Size (archived Files which aren't open are decoded right into it).
+VFS_BOOL VFS_File_ReadEntireFile(VFS_StringView strFileName, std::vector < VFS_BYTE > &Data);
+VFS_BOOL VFS_File_ReadEntireFile(const VFS_Path & FileName, std::vector < VFS_BYTE > &Data);
+
+// The Size of the Data of a File as it's read (the Size of an archived File is taken from the Index of its Archive, the File isn't opened and decoded).
+VFS_BOOL VFS_File_GetDecodedSize(VFS_StringView strFileName, VFS_LONG & lSize);
+VFS_BOOL VFS_File_GetDecodedSize(const VFS_Path & FileName, VFS_LONG & lSize);
+
 // Positioning.
 VFS_BOOL VFS_File_Seek(VFS_Handle hFile, VFS_LONG lPosition, VFS_SeekOrigin eOrigin = VFS_SET);
 VFS_LONG VFS_File_Tell(VFS_Handle hFile);
 
 // Sizing.
 VFS_BOOL VFS_File_Resize(VFS_Handle hFile, VFS_LONG lSize);
+VFS_BOOL VFS_File_Preallocate(VFS_Handle hFile, VFS_LONG lSize);	// Reserves Space for lSize Bytes without changing the Size (just a Hint, it succeeds if the File System doesn't support it).
 VFS_LONG VFS_File_GetSize(VFS_Handle hFile);
 
+// Buffering (the Size of the user-space Buffer of Standard Files opened afterwards; Reads and Writes at least as big as the Buffer bypass it, 0 disables Buffering).
+VFS_BOOL VFS_File_SetBufferSize(VFS_DWORD dwBufferSize);
+VFS_DWORD VFS_File_GetBufferSize();
+
 // Information.
-VFS_BOOL VFS_File_Exists(const VFS_String & strFileName);
-VFS_BOOL VFS_File_GetInfo(const VFS_String & strFileName, VFS_EntityInfo & Info);
+VFS_BOOL VFS_File_Exists(VFS_StringView strFileName);
+VFS_BOOL VFS_File_Exists(const VFS_Path & FileName);
+VFS_BOOL VFS_File_GetInfo(VFS_StringView strFileName, VFS_EntityInfo & Info);
+VFS_BOOL VFS_File_GetInfo(const VFS_Path & FileName, VFS_EntityInfo & Info);
 VFS_BOOL VFS_File_GetInfo(VFS_Handle hFile, VFS_EntityInfo & Info);
 
 // File Management.
 VFS_BOOL VFS_File_Delete(const VFS_String & strFileName);
 VFS_BOOL VFS_File_Copy(const VFS_String & strFrom, const VFS_String & strTo);
-VFS_BOOL VFS_File_Move(const VFS_String & strFrom, const VFS_String & strTo);
+VFS_BOOL VFS_File_Move(const VFS_String & strFrom, const VFS_String & strTo);	// Renames the File if possible; Files are only copied (and deleted) if the Target is on another Device.
 VFS_BOOL VFS_File_Rename(const VFS_String & strFrom, const VFS_String & strTo);	// pszTo has to be a single File Name without a Path.
 
 ///////////////////////////////////////////////////////////////////////////////
-// The Archive Interface (Never provide a extension for the archive, instead, change the VFS_ARCHIVE_EXTENSION definition and recompile; You can only create archives in the first root path. You can't manipulate Archives. Each entry VFS_FileNameMap consists of the source file name and the file name in the archive, for instance "alpha/beta/gamma.txt" => "abg.txt").
+// The Archive Interface (Never provide a extension for the archive, instead, change the VFS_ARCHIVE_EXTENSION definition and recompile; You can only create archives in the first root path. You can't manipulate Archives. Each entry VFS_FileNameMap consists of the source file name and the file name in the archive, for instance "alpha/beta/gamma.txt" => "abg.txt". The optional access order lists files in the order they are loaded, for instance a recorded profile; their data is laid out in that order, followed by the remaining files in name order. Each entry of it is either a source file name or the name of a file in the archive, optionally prefixed by any path such as the archive's).
 ///////////////////////////////////////////////////////////////////////////////
 // Create an Archive.
-VFS_BOOL VFS_Archive_CreateFromDirectory(const VFS_String & strArchiveFileName, const VFS_String & strDirName, const VFS_FilterNameList & UsedFilters = VFS_FilterNameList(), VFS_BOOL bRecursive = VFS_TRUE);
-VFS_BOOL VFS_Archive_CreateFromFileList(const VFS_String & strArchiveFileName, const VFS_FileNameMap & Files, const VFS_FilterNameList & UsedFilters = VFS_FilterNameList());
+VFS_BOOL VFS_Archive_CreateFromDirectory(const VFS_String & strArchiveFileName, const VFS_String & strDirName, const VFS_FilterNameList & UsedFilters = VFS_FilterNameList(), VFS_BOOL bRecursive = VFS_TRUE, const VFS_FileNameList & AccessOrder = VFS_FileNameList());
+VFS_BOOL VFS_Archive_CreateFromFileList(const VFS_String & strArchiveFileName, const VFS_FileNameMap & Files, const VFS_FilterNameList & UsedFilters = VFS_FilterNameList(), const VFS_FileNameList & AccessOrder = VFS_FileNameList());
 
 // Extract an Archive / File.
 VFS_BOOL VFS_Archive_Extract(const VFS_String & strArchiveFileName, const VFS_String & strTargetDir);
@@ -221,21 +497,71 @@ VFS_BOOL VFS_Archive_GetUsedFilters(const VFS_String & strArchiveFileName, VFS_F
 // Archive Management.
 VFS_BOOL VFS_Archive_Delete(const VFS_String & strArchiveFileName);
 
-// Flush the Archive System.
+// Flush the Archive System (unused Archives are closed, the others drop the Files of their Dirs until they're needed again).
 VFS_BOOL VFS_Archive_Flush();
 
+// The maximum Number of open Archives (256 by default, 0 means no Limit). Each open Archive holds a File Descriptor; when another
+// Archive is opened, the least recently used ones without open Files are closed. Archives in use are never closed, so the Limit
+// may be exceeded while they are.
+VFS_BOOL VFS_Archive_SetMaxOpenArchives(VFS_DWORD dwMax);
+VFS_DWORD VFS_Archive_GetMaxOpenArchives();
+
+// The Number of Threads used by VFS_Archive_Extract() (0 means one per Core; Archives with Filters are extracted by one Thread, since Filters needn't be reentrant).
+VFS_BOOL VFS_Archive_SetExtractionThreads(VFS_DWORD dwThreads);
+VFS_DWORD VFS_Archive_GetExtractionThreads();
+
+// The default Checksum Verification Mode (one of the VFS_VERIFY_* Flags, VFS_VERIFY_FIRST_READ by default; the Index of an Archive is verified when it's opened unless the Mode is VFS_VERIFY_OFF).
+VFS_BOOL VFS_Archive_SetVerifyMode(VFS_DWORD dwMode);
+VFS_DWORD VFS_Archive_GetVerifyMode();
+
+// Solid Blocks: when creating Archives, Files up to the Solid File Size Limit (4K by default) are grouped into Blocks of up to the Solid Block Size which are filtered as a whole (a Block Size of 0, the Default, stores each File on its own).
+VFS_BOOL VFS_Archive_SetSolidBlockSize(VFS_DWORD dwSize);
+VFS_DWORD VFS_Archive_GetSolidBlockSize();
+VFS_BOOL VFS_Archive_SetSolidFileSizeLimit(VFS_DWORD dwSize);
+VFS_DWORD VFS_Archive_GetSolidFileSizeLimit();
+
+// Inline Files: when creating Archives, Files up to this Size are stored in the Index, so they are in Memory as soon as the Archive is open (they aren't filtered, so don't use it for Data which has to be encrypted; 0, the Default, stores no File inline).
+VFS_BOOL VFS_Archive_SetInlineFileSizeLimit(VFS_DWORD dwSize);
+VFS_DWORD VFS_Archive_GetInlineFileSizeLimit();
+
+// The maximum Amount of Data the Archive Builder samples from the small Files (see above) to train the Filters with (0, the Default, disables Training).
+VFS_BOOL VFS_Archive_SetTrainingSampleSize(VFS_DWORD dwSize);
+VFS_DWORD VFS_Archive_GetTrainingSampleSize();
+
+// The Size of the Cache holding the most recently used decoded Solid Blocks (4M by default; 0 disables the Cache).
+VFS_BOOL VFS_Archive_SetBlockCacheSize(VFS_DWORD dwSize);
+VFS_DWORD VFS_Archive_GetBlockCacheSize();
+
+///////////////////////////////////////////////////////////////////////////////
+// The Access Trace Interface (a trace lists the files opened while recording, each at its first open, with their absolute names; it can be passed to the archive builder as the access order. VFS_Trace_Prefetch() looks up the files of a trace and reads their raw data ahead in a background thread, so the operating system has it cached when the files are opened; a new call and VFS_Shutdown() stop the previous prefetching).
+///////////////////////////////////////////////////////////////////////////////
+// Start / Stop Recording (starting clears the Trace).
+VFS_BOOL VFS_Trace_Start();
+VFS_BOOL VFS_Trace_Stop();
+VFS_BOOL VFS_Trace_IsRecording();
+
+// Get / Save / Load a Trace (Trace Files contain one File Name per Line).
+VFS_BOOL VFS_Trace_GetFiles(VFS_FileNameList & Files);
+VFS_BOOL VFS_Trace_Save(const VFS_String & strTraceFileName);
+VFS_BOOL VFS_Trace_Load(const VFS_String & strTraceFileName, VFS_FileNameList & Files);
+
+// Prefetch the Files of a Trace (Files which can't be found are skipped) / wait until the Prefetching is done.
+VFS_BOOL VFS_Trace_Prefetch(const VFS_FileNameList & Files);
+VFS_BOOL VFS_Trace_WaitForPrefetch();
+
 ///////////////////////////////////////////////////////////////////////////////
 // The Directory Interface (You can only create/delete standard directories in the first root path. You can't manipulate Dirs in Archives).
 ///////////////////////////////////////////////////////////////////////////////
 // Directory Management.
 VFS_BOOL VFS_Dir_Create(const VFS_String & strDirName, VFS_BOOL bRecursive = VFS_FALSE);	// Recursive mode would create a directory c:alphabeta even if alpha doesn't exist.
 VFS_BOOL VFS_Dir_Delete(const VFS_String & strDirName, VFS_BOOL bRecursive = VFS_FALSE);	// Recursive mode would delete a directory c:alpha even if it contains files and/or subdirectories.
+VFS_BOOL VFS_Dir_Move(const VFS_String & strFrom, const VFS_String & strTo);	// Moves the whole Tree (the Target is relative to the first root path and mustn't exist yet).
 
 // Information.
 VFS_BOOL VFS_Dir_Exists(const VFS_String & strDirName);
 VFS_BOOL VFS_Dir_GetInfo(const VFS_String & strDirName, VFS_EntityInfo & Info);
 
-// Iterate a Directory and call the iteration procedure for each 
+// Iterate a Directory and call the iteration procedure for each Entry (see VFS_DirIterator for an Iterator which doesn't build a VFS_EntityInfo per Entry).
 VFS_BOOL VFS_Dir_Iterate(const VFS_String & strDirName, VFS_DirIterationProc pIterationProc, VFS_BOOL bRecursive = VFS_FALSE, void *pParam = NULL);
 
 // Get the Contents of a Directory.
@@ -245,11 +571,11 @@ VFS_BOOL VFS_Dir_GetContents(const VFS_String & strDirName, VFS_EntityInfoList &
 // The Utility Interface (You may call the File Name Management Functions even if the VFS isn't initialized yet).
 ///////////////////////////////////////////////////////////////////////////////
 // File Name Management Functions.
-VFS_BOOL VFS_Util_GetPath(const VFS_String & strFileName, VFS_String & strPath);
-VFS_BOOL VFS_Util_GetName(const VFS_String & strFileName, VFS_String & strName);
-VFS_BOOL VFS_Util_GetBaseName(const VFS_String & strFileName, VFS_String & strBaseName);
-VFS_BOOL VFS_Util_GetExtension(const VFS_String & strFileName, VFS_String & strExtension);
-VFS_BOOL VFS_Util_IsAbsoluteFileName(const VFS_String & strFileName);
+VFS_BOOL VFS_Util_GetPath(VFS_StringView strFileName, VFS_String & strPath);
+VFS_BOOL VFS_Util_GetName(VFS_StringView strFileName, VFS_String & strName);
+VFS_BOOL VFS_Util_GetBaseName(VFS_StringView strFileName, VFS_String & strBaseName);
+VFS_BOOL VFS_Util_GetExtension(VFS_StringView strFileName, VFS_String & strExtension);
+VFS_BOOL VFS_Util_IsAbsoluteFileName(VFS_StringView strFileName);
 
 //============================================================================
 //    INTERFACE OBJECT CLASS DEFINITIONS
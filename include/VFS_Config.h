@@ -29,6 +29,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <string_view>
 #include <cstring>
 
 //============================================================================
@@ -38,6 +39,8 @@
 
 #	include <windows.h>
 #	include <io.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
 #	if defined( _MSC_VER )
 #		pragma comment( lib, "vfs.lib" )
 #		pragma warning( disable : 4311 )
@@ -57,8 +60,24 @@
 #	define VFS_EXISTS( strAbsoluteFileName )			( ( GetFileAttributesW( ( strAbsoluteFileName ).c_str() ) != 0xFFFFFFFF ) ? VFS_TRUE : VFS_FALSE )
 #	define VFS_IS_DIR( strAbsoluteDirName )				( ( GetFileAttributesW( ( strAbsoluteDirName ).c_str() ) != 0xFFFFFFFF && ( GetFileAttributesW( strAbsoluteDirName.c_str() ) & FILE_ATTRIBUTE_DIRECTORY ) == FILE_ATTRIBUTE_DIRECTORY ) ? VFS_TRUE : VFS_FALSE )
 #	define VFS_FOPEN( strAbsoluteFileName, strAccess )	( _wfopen( ( strAbsoluteFileName ).c_str(), ( strAccess ).c_str() ) )
-#	define VFS_RESIZE( pFile, lSize )					( ( _chsize( m_pFile->_file, lSize ) == 0 ) ? VFS_TRUE : VFS_FALSE )
-#	define VFS_GETSIZE( pFile )							( _filelength( m_pFile->_file ) )
+#	define VFS_RESIZE( nFile, lSize )					( ( _chsize_s( nFile, lSize ) == 0 ) ? VFS_TRUE : VFS_FALSE )
+#	define VFS_GETSIZE( nFile )							( _filelengthi64( nFile ) )
+#	define VFS_PREALLOCATE( nFile, lSize )				( VFS_TRUE )
+#	define VFS_COPY_FILE_RANGE( nFrom, plFrom, nTo, plTo, dwBytes )	( errno = ENOSYS, -1 )
+#	define VFS_SENDFILE( nFrom, plFrom, nTo, dwBytes )	( errno = ENOSYS, -1 )
+#	define VFS_PREFETCH( nFile, lOffset, lSize )		( VFS_FALSE )
+#	define VFS_SEEK( nFile, lOffset )					( _lseeki64( nFile, lOffset, SEEK_SET ) )
+#	define VFS_SEEK_DATA( nFile, lOffset )				( lOffset )
+#	define VFS_SEEK_HOLE( nFile, lOffset )				( VFS_GETSIZE( nFile ) )
+#	define VFS_INVALID_FD								( -1 )
+#	define VFS_OPEN_NOATIME								0
+#	define VFS_OPEN_READ								( _O_RDONLY )
+#	define VFS_OPEN_READ_WRITE							( _O_RDWR )
+#	define VFS_OPEN_CREATE								( _O_RDWR | _O_CREAT | _O_TRUNC )
+#	define VFS_OPEN( strAbsoluteFileName, nFlags )		( _wopen( ( strAbsoluteFileName ).c_str(), ( nFlags ) | _O_BINARY | _O_NOINHERIT, _S_IREAD | _S_IWRITE ) )
+#	define VFS_CLOSE( nFile )							( _close( nFile ) )
+#	define VFS_PREAD( nFile, pBuffer, dwBytes, lOffset )	( _lseeki64( nFile, lOffset, SEEK_SET ) < 0 ? -1 : _read( nFile, pBuffer, dwBytes ) )
+#	define VFS_PWRITE( nFile, pBuffer, dwBytes, lOffset )	( _lseeki64( nFile, lOffset, SEEK_SET ) < 0 ? -1 : _write( nFile, pBuffer, dwBytes ) )
 
 //============================================================================
 //    INTERFACE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
@@ -71,6 +90,8 @@ typedef unsigned long VFS_DWORD;
 typedef int VFS_INT;
 typedef unsigned int VFS_UINT;
 typedef long VFS_LONG;
+typedef unsigned long long VFS_QWORD;
+typedef __int64 VFS_FileOffset;
 
 // Numeric Macros.
 static const VFS_BOOL VFS_TRUE = true;
@@ -81,6 +102,7 @@ typedef wchar_t VFS_CHAR;
 typedef wchar_t *VFS_PSTR;
 typedef const wchar_t *VFS_PCSTR;
 typedef std::wstring VFS_String;
+typedef std::wstring_view VFS_StringView;
 
 // String Macros.
 #define VFS_TEXT( string )			L ## string
@@ -105,9 +127,11 @@ typedef std::wstring VFS_String;
 //============================================================================
 //    INTERFACE FUNCTION PROTOTYPES
 //============================================================================
-inline VFS_BOOL VFS_FIND_FILE(const VFS_String & strAbsoluteFileName, VFS_String & strFoundName, VFS_BOOL & bIsDir, VFS_LONG & lSize, VFS_INT nMode)
+// The State of a Directory Search (owned by the Caller, so Searches may be nested or run on several Threads).
+typedef HANDLE VFS_FindHandle;
+
+inline VFS_BOOL VFS_FIND_FILE(VFS_FindHandle & hFindFile, const VFS_String & strAbsoluteFileName, VFS_String & strFoundName, VFS_BOOL & bIsDir, VFS_LONG & lSize, VFS_INT nMode)
 {
-    static HANDLE hFindFile = NULL;
     WIN32_FIND_DATAW wfd;
     if (nMode == 0) {
 	if ((hFindFile = FindFirstFileW(strAbsoluteFileName.c_str(), &wfd)) == INVALID_HANDLE_VALUE)
@@ -148,12 +172,17 @@ inline VFS_BOOL VFS_FIND_FILE(const VFS_String & strAbsoluteFileName, VFS_String
 #       include <sys/stat.h>
 #       include <sys/types.h>
 #       include <unistd.h>
+#       include <fcntl.h>
+#       if defined( __linux__ )
+#               include <sys/sendfile.h>
+#       endif
 #	if defined( _MSC_VER )
 #		if defined( _DEBUG ) || defined (DEBUG)
 #			define VFS_DEBUG
 #		endif
 #	endif
 typedef std::string VFS_String;
+typedef std::string_view VFS_StringView;
 //============================================================================
 //    PLATFORM-DEPENDANT FUNCTIONS
 //============================================================================
@@ -167,7 +196,7 @@ typedef std::string VFS_String;
 static struct stat stat_buffer;
 #define VFS_EXISTS( strAbsoluteFileName ) ( ( stat( ( strAbsoluteFileName ).c_str(),&stat_buffer ) == 0 ) ? VFS_TRUE : VFS_FALSE )
 
-bool isdir(VFS_String target)
+inline bool isdir(VFS_String target)
 {
         struct stat buff;
         if(!stat(target.c_str(),&buff))
@@ -178,19 +207,84 @@ bool isdir(VFS_String target)
         }
         return false;
 }
-long long getsize(FILE* target)
-{  
-                fseek(target,0,SEEK_END);
-                return ftell(target);
+inline long long getsize(int target)
+{
+        struct stat buff;
+        if(fstat(target,&buff))
+                return -1;
+        return buff.st_size;
 }
 
 #define VFS_IS_DIR( strAbsoluteDirName ) ( ( isdir((strAbsoluteDirName))) ? VFS_TRUE : VFS_FALSE )
 
 #define VFS_FOPEN( strAbsoluteFileName, strAccess ) ( fopen( ( strAbsoluteFileName ).c_str(), ( strAccess ).c_str() ) )
 
-#define VFS_RESIZE( pFile, lSize ) ( ( chsize( m_pFile->_file, lSize ) == 0 ) ? VFS_TRUE : VFS_FALSE )
+#define VFS_RESIZE( nFile, lSize ) ( ( ftruncate( nFile, lSize ) == 0 ) ? VFS_TRUE : VFS_FALSE )
+
+#define VFS_GETSIZE( nFile ) ( getsize( nFile ) )
+
+// Reserve Space without changing the Size (only a Hint, so File Systems without Support for it don't fail).
+#if defined( __linux__ ) && defined( FALLOC_FL_KEEP_SIZE )
+#define VFS_PREALLOCATE( nFile, lSize ) ( ( fallocate( nFile, FALLOC_FL_KEEP_SIZE, 0, lSize ) == 0 || errno == EOPNOTSUPP || errno == ENOSYS ) ? VFS_TRUE : VFS_FALSE )
+#else
+#define VFS_PREALLOCATE( nFile, lSize ) ( VFS_TRUE )
+#endif
+
+// Copy Data inside the Kernel (the Offsets are Pointers to VFS_FileOffset Variables which are advanced; sendfile() writes at the Position of the Target).
+#if defined( __linux__ )
+typedef loff_t VFS_FileOffset;
+#if defined( __GLIBC__ ) && ( __GLIBC__ > 2 || ( __GLIBC__ == 2 && __GLIBC_MINOR__ >= 27 ) )
+#define VFS_COPY_FILE_RANGE( nFrom, plFrom, nTo, plTo, dwBytes ) ( copy_file_range( nFrom, plFrom, nTo, plTo, dwBytes, 0 ) )
+#else
+#define VFS_COPY_FILE_RANGE( nFrom, plFrom, nTo, plTo, dwBytes ) ( errno = ENOSYS, -1 )
+#endif
+#define VFS_SENDFILE( nFrom, plFrom, nTo, dwBytes ) ( sendfile( nTo, nFrom, ( off_t* )( plFrom ), dwBytes ) )
+#else
+typedef off_t VFS_FileOffset;
+#define VFS_COPY_FILE_RANGE( nFrom, plFrom, nTo, plTo, dwBytes ) ( errno = ENOSYS, -1 )
+#define VFS_SENDFILE( nFrom, plFrom, nTo, dwBytes ) ( errno = ENOSYS, -1 )
+#endif
+
+// Ask the Kernel to read a Range ahead (only a Hint; if the Platform can't do it, the Range has to be read instead).
+#if defined( POSIX_FADV_WILLNEED )
+#define VFS_PREFETCH( nFile, lOffset, lSize ) ( ( posix_fadvise( nFile, lOffset, lSize, POSIX_FADV_WILLNEED ) == 0 ) ? VFS_TRUE : VFS_FALSE )
+#else
+#define VFS_PREFETCH( nFile, lOffset, lSize ) ( VFS_FALSE )
+#endif
+
+#define VFS_SEEK( nFile, lOffset ) ( lseek( nFile, lOffset, SEEK_SET ) )
+
+// Find the next Data / Hole Region (without Support for sparse Files, everything up to the End is Data).
+#if defined( SEEK_DATA ) && defined( SEEK_HOLE )
+#define VFS_SEEK_DATA( nFile, lOffset ) ( lseek( nFile, lOffset, SEEK_DATA ) )
+#define VFS_SEEK_HOLE( nFile, lOffset ) ( lseek( nFile, lOffset, SEEK_HOLE ) )
+#else
+#define VFS_SEEK_DATA( nFile, lOffset ) ( lOffset )
+#define VFS_SEEK_HOLE( nFile, lOffset ) ( getsize( nFile ) )
+#endif
+
+// Raw File Descriptors (the Files are never inherited by Child Processes; reading doesn't update the Access Time if we may suppress it).
+#define VFS_INVALID_FD ( -1 )
+
+#ifdef O_NOATIME
+#define VFS_OPEN_NOATIME O_NOATIME
+#else
+#define VFS_OPEN_NOATIME 0
+#endif
+
+#define VFS_OPEN_READ ( O_RDONLY )
+
+#define VFS_OPEN_READ_WRITE ( O_RDWR )
+
+#define VFS_OPEN_CREATE ( O_RDWR | O_CREAT | O_TRUNC )
+
+#define VFS_OPEN( strAbsoluteFileName, nFlags ) ( open( ( strAbsoluteFileName ).c_str(), ( nFlags ) | O_CLOEXEC, 0666 ) )
+
+#define VFS_CLOSE( nFile ) ( close( nFile ) )
 
-#define VFS_GETSIZE( pFile ) ( getsize( pFile) )
+#define VFS_PREAD( nFile, pBuffer, dwBytes, lOffset ) ( pread( nFile, pBuffer, dwBytes, lOffset ) )
+
+#define VFS_PWRITE( nFile, pBuffer, dwBytes, lOffset ) ( pwrite( nFile, pBuffer, dwBytes, lOffset ) )
 
 //============================================================================
 //    INTERFACE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
@@ -203,6 +297,7 @@ typedef unsigned long VFS_DWORD;
 typedef int VFS_INT;
 typedef unsigned int VFS_UINT;
 typedef long VFS_LONG;
+typedef unsigned long long VFS_QWORD;
 
 // Numeric Macros.
 static const VFS_BOOL VFS_TRUE = true;
@@ -237,27 +332,37 @@ typedef void* HANDLE;
 //============================================================================
 //    INTERFACE FUNCTION PROTOTYPES
 //============================================================================
-inline VFS_BOOL VFS_FIND_FILE(const VFS_String & strAbsoluteFileName, VFS_String & strFoundName, VFS_BOOL & bIsDir, VFS_LONG & lSize, VFS_INT nMode)
+// The State of a Directory Search (owned by the Caller, so Searches may be nested or run on several Threads).
+typedef DIR *VFS_FindHandle;
+
+inline VFS_BOOL VFS_FIND_FILE(VFS_FindHandle & pFindDir, const VFS_String & strAbsoluteFileName, VFS_String & strFoundName, VFS_BOOL & bIsDir, VFS_LONG & lSize, VFS_INT nMode)
 {
-    /*static HANDLE hFindFile = NULL;
-    WIN32_FIND_DATAW wfd;
+    struct dirent *pEntry;
+    struct stat buff;
     if (nMode == 0) {
-	if ((hFindFile = FindFirstFileW(strAbsoluteFileName.c_str(), &wfd)) == INVALID_HANDLE_VALUE)
+	// Strip the Wildcard.
+	VFS_String strDir = strAbsoluteFileName.substr(0, strAbsoluteFileName.rfind('/') + 1);
+	if ((pFindDir = opendir(strDir.c_str())) == NULL)
 	    return VFS_FALSE;
-	strFoundName = wfd.cFileName;
-	bIsDir = (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY;
-	lSize = wfd.nFileSizeLow;
-	return VFS_TRUE;
-    } else if (nMode == 1) {
-	if (!FindNextFileW(hFindFile, &wfd))
+	nMode = 1;
+    }
+    if (nMode == 1) {
+	if ((pEntry = readdir(pFindDir)) == NULL)
 	    return VFS_FALSE;
-	strFoundName = wfd.cFileName;
-	bIsDir = (wfd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == FILE_ATTRIBUTE_DIRECTORY;
-	lSize = wfd.nFileSizeLow;
+	strFoundName = pEntry->d_name;
+	if (fstatat(dirfd(pFindDir), pEntry->d_name, &buff, 0) != 0) {
+	    bIsDir = VFS_FALSE;
+	    lSize = 0;
+	} else {
+	    bIsDir = S_ISDIR(buff.st_mode) ? VFS_TRUE : VFS_FALSE;
+	    lSize = (VFS_LONG) buff.st_size;
+	}
 	return VFS_TRUE;
     } else if (nMode == 2) {
-	return FindClose(hFindFile) ? VFS_TRUE : VFS_FALSE;
-    }*/
+	VFS_BOOL bResult = closedir(pFindDir) == 0 ? VFS_TRUE : VFS_FALSE;
+	pFindDir = NULL;
+	return bResult;
+    }
     return VFS_FALSE;
 }
 
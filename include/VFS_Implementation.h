@@ -27,6 +27,8 @@
 #include <vector>
 #include <map>
 #include <algorithm>
+#include <atomic>
+#include <memory>
 using namespace std;
 
 //============================================================================
@@ -35,18 +37,69 @@ using namespace std;
 // The Archive ID.
 static const VFS_BYTE ARCHIVE_ID[4] = { 'V', 'F', 'S', '1' };
 
-// The File Copy Chunk Size (at the moment 10K). Feel free to modify it to a better value.
-static const VFS_DWORD FILE_COPY_CHUNK_SIZE = 10 * 1024;
+// The Archive Format Versions (Archives are always written in the latest Version, older ones can still be read).
+static const VFS_WORD ARCHIVE_VERSION_1_0 = VFS_MAKE_WORD(0, 1);	// The original Format.
+static const VFS_WORD ARCHIVE_VERSION_1_1 = VFS_MAKE_WORD(1, 1);	// Adds the Checksums.
+static const VFS_WORD ARCHIVE_VERSION_1_2 = VFS_MAKE_WORD(2, 1);	// Adds the Solid Blocks.
+static const VFS_WORD ARCHIVE_VERSION_1_3 = VFS_MAKE_WORD(3, 1);	// Adds the Filter Configuration Data Sizes.
+static const VFS_WORD ARCHIVE_VERSION_1_4 = VFS_MAKE_WORD(4, 1);	// Adds the inline Files.
+static const VFS_WORD ARCHIVE_VERSION_1_5 = VFS_MAKE_WORD(5, 1);	// Orders the File Records by their Dirs.
+static const VFS_WORD ARCHIVE_VERSION = ARCHIVE_VERSION_1_5;
+
+// The Size of the Buffer used for Copies the Kernel can't do for us (allocated per Copy).
+static const VFS_DWORD FILE_COPY_BUFFER_SIZE = 1024 * 1024;
+
+// The maximum Amount of Data copied by a single Kernel Call.
+static const VFS_DWORD FILE_COPY_KERNEL_CHUNK_SIZE = 1024 * 1024 * 1024;
 
 // Parent = Root Directory (which hasn't an Entry).
 static const VFS_DWORD DIR_INDEX_ROOT = 0xFFFFFFFF;
 
+// The File isn't in a Solid Block (its Data is stored on its own) / the File is stored in the Index.
+static const VFS_DWORD BLOCK_INDEX_NONE = 0xFFFFFFFF;
+static const VFS_DWORD BLOCK_INDEX_INLINE = 0xFFFFFFFE;
+
+// The Hash Map used for all Name Lookups (see below).
+template < class TValue > class CHashMap;
+
 // A Filter Name->Filter Point Map.
-typedef map < VFS_String, VFS_Filter * >FilterMap;
+typedef CHashMap < VFS_Filter * >FilterMap;
 
 // Map Types.
-typedef map < VFS_String, class CArchive * >ArchiveMap;	// Absolute Archive File Name -> Archive Pointer.
-typedef map < VFS_String, class IFile * >FileMap;	// Absolute File Name -> File Pointer.
+typedef CHashMap < class CArchive * >ArchiveMap;	// Absolute Archive File Name -> Archive Pointer.
+typedef CHashMap < class IFile * >FileMap;	// Absolute File Name -> File Pointer.
+
+// The Statistics Counters (see VFS_GetStats()).
+enum StatCounter {
+    STAT_STDIO_FILE_OPENS,
+    STAT_ARCHIVE_FILE_OPENS,
+    STAT_BYTES_READ,
+    STAT_BYTES_WRITTEN,
+    STAT_BYTES_DECODED,
+    STAT_DECODE_NANOSECONDS,
+    STAT_ARCHIVE_PARSES,
+    STAT_ROOT_PATH_PROBES,
+    STAT_SYSCALLS,
+    STAT_BYTES_VERIFIED,
+    STAT_CHECKSUM_MISMATCHES,
+    STAT_BYTES_PREFETCHED,
+    STAT_BLOCK_CACHE_HITS,
+    STAT_BLOCK_CACHE_MISSES,
+    STAT_ARCHIVE_DIR_LOADS,
+    STAT_ARCHIVE_EVICTIONS,
+    NUM_STAT_COUNTERS
+};
+
+// The Latency Histogram Layout: values below 2^LATENCY_SUB_BUCKET_BITS Nanoseconds get their own Bucket, every
+// higher Power of Two is split into 2^LATENCY_SUB_BUCKET_BITS Buckets (i.e. the Error is at most 12.5%).
+static const VFS_DWORD LATENCY_SUB_BUCKET_BITS = 3;
+static const VFS_DWORD LATENCY_SUB_BUCKETS = 1 << LATENCY_SUB_BUCKET_BITS;
+static const VFS_DWORD LATENCY_MAX_EXPONENT = 40;	// ~18 Minutes; everything above goes to the last Bucket.
+static const VFS_DWORD NUM_LATENCY_BUCKETS = LATENCY_SUB_BUCKETS + ( LATENCY_MAX_EXPONENT - LATENCY_SUB_BUCKET_BITS + 1 ) * LATENCY_SUB_BUCKETS;
+
+// Each Operation has its Buckets followed by the Sum of all Latencies.
+static const VFS_DWORD LATENCY_SLOTS_PER_OPERATION = NUM_LATENCY_BUCKETS + 1;
+static const VFS_DWORD NUM_LATENCY_SLOTS = VFS_NUM_OPERATIONS * LATENCY_SLOTS_PER_OPERATION;
 
 //============================================================================
 //    INTERFACE CLASS PROTOTYPES / EXTERNAL CLASS REFERENCES
@@ -54,6 +107,81 @@ typedef map < VFS_String, class IFile * >FileMap;	// Absolute File Name -> File
 //============================================================================
 //    INTERFACE STRUCTURES / UTILITY CLASSES
 //============================================================================
+// --- Hash Map ---
+// A flat Hash Map from Names (compared ignoring the Case) to Values. The Entries are stored densely in Insertion Order
+// (erasing an Entry moves the last one into the Gap), the Slots are probed linearly and hold the full Hash, so a Lookup
+// usually touches one Cache Line of Slots and one Entry. Lookups take a View and optionally a precomputed HashPath().
+// Small Maps which have to be ordered by Name (like the Filter Map) use insert_sorted() and erase_stable() instead, which
+// keep the Entries sorted at O(n) per Call.
+template < class TValue > class CHashMap {
+  public:
+    typedef pair < VFS_String, TValue > value_type;
+    typedef typename vector < value_type >::iterator iterator;
+    typedef typename vector < value_type >::const_iterator const_iterator;
+    typedef typename vector < value_type >::size_type size_type;
+
+  private:
+    struct Slot {
+	VFS_QWORD qwHash;
+	VFS_DWORD dwEntry;	// The Index of the Entry + 1 (0 means the Slot is empty).
+    };
+
+    vector < value_type > m_Entries;
+    vector < Slot > m_Slots;
+
+    // Find the Slot holding a Key (or the empty Slot where it would be inserted) / the Slot of an Entry.
+    size_type FindSlot(VFS_StringView strKey, VFS_QWORD qwHash) const;
+    size_type FindEntrySlot(size_type nEntry) const;
+
+    // Rebuild the Slots with the specified (Power of Two) Size / from the Entries (after the Entries were moved).
+    void Rehash(size_type nSlots);
+    void Reindex();
+
+  public:
+    // Iteration (in Insertion Order as long as nothing is erased, or in Key Order if only the sorted Functions are used).
+    iterator begin() {
+	return m_Entries.begin();
+    }
+    iterator end() {
+	return m_Entries.end();
+    }
+    const_iterator begin() const {
+	return m_Entries.begin();
+    }
+    const_iterator end() const {
+	return m_Entries.end();
+    }
+
+    // Size.
+    size_type size() const {
+	return m_Entries.size();
+    }
+    VFS_BOOL empty() const {
+	return m_Entries.empty();
+    }
+    void clear() {
+	m_Entries.clear();
+	m_Slots.clear();
+    }
+    void reserve(size_type nEntries);
+
+    // Lookup.
+    iterator find(VFS_StringView strKey);
+    iterator find(VFS_StringView strKey, VFS_QWORD qwHash);
+    const_iterator find(VFS_StringView strKey) const;
+    const_iterator find(VFS_StringView strKey, VFS_QWORD qwHash) const;
+    TValue & operator[](VFS_StringView strKey);
+
+    // Insertion / Removal (Insertions invalidate all Iterators, erasing invalidates the Iterators to the last Entry).
+    pair < iterator, bool >insert(const value_type & Value);
+    iterator erase(iterator iter);
+    size_type erase(VFS_StringView strKey);
+
+    // Order-preserving Insertion (before the first Entry with a greater Key) / Removal (Both invalidate all Iterators).
+    pair < iterator, bool >insert_sorted(const value_type & Value);
+    iterator erase_stable(iterator iter);
+};
+
 // --- The File Structures ---
 // The Archive Header.
 #pragma pack( push, 1 )
@@ -65,7 +193,44 @@ struct ARCHIVE_HEADER {
     VFS_DWORD dwNumFiles;
 };
 
-// The Filter Structure.
+// The Checksums (Version 1.1 and above; follows the Header). The Index Checksum covers the Filter, Dir and File Records and
+// the File Checksums, which follow the File Records (one CRC32C of the stored, i.e. encoded, Data per File).
+struct ARCHIVE_CHECKSUMS {
+    VFS_DWORD dwIndexChecksum;
+};
+
+// The Solid Blocks (Version 1.2 and above; follows the Checksums). Small Files may be grouped into Solid Blocks which are
+// filtered as a whole; the Block Records follow the File Checksums and, if there are any Blocks, one File Block Record per
+// File follows them (both are covered by the Index Checksum). The Data of a Block is stored where the Data of its first
+// Member would be; Members have no Data of their own (their Compressed Size is 0 and their Checksum is the one of their
+// unfiltered Data).
+struct ARCHIVE_BLOCKS {
+    VFS_DWORD dwNumBlocks;
+};
+
+// The inline Files (Version 1.4 and above; follows the Solid Blocks). Tiny Files may be stored unfiltered in the Index: their
+// Data follows the File Block Records, which are there if there are Blocks or inline Files (an inline File has BLOCK_INDEX_INLINE
+// as Block Index and the Offset of its Data as Block Offset). Like Members of Blocks, inline Files have no Data of their own.
+struct ARCHIVE_INLINE_FILES {
+    VFS_DWORD dwNumFiles;
+    VFS_DWORD dwDataSize;
+};
+
+// The Block Structure (the Checksum is the one of the stored Data).
+struct ARCHIVE_BLOCK {
+    VFS_DWORD dwCompressedSize;
+    VFS_DWORD dwUncompressedSize;
+    VFS_DWORD dwChecksum;
+};
+
+// The File Block Structure (the Block of the File or BLOCK_INDEX_NONE and the Offset of its Data in the unfiltered Block).
+struct ARCHIVE_FILE_BLOCK {
+    VFS_DWORD dwBlockIndex;
+    VFS_DWORD dwBlockOffset;
+};
+
+// The Filter Structure (Version 1.3 and above: the Sizes of the Configuration Data of the Filters follow the Filter Records,
+// one VFS_DWORD per Filter, since trained Filters have Configuration Data of varying Size; they are covered by the Index Checksum).
 struct ARCHIVE_FILTER {
     VFS_CHAR szName[VFS_MAX_NAME_LENGTH];
 };
@@ -76,6 +241,18 @@ struct ARCHIVE_DIR {
     VFS_DWORD dwParentIndex;
 };
 
+// The Files of a Dir (Version 1.5 and above). One Record per Dir follows the Dir Records (the one of the Root Directory comes
+// last), the File Records, the File Checksums and the File Block Records are ordered by Dir in the same Way, so the Files of a
+// Dir can be loaded on their own. Since the File Data isn't ordered like that, the File Block Records are always there and a
+// File with Data of its own has the Offset of its Data in the Archive File as Block Offset; the Data Offsets of the Blocks
+// follow the Block Records (one VFS_DWORD per Block). The Checksum covers the File Records, the File Checksums and the File
+// Block Records of the Dir (in this Order), the Index Checksum covers everything else.
+struct ARCHIVE_DIR_FILES {
+    VFS_DWORD dwFirstFile;
+    VFS_DWORD dwNumFiles;
+    VFS_DWORD dwChecksum;
+};
+
 // The File Structure.
 struct ARCHIVE_FILE {
     VFS_CHAR szName[VFS_MAX_NAME_LENGTH];
@@ -92,39 +269,107 @@ struct ArchiveDir {
     VFS_String strName;
     VFS_DWORD dwParentDirIndex;
 };
-typedef map < VFS_String, VFS_DWORD > ArchiveDirMap;	// Absolute (!) Dir Name -> Dir Index.
+typedef CHashMap < VFS_DWORD > ArchiveDirMap;	// Absolute (!) Dir Name -> Dir Index.
 typedef vector < ArchiveDir > ArchiveDirList;
 
+// Members of Solid Blocks have their Offset in the unfiltered Block as Data Offset (and their Size as Compressed Size), inline
+// Files the Offset in the inline Data.
 struct ArchiveFile {
     VFS_String strName;
     VFS_DWORD dwDirIndex;
     VFS_DWORD dwDataOffset;
     VFS_DWORD dwCompressedSize;
     VFS_DWORD dwUncompressedSize;
+    VFS_DWORD dwChecksum;
+    VFS_DWORD dwBlockIndex;
 };
-typedef map < VFS_String, VFS_DWORD > ArchiveFileMap;	// Absolute (!) File Name -> File Index.
+typedef CHashMap < VFS_DWORD > ArchiveFileMap;	// Absolute (!) File Name -> File Index (in the Order of the Dir Files Table).
 typedef vector < ArchiveFile > ArchiveFileList;
 
+struct ArchiveBlock {
+    VFS_DWORD dwDataOffset;
+    VFS_DWORD dwCompressedSize;
+    VFS_DWORD dwUncompressedSize;
+    VFS_DWORD dwChecksum;
+};
+typedef vector < ArchiveBlock > ArchiveBlockList;
+
+// A decoded Solid Block (shared by the Block Cache and its Readers).
+typedef shared_ptr < const vector < VFS_BYTE > > DecodedBlock;
+
 struct ArchiveHeader {
     FilterList Filters;
+    vector < VFS_DWORD > FilterConfigSizes;
     ArchiveDirList Dirs;
     ArchiveDirMap DirHash;
-    ArchiveFileList Files;
-    ArchiveFileMap FileHash;
+    vector < ARCHIVE_DIR_FILES > DirFiles;	// The Files of each Dir (the Root Directory's come last).
+    vector < VFS_DWORD > SubdirOffsets;	// The Subdirs of the Dir in Slot i (as in the Dir Files Table) are Subdirs[ SubdirOffsets[ i ] ] up to Subdirs[ SubdirOffsets[ i + 1 ] ].
+    vector < VFS_DWORD > Subdirs;
+    ArchiveBlockList Blocks;
+    vector < VFS_BYTE > InlineData;
+    VFS_DWORD dwNumFiles;
     VFS_DWORD dwDataOffset;
     VFS_DWORD dwFileDataOffset;
+    VFS_DWORD dwFilesOffset;	// Version 1.5 and above: the Offset of the File Records / the File Block Records.
+    VFS_DWORD dwFileBlocksOffset;
+    VFS_BOOL bChecksums;
+    VFS_BOOL bByDir;	// Version 1.5 and above: the Files of a Dir are loaded when they're needed first.
+};
+
+// --- Statistics ---
+// The Statistics Counters of a single Thread (only the owning Thread writes them, so no locked Operations are needed).
+struct StatBlock {
+    atomic < VFS_QWORD > Counters[NUM_STAT_COUNTERS];
+
+    // The Latency Histograms (allocated on the Heap since they are rather big).
+    atomic < VFS_QWORD > *pLatencies;
+};
+
+// Measures the Latency of an Operation from its Construction to its Destruction.
+class COperationTimer {
+    VFS_Operation m_eOperation;
+    VFS_QWORD m_qwStart;
+
+  public:
+    COperationTimer(VFS_Operation eOperation);
+    ~COperationTimer();
 };
 
 // --- Classes for Archive Access ---
+class CStdIOFile;
 class CArchive {
     VFS_String m_strFileName;
     VFS_Handle m_hFile;
     ArchiveHeader m_Header;
     static CArchive *m_pActive;
 
+    // The Number of References (open Files and Directory Iterators) and the Time of the last Use (a Tick of the Use Clock; the
+    // Archive Cache closes the least recently used unreferenced Archives first).
+    mutable VFS_DWORD m_dwRefCount;
+    mutable VFS_QWORD m_qwLastUse;
+    static VFS_QWORD m_qwUseClock;
+
+    // The Files of each Dir (in the Order of the Dir Files Table; the List of a Dir is empty until its Files are loaded).
+    mutable vector < ArchiveFileList > m_Files;
+    mutable ArchiveFileMap m_FileHash;
+
+    // Has the Checksum of a File been verified yet (one Byte per File, so the Extraction Threads never share a Flag)?
+    mutable vector < VFS_BYTE > m_Verified;
+
     // Parse the Archive.
     VFS_BOOL Parse();
 
+    // The Slot of a Dir in the Dir Files Table / the Index of a File.
+    VFS_DWORD GetDirSlot(VFS_DWORD dwDirIndex) const;
+    VFS_DWORD GetFileIndex(const ArchiveFile & File) const;
+    const ArchiveFile *GetFileByIndex(VFS_DWORD dwIndex) const;
+
+    // Load the Files of a Dir / of the Dir of a File / of all Dirs (if they aren't loaded yet; a File in a Dir which doesn't
+    // exist simply isn't found afterwards).
+    VFS_BOOL LoadDir(VFS_DWORD dwSlot) const;
+    VFS_BOOL LoadDirOf(VFS_StringView strFileName) const;
+    VFS_BOOL LoadAllDirs() const;
+
   public:
     // Constructor / Destructor.
      CArchive(VFS_String strAbsoluteFileName);
@@ -145,22 +390,65 @@ class CArchive {
     // The Archive Header.
     const ArchiveHeader *GetHeader() const;
 
-    // Get the Reference Count (i.e. the Sum of the Reference Counts of all Open Files of this Archive).
+    // Reference Counting (an Archive isn't closed while it's referenced; Release() doesn't close it, VFS_Archive_Flush() and the
+    // Archive Cache do).
+    void AddRef() const;
+    void Release() const;
     VFS_DWORD GetRefCount() const;
 
+    // The Time of the last Use (Touch() makes this the most recently used Archive).
+    void Touch() const {
+	m_qwLastUse = ++m_qwUseClock;
+    } VFS_QWORD GetLastUse() const {
+	return m_qwLastUse;
+    }
+
+    // Unload the Files of all Dirs except for the Root Directory (they are loaded again when they're needed; Archives older than
+    // Version 1.5 keep their Files, they can't be loaded by Dir).
+    void UnloadDirs();
+
     // Directory Stuff.
-    VFS_BOOL ContainsDir(const VFS_String & strDirName) const;
-    VFS_BOOL IterateDir(const VFS_String & strDirName, VFS_DirIterationProc pIterationProc, VFS_BOOL bRecursive, void *pParam) const;
+    VFS_BOOL ContainsDir(VFS_StringView strDirName) const;
+
+    // Find a Dir (its Name is relative to the Archive, the Root Directory is "") / the Subdirs of a Dir (Dir Indices) / the Files
+    // of a Dir (NULL if they can't be loaded).
+    VFS_BOOL FindDir(VFS_StringView strDirName, VFS_DWORD & dwDirIndex) const;
+    const VFS_DWORD *GetSubdirs(VFS_DWORD dwDirIndex, VFS_DWORD & dwNumSubdirs) const;
+    const ArchiveFileList *GetDirFiles(VFS_DWORD dwDirIndex) const;
 
     // File Stuff.
-    VFS_BOOL ContainsFile(const VFS_String & strFileName) const;
-    const ArchiveFile *GetFile(const VFS_String & strFileName) const;
+    VFS_BOOL ContainsFile(VFS_StringView strFileName) const;
+    const ArchiveFile *GetFile(VFS_StringView strFileName) const;
+
+    // Checksum Verification (dwMode is one of the VFS_VERIFY_* Flags; VerifyFile() checks the stored Data of the File if the Mode requires it).
+    VFS_BOOL NeedsVerification(const ArchiveFile & File, VFS_DWORD dwMode) const;
+    VFS_BOOL VerifyFile(const ArchiveFile & File, const VFS_BYTE * pData, VFS_DWORD dwMode) const;
 
     // Extraction.
     VFS_BOOL Extract(const VFS_String & strTargetDir) const;
 
-    // Activation.
-    VFS_BOOL Activate();
+    // Extract a single File (reading from the specified Archive File; called by the Extraction Threads).
+    VFS_BOOL ExtractFile(IFile * pSource, VFS_DWORD dwIndex, const VFS_String & strTarget) const;
+
+    // Get the decoded Data of a File (the Archive must be active). Inline Files and Members of Solid Blocks are taken from the Index
+    // and from their decoded Block (which pBlock keeps alive), the others are read into the Buffer and decoded right there.
+    VFS_BOOL DecodeFile(IFile * pSource, const ArchiveFile & File, VFS_DWORD dwVerifyMode, vector < VFS_BYTE > &Buffer,
+			const VFS_BYTE * &pData, VFS_DWORD & dwSize, DecodedBlock & pBlock) const;
+
+    // Read the stored Data of a File which is neither inline nor in a Solid Block (dwCompressedSize Bytes; they are verified if the
+    // Mode requires it).
+    VFS_BOOL ReadStoredFile(IFile * pSource, const ArchiveFile & File, VFS_DWORD dwVerifyMode, VFS_BYTE * pBuffer) const;
+
+    // Get a decoded Solid Block (from the Block Cache if it's there, otherwise it's read from the specified Archive File).
+    DecodedBlock LoadBlock(IFile * pSource, VFS_DWORD dwIndex, VFS_DWORD dwVerifyMode) const;
+
+    // Run the Data in the From Buffer through the Filters (the Result is in the From Buffer again).
+    VFS_BOOL DecodeBuffer(const VFS_EntityInfo & Info) const;
+
+    // Activation (the Filter Data is read from the Archive File unless it's passed; Deactivate() makes the next Archive reload
+    // its Filter Data, e.g. after the Filters have been trained).
+    VFS_BOOL Activate(const VFS_BYTE * pConfigData = NULL);
+    static void Deactivate();
 
     // Open / Check the Existence of an Archive.
     static CArchive *Open(const VFS_String & strAbsoluteFileName);
@@ -216,6 +504,7 @@ class IFile {
 
     // Sizing.
     virtual VFS_BOOL Resize(VFS_LONG lSize) = 0;
+    virtual VFS_BOOL Preallocate(VFS_LONG lSize) = 0;
     virtual VFS_LONG GetSize() const = 0;
 
     // Information.
@@ -223,12 +512,33 @@ class IFile {
 };
 
 class CStdIOFile:public IFile {
-    FILE *m_pFile;
+    int m_nFile;
     VFS_BOOL m_bReadOnly;
 
+    // The Path the File was opened with (the File Name is lower-cased, the File System needn't ignore the Case).
+    VFS_String m_strPath;
+
+    // The Position and the Size (cached, so we don't need a Syscall for each Query).
+    VFS_LONG m_lPosition;
+    VFS_LONG m_lSize;
+
+    // The user-space Buffer (holds either Data read ahead or Data not written yet).
+    vector < VFS_BYTE > m_Buffer;
+    VFS_DWORD m_dwBufferSize;
+    VFS_LONG m_lBufferOffset;
+    VFS_DWORD m_dwBufferFill;
+    VFS_BOOL m_bBufferDirty;
+
+    // Raw positional Access.
+    VFS_BOOL ReadAt(VFS_BYTE * pBuffer, VFS_DWORD dwToRead, VFS_LONG lOffset, VFS_DWORD * pRead);
+    VFS_BOOL WriteAt(const VFS_BYTE * pBuffer, VFS_DWORD dwToWrite, VFS_LONG lOffset);
+
+    // Write the Buffer if it's dirty and drop it.
+    VFS_BOOL FlushBuffer();
+
   public:
     // Constructor / Destructor.
-     CStdIOFile(const VFS_String & strAbsoluteFileName, VFS_BOOL bOpen);
+     CStdIOFile(const VFS_String & strAbsoluteFileName, VFS_BOOL bOpen, VFS_DWORD dwFlags);
      virtual ~ CStdIOFile();
 
     // Is the File valid?
@@ -244,27 +554,44 @@ class CStdIOFile:public IFile {
 
     // Sizing.
     VFS_BOOL Resize(VFS_LONG lSize);
+    VFS_BOOL Preallocate(VFS_LONG lSize);
     VFS_LONG GetSize() const;
 
     // Information.
     VFS_BOOL IsArchived() const {
 	return VFS_FALSE;
     }
+    const VFS_String & GetPath() const {
+	return m_strPath;
+    }
     // Open / Create a StdIOFile.
     static IFile *Open(const VFS_String & strAbsoluteFileName, VFS_DWORD dwFlags);
     static IFile *Create(const VFS_String & strAbsoluteFileName, VFS_DWORD dwFlags);
     static VFS_BOOL Exists(const VFS_String & strAbsoluteFileName);
+
+    // Copy / Move a File by its Path (Moving falls back to Copying if the Target is on another Device).
+    static VFS_BOOL Copy(const VFS_String & strAbsoluteFrom, const VFS_String & strAbsoluteTo);
+    static VFS_BOOL Move(const VFS_String & strAbsoluteFrom, const VFS_String & strAbsoluteTo);
+
+    // Reopen a File which was opened for reading only for r/w Access.
+    VFS_BOOL MakeWritable();
+
+    // Copy a Range of this File into another one (inside the Kernel if possible) / Copy the whole File, preserving Holes.
+    VFS_BOOL CopyRange(CStdIOFile * pTarget, VFS_LONG lOffset, VFS_LONG lSize, VFS_LONG lTargetOffset);
+    VFS_BOOL CopyTo(CStdIOFile * pTarget);
+
+    // Have a Range of this File read ahead (by the Kernel if possible, otherwise it's read and thrown away).
+    VFS_BOOL Prefetch(VFS_LONG lOffset, VFS_LONG lSize);
 };
 
 class CArchiveFile:public IFile {
     const CArchive *m_pArchive;
-    const ArchiveFile *m_pArchiveFile;
      vector < VFS_BYTE > m_Data;
     VFS_DWORD m_dwPos;
 
   public:
     // Constructor / Destructor.
-     CArchiveFile(const CArchive * pArchive, const VFS_String & strFileName, VFS_BOOL bOpen);
+     CArchiveFile(const CArchive * pArchive, const VFS_String & strFileName, VFS_BOOL bOpen, VFS_DWORD dwVerifyMode);
      virtual ~ CArchiveFile();
 
     // Information.
@@ -284,6 +611,7 @@ class CArchiveFile:public IFile {
 
     // Sizing.
     VFS_BOOL Resize(VFS_LONG lSize);
+    VFS_BOOL Preallocate(VFS_LONG lSize);
     VFS_LONG GetSize() const;
 
     // Information.
@@ -292,15 +620,15 @@ class CArchiveFile:public IFile {
     }
     // Open / Create an Archive File. 
     static IFile *Open(const VFS_String & strAbsoluteFileName, VFS_DWORD dwFlags);
-    static VFS_BOOL Exists(const VFS_String & strAbsoluteFileName, CArchive ** ppArchive = NULL, VFS_String * pFileName = NULL);
+    static VFS_BOOL Exists(VFS_StringView strAbsoluteFileName, CArchive ** ppArchive = NULL, VFS_String * pFileName = NULL);
 };
 
 //============================================================================
 //    INTERFACE DATA DECLARATIONS
 //============================================================================
 // From & To Buffer Stuff.
-extern vector < VFS_BYTE > g_FromBuffer, g_ToBuffer;
-extern VFS_DWORD g_FromPos;
+extern thread_local vector < VFS_BYTE > g_FromBuffer, g_ToBuffer;
+extern thread_local VFS_DWORD g_FromPos;
 
 //============================================================================
 //    INTERFACE FUNCTION PROTOTYPES
@@ -315,9 +643,27 @@ void SetLastError(VFS_ErrorCode eError);
 FileMap & GetOpenFiles();
 ArchiveMap & GetOpenArchives();
 
+// Add an opened Archive to the Open Archives Map (the least recently used unreferenced Archives are closed if there are too many).
+ArchiveMap::iterator AddOpenArchive(const VFS_String & strArchiveName, CArchive * pArchive);
+
 // Get the Root Path List.
 VFS_RootPathList & GetRootPaths();
 
+// Get the Checksum Verification Mode for the Open Flags (the Default if they don't contain one).
+VFS_DWORD GetVerifyMode(VFS_DWORD dwFlags);
+
+// The Block Cache (Blocks are dropped when their Archive is closed).
+DecodedBlock GetCachedBlock(const CArchive * pArchive, VFS_DWORD dwIndex);
+void CacheBlock(const CArchive * pArchive, VFS_DWORD dwIndex, const DecodedBlock & Block);
+void UncacheBlocks(const CArchive * pArchive);
+
+// Add an opened File to the Access Trace (if it's being recorded) / stop Recording and Prefetching (when shutting down).
+void RecordAccess(const VFS_String & strAbsoluteFileName);
+void ShutdownTrace();
+
+// Open a File like VFS_File_Open() does, but without adding it to the Access Trace (for the Files the VFS reads itself).
+VFS_Handle OpenFile(const VFS_Path & FileName, VFS_DWORD dwFlags);
+
 // (Always) removes a trailing Path Separator Char.
 VFS_String WithoutTrailingSeparator(const VFS_String & strFileName, VFS_BOOL bForce);
 
@@ -325,7 +671,34 @@ VFS_String WithoutTrailingSeparator(const VFS_String & strFileName, VFS_BOOL bFo
 VFS_BOOL IsRootDir(const VFS_String & strFileName);
 
 // Makes a String lower-cased.
-VFS_String ToLower(const VFS_String & strString);
+VFS_String ToLower(VFS_StringView strString);
+
+// Returns a lower-cased View of a String (the String is only copied to strStorage if it contains upper-case Characters).
+VFS_StringView ToLowerView(VFS_StringView strString, VFS_String & strStorage);
+
+// Makes a String lower-cased in place.
+void ToLowerInPlace(VFS_String & strString);
+
+// Does the String contain upper-case Characters?
+VFS_BOOL HasUpperCase(VFS_StringView strString);
+
+// Compares two Strings ignoring the Case.
+VFS_BOOL EqualsNoCase(VFS_StringView strFirst, VFS_StringView strSecond);
+
+// Hashes a Path ignoring the Case.
+VFS_QWORD HashPath(VFS_StringView strPath);
+
+// Continues a CRC32C (Castagnoli) Checksum (start with 0; uses the SSE4.2 Instruction if the CPU supports it).
+VFS_DWORD CRC32C(VFS_DWORD dwCRC, const VFS_BYTE * pData, VFS_DWORD dwSize);
+
+// Get the Statistics Counters of the calling Thread.
+StatBlock & GetThreadStats();
+
+// Returns a monotonic Time Stamp (in Nanoseconds).
+VFS_QWORD GetTimeStamp();
+
+// Adds a Latency to the Histogram of an Operation of the calling Thread.
+void AddLatency(VFS_Operation eOperation, VFS_QWORD qwNanoseconds);
 
 // Array Reader and Writer.
 VFS_BOOL Reader(VFS_BYTE * pBuffer, VFS_DWORD dwBytesToRead, VFS_DWORD * pBytesRead);
@@ -334,11 +707,202 @@ VFS_BOOL Writer(const VFS_BYTE * pBuffer, VFS_DWORD dwBytesToWrite, VFS_DWORD *
 //============================================================================
 //    INTERFACE CLASS IMPLEMENTATIONS
 //============================================================================
+// --- Hash Map ---
+template < class TValue > typename CHashMap < TValue >::size_type CHashMap < TValue >::FindSlot(VFS_StringView strKey, VFS_QWORD qwHash) const
+{
+    size_type nMask = m_Slots.size() - 1;
+    for (size_type nSlot = (size_type) qwHash & nMask;; nSlot = (nSlot + 1) & nMask) {
+	const Slot & Current = m_Slots[nSlot];
+	if (Current.dwEntry == 0 || (Current.qwHash == qwHash && EqualsNoCase(m_Entries[Current.dwEntry - 1].first, strKey)))
+	    return nSlot;
+    }
+}
+
+template < class TValue > typename CHashMap < TValue >::size_type CHashMap < TValue >::FindEntrySlot(size_type nEntry) const
+{
+    size_type nMask = m_Slots.size() - 1;
+    for (size_type nSlot = (size_type) HashPath(m_Entries[nEntry].first) & nMask;; nSlot = (nSlot + 1) & nMask) {
+	if (m_Slots[nSlot].dwEntry == nEntry + 1)
+	    return nSlot;
+    }
+}
+
+template < class TValue > void CHashMap < TValue >::Rehash(size_type nSlots)
+{
+    vector < Slot > OldSlots(nSlots);
+    OldSlots.swap(m_Slots);
+    for (size_type nSlot = 0; nSlot < OldSlots.size(); nSlot++) {
+	if (OldSlots[nSlot].dwEntry == 0)
+	    continue;
+	size_type nNew = (size_type) OldSlots[nSlot].qwHash & (nSlots - 1);
+	while (m_Slots[nNew].dwEntry != 0)
+	    nNew = (nNew + 1) & (nSlots - 1);
+	m_Slots[nNew] = OldSlots[nSlot];
+    }
+}
+
+template < class TValue > void CHashMap < TValue >::Reindex()
+{
+    // Keep the Load Factor below 3/4 (like insert() does).
+    size_type nSlots = m_Slots.empty() ? 16 : m_Slots.size();
+    while (nSlots * 3 < m_Entries.size() * 4)
+	nSlots *= 2;
+
+    m_Slots.assign(nSlots, Slot());
+    for (size_type nEntry = 0; nEntry < m_Entries.size(); nEntry++) {
+	VFS_QWORD qwHash = HashPath(m_Entries[nEntry].first);
+	size_type nSlot = (size_type) qwHash & (nSlots - 1);
+	while (m_Slots[nSlot].dwEntry != 0)
+	    nSlot = (nSlot + 1) & (nSlots - 1);
+	m_Slots[nSlot].qwHash = qwHash;
+	m_Slots[nSlot].dwEntry = (VFS_DWORD) nEntry + 1;
+    }
+}
+
+template < class TValue > void CHashMap < TValue >::reserve(size_type nEntries)
+{
+    size_type nSlots = 16;
+    while (nSlots * 3 < nEntries * 4)
+	nSlots *= 2;
+    if (nSlots > m_Slots.size())
+	Rehash(nSlots);
+    m_Entries.reserve(nEntries);
+}
+
+template < class TValue > typename CHashMap < TValue >::iterator CHashMap < TValue >::find(VFS_StringView strKey)
+{
+    return find(strKey, HashPath(strKey));
+}
+
+template < class TValue > typename CHashMap < TValue >::iterator CHashMap < TValue >::find(VFS_StringView strKey, VFS_QWORD qwHash)
+{
+    if (m_Slots.empty())
+	return end();
+    VFS_DWORD dwEntry = m_Slots[FindSlot(strKey, qwHash)].dwEntry;
+    return dwEntry != 0 ? begin() + (dwEntry - 1) : end();
+}
+
+template < class TValue > typename CHashMap < TValue >::const_iterator CHashMap < TValue >::find(VFS_StringView strKey) const
+{
+    return find(strKey, HashPath(strKey));
+}
+
+template < class TValue > typename CHashMap < TValue >::const_iterator CHashMap < TValue >::find(VFS_StringView strKey, VFS_QWORD qwHash) const
+{
+    if (m_Slots.empty())
+	return end();
+    VFS_DWORD dwEntry = m_Slots[FindSlot(strKey, qwHash)].dwEntry;
+    return dwEntry != 0 ? begin() + (dwEntry - 1) : end();
+}
+
+template < class TValue > TValue & CHashMap < TValue >::operator[](VFS_StringView strKey)
+{
+    VFS_QWORD qwHash = HashPath(strKey);
+    iterator iter = find(strKey, qwHash);
+    if (iter != end())
+	return (*iter).second;
+    return (*insert(value_type(VFS_String(strKey), TValue())).first).second;
+}
+
+template < class TValue > pair < typename CHashMap < TValue >::iterator, bool > CHashMap < TValue >::insert(const value_type & Value)
+{
+    VFS_QWORD qwHash = HashPath(Value.first);
+    iterator iter = find(Value.first, qwHash);
+    if (iter != end())
+	return make_pair(iter, false);
+
+    // Keep the Load Factor below 3/4, so the Clusters stay short.
+    if ((m_Entries.size() + 1) * 4 > m_Slots.size() * 3)
+	Rehash(m_Slots.empty() ? 16 : m_Slots.size() * 2);
+    Slot & NewSlot = m_Slots[FindSlot(Value.first, qwHash)];
+    m_Entries.push_back(Value);
+    NewSlot.qwHash = qwHash;
+    NewSlot.dwEntry = (VFS_DWORD) m_Entries.size();
+    return make_pair(end() - 1, true);
+}
+
+template < class TValue > typename CHashMap < TValue >::iterator CHashMap < TValue >::erase(iterator iter)
+{
+    size_type nEntry = iter - begin();
+    size_type nLast = m_Entries.size() - 1;
+    size_type nMask = m_Slots.size() - 1;
+
+    // Free the Slot and shift the following Slots of the Cluster back (so we don't need Tombstones).
+    size_type nHole = FindEntrySlot(nEntry);
+    for (size_type nNext = (nHole + 1) & nMask; m_Slots[nNext].dwEntry != 0; nNext = (nNext + 1) & nMask) {
+	size_type nIdeal = (size_type) m_Slots[nNext].qwHash & nMask;
+	if (((nNext - nIdeal) & nMask) >= ((nNext - nHole) & nMask)) {
+	    m_Slots[nHole] = m_Slots[nNext];
+	    nHole = nNext;
+	}
+    }
+    m_Slots[nHole].dwEntry = 0;
+
+    // Move the last Entry into the Gap.
+    if (nEntry != nLast) {
+	m_Slots[FindEntrySlot(nLast)].dwEntry = (VFS_DWORD) nEntry + 1;
+	m_Entries[nEntry] = std::move(m_Entries[nLast]);
+    }
+    m_Entries.pop_back();
+
+    return begin() + nEntry;
+}
+
+template < class TValue > typename CHashMap < TValue >::size_type CHashMap < TValue >::erase(VFS_StringView strKey)
+{
+    iterator iter = find(strKey);
+    if (iter == end())
+	return 0;
+    erase(iter);
+    return 1;
+}
+
+template < class TValue > pair < typename CHashMap < TValue >::iterator, bool > CHashMap < TValue >::insert_sorted(const value_type & Value)
+{
+    iterator iter = find(Value.first);
+    if (iter != end())
+	return make_pair(iter, false);
+
+    // Shift the greater Entries up and rebuild the Slots.
+    size_type nEntry = 0;
+    while (nEntry < m_Entries.size() && !(Value.first < m_Entries[nEntry].first))
+	nEntry++;
+    m_Entries.insert(begin() + nEntry, Value);
+    Reindex();
+    return make_pair(begin() + nEntry, true);
+}
+
+template < class TValue > typename CHashMap < TValue >::iterator CHashMap < TValue >::erase_stable(iterator iter)
+{
+    size_type nEntry = iter - begin();
+    m_Entries.erase(iter);
+    Reindex();
+    return begin() + nEntry;
+}
+
 inline void IFile::SetFileName(const VFS_String & strFileName)
 {
     m_strFileName = ToLower(strFileName);
 }
 
+// Adds a Value to a Statistics Counter of the calling Thread.
+inline void AddStat(StatCounter eCounter, VFS_QWORD qwValue = 1)
+{
+    atomic < VFS_QWORD > &Counter = GetThreadStats().Counters[eCounter];
+    Counter.store(Counter.load(memory_order_relaxed) + qwValue, memory_order_relaxed);
+}
+
+inline COperationTimer::COperationTimer(VFS_Operation eOperation)
+{
+    m_eOperation = eOperation;
+    m_qwStart = GetTimeStamp();
+}
+
+inline COperationTimer::~COperationTimer()
+{
+    AddLatency(m_eOperation, GetTimeStamp() - m_qwStart);
+}
+
 //============================================================================
 //    INTERFACE TRAILING HEADERS
 //============================================================================
@@ -15,16 +15,62 @@
 //    IMPLEMENTATION HEADERS
 //============================================================================
 #include "VFS_Implementation.h"
+#include <thread>
+#include <mutex>
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
 //============================================================================
+// How much the Index Reader reads beyond the Part of the Index it needs (so most Indices are read in one go).
+static const VFS_DWORD INDEX_READ_AHEAD = 64 * 1024;
+
+// The File Records of big Archives (or Dirs) are decoded by several Threads, in Chunks of this many Records.
+static const VFS_DWORD RECORD_CHUNK_SIZE = 16384;
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE CLASS PROTOTYPES / EXTERNAL CLASS REFERENCES
 //============================================================================
 //============================================================================
 //    IMPLEMENTATION PRIVATE STRUCTURES / UTILITY CLASSES
 //============================================================================
+// The State shared by the Extraction Threads.
+struct ExtractionJob {
+	const CArchive* pArchive;
+	VFS_String strSource;
+	IFile* pSource;		// The Handle of the Archive if there's only one Thread (NULL if each Thread opens its own).
+	VFS_String strTarget;
+	VFS_DWORD dwNumFiles;
+
+	// The next File to extract.
+	atomic< VFS_DWORD > dwNextFile;
+
+	// The first Error which occured (the other Threads stop as soon as possible).
+	atomic< bool > bFailed;
+	mutex Mutex;
+	VFS_ErrorCode eError;
+};
+
+// A Piece of the Archive File holding (a Part of) the Index, which is parsed from Memory.
+struct IndexBuffer {
+	vector< VFS_BYTE > Data;
+	VFS_DWORD dwOffset;	// The Offset of the Data in the Archive File.
+	VFS_DWORD dwPos;	// The Offset of the next Record in the Archive File.
+	VFS_QWORD qwFileSize;
+};
+
+// The State shared by the Threads decoding File Records.
+struct RecordDecodingJob {
+	const ArchiveDirList* pDirs;
+	const ARCHIVE_FILE* pRawFiles;
+	ArchiveFile* pFiles;
+	VFS_DWORD dwNumFiles;
+
+	// The next Chunk to decode.
+	atomic< VFS_DWORD > dwNextChunk;
+
+	// Did a Record refer to a Dir which doesn't exist (the other Threads stop as soon as possible)?
+	atomic< bool > bFailed;
+};
 //============================================================================
 //    IMPLEMENTATION REQUIRED EXTERNAL REFERENCES (AVOID)
 //============================================================================
@@ -33,20 +79,200 @@
 //============================================================================
 // The active Archive (the Archive whose Filter Data is applied).
 CArchive* CArchive::m_pActive = NULL;
+VFS_QWORD CArchive::m_qwUseClock = 0;
 
 //============================================================================
 //    INTERFACE DATA
 //============================================================================
-// From & To Buffer.
-vector< VFS_BYTE > g_FromBuffer, g_ToBuffer;
-VFS_DWORD g_FromPos;
+// From & To Buffer (per Thread, so Archives can be decoded concurrently).
+thread_local vector< VFS_BYTE > g_FromBuffer, g_ToBuffer;
+thread_local VFS_DWORD g_FromPos;
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
 //============================================================================
+static void ExtractionThread( ExtractionJob* pJob );
+static VFS_BOOL PrefetchIndex( IFile* pSource, IndexBuffer& Index, VFS_DWORD dwSize );
+static VFS_BOOL GetIndex( IFile* pSource, IndexBuffer& Index, VFS_DWORD dwSize, const VFS_BYTE*& pData );
+static VFS_BOOL ReadIndex( IFile* pSource, IndexBuffer& Index, void* pTarget, VFS_DWORD dwSize );
+static void RecordDecodingThread( RecordDecodingJob* pJob );
+static VFS_BOOL DecodeFileRecords( const ArchiveDirList& Dirs, const ARCHIVE_FILE* pRawFiles, VFS_DWORD dwNumFiles, ArchiveFile* pFiles );
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTIONS
 //============================================================================
+// Extract Files until there are no more left (each Thread has its own Handle to the Archive File, a single Thread uses the one
+// of the Archive).
+static void ExtractionThread( ExtractionJob* pJob )
+{
+	VFS_ErrorCode eError = VFS_ERROR_NONE;
+
+	IFile* pSource = pJob->pSource;
+	if( pSource != NULL )
+		pSource->Add();
+	else
+		pSource = CStdIOFile::Open( pJob->strSource, VFS_READ );
+	if( pSource == NULL )
+		eError = VFS_GetLastError();
+	else
+	{
+		while( !pJob->bFailed.load( memory_order_relaxed ) )
+		{
+			VFS_DWORD dwIndex = pJob->dwNextFile++;
+			if( dwIndex >= pJob->dwNumFiles )
+				break;
+
+			if( !pJob->pArchive->ExtractFile( pSource, dwIndex, pJob->strTarget ) )
+			{
+				eError = VFS_GetLastError();
+				break;
+			}
+		}
+		pSource->Release();
+	}
+
+	// Remember the Error.
+	if( pSource == NULL || eError != VFS_ERROR_NONE )
+	{
+		lock_guard< mutex > Lock( pJob->Mutex );
+		if( !pJob->bFailed.load( memory_order_relaxed ) )
+		{
+			pJob->eError = eError == VFS_ERROR_NONE ? VFS_ERROR_GENERIC : eError;
+			pJob->bFailed.store( true, memory_order_relaxed );
+		}
+	}
+}
+
+// Make sure the next dwSize Bytes of the Index are in the Buffer (if they aren't, they are read in one go, together with
+// what follows them).
+static VFS_BOOL PrefetchIndex( IFile* pSource, IndexBuffer& Index, VFS_DWORD dwSize )
+{
+	if( dwSize == 0 || ( Index.dwPos >= Index.dwOffset && ( VFS_QWORD )Index.dwPos + dwSize <= ( VFS_QWORD )Index.dwOffset + Index.Data.size() ) )
+		return VFS_TRUE;
+
+	if( ( VFS_QWORD )Index.dwPos + dwSize > Index.qwFileSize )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return VFS_FALSE;
+	}
+	VFS_QWORD qwSize = ( VFS_QWORD )dwSize + INDEX_READ_AHEAD;
+	if( qwSize > Index.qwFileSize - Index.dwPos )
+		qwSize = Index.qwFileSize - Index.dwPos;
+
+	Index.Data.resize( ( VFS_DWORD )qwSize );
+	Index.dwOffset = Index.dwPos;
+	VFS_DWORD dwRead = 0;
+	if( !Index.Data.empty() && ( !pSource->Seek( Index.dwOffset, VFS_SET ) || !pSource->Read( Index.Data.data(), ( VFS_DWORD )Index.Data.size(), &dwRead ) ) )
+		return VFS_FALSE;
+	if( dwRead < dwSize )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return VFS_FALSE;
+	}
+	Index.Data.resize( dwRead );
+
+	return VFS_TRUE;
+}
+
+// Get the next dwSize Bytes of the Index (they stay valid until the Buffer is refilled) / copy them.
+static VFS_BOOL GetIndex( IFile* pSource, IndexBuffer& Index, VFS_DWORD dwSize, const VFS_BYTE*& pData )
+{
+	if( !PrefetchIndex( pSource, Index, dwSize ) )
+		return VFS_FALSE;
+
+	pData = dwSize > 0 ? Index.Data.data() + ( Index.dwPos - Index.dwOffset ) : Index.Data.data();
+	Index.dwPos += dwSize;
+	return VFS_TRUE;
+}
+
+static VFS_BOOL ReadIndex( IFile* pSource, IndexBuffer& Index, void* pTarget, VFS_DWORD dwSize )
+{
+	const VFS_BYTE* pData;
+	if( !GetIndex( pSource, Index, dwSize, pData ) )
+		return VFS_FALSE;
+
+	if( dwSize > 0 )
+		memcpy( pTarget, pData, dwSize );
+	return VFS_TRUE;
+}
+
+// Decode Chunks of File Records until there are no more left.
+static void RecordDecodingThread( RecordDecodingJob* pJob )
+{
+	const ArchiveDirList& Dirs = *pJob->pDirs;
+	while( !pJob->bFailed.load( memory_order_relaxed ) )
+	{
+		VFS_DWORD dwIndex = ( pJob->dwNextChunk++ ) * RECORD_CHUNK_SIZE;
+		if( dwIndex >= pJob->dwNumFiles )
+			break;
+
+		VFS_DWORD dwEnd = min( dwIndex + RECORD_CHUNK_SIZE, pJob->dwNumFiles );
+		for( ; dwIndex < dwEnd; dwIndex++ )
+		{
+			const ARCHIVE_FILE& RawFile = pJob->pRawFiles[ dwIndex ];
+			if( RawFile.dwDirIndex != DIR_INDEX_ROOT && RawFile.dwDirIndex >= Dirs.size() )
+			{
+				pJob->bFailed.store( true, memory_order_relaxed );
+				return;
+			}
+
+			// The Name is prefixed with the Full Name of the Dir.
+			ArchiveFile& File = pJob->pFiles[ dwIndex ];
+			if( RawFile.dwDirIndex != DIR_INDEX_ROOT )
+			{
+				File.strName = Dirs[ RawFile.dwDirIndex ].strName;
+				File.strName += VFS_PATH_SEPARATOR;
+				File.strName += RawFile.szName;
+			}
+			else
+				File.strName = RawFile.szName;
+			File.dwDirIndex = RawFile.dwDirIndex;
+			File.dwCompressedSize = RawFile.dwCompressedSize;
+			File.dwUncompressedSize = RawFile.dwUncompressedSize;
+			File.dwDataOffset = 0;
+			File.dwChecksum = 0;
+			File.dwBlockIndex = BLOCK_INDEX_NONE;
+		}
+	}
+}
+
+// Decode File Records (the Data Offsets, Checksums and Blocks are left to the Caller; several Threads are used if there are
+// enough Records). Fails if a Record refers to a Dir which doesn't exist.
+static VFS_BOOL DecodeFileRecords( const ArchiveDirList& Dirs, const ARCHIVE_FILE* pRawFiles, VFS_DWORD dwNumFiles, ArchiveFile* pFiles )
+{
+	RecordDecodingJob Job;
+	Job.pDirs = &Dirs;
+	Job.pRawFiles = pRawFiles;
+	Job.pFiles = pFiles;
+	Job.dwNumFiles = dwNumFiles;
+	Job.dwNextChunk = 0;
+	Job.bFailed = false;
+
+	// One Thread per Chunk at most (the calling Thread is one of them).
+	VFS_DWORD dwChunks = ( dwNumFiles + RECORD_CHUNK_SIZE - 1 ) / RECORD_CHUNK_SIZE;
+	VFS_DWORD dwThreads = thread::hardware_concurrency();
+	if( dwThreads > dwChunks )
+		dwThreads = dwChunks;
+
+	vector< thread > Threads;
+	for( VFS_DWORD dwIndex = 1; dwIndex < dwThreads; dwIndex++ )
+	{
+		try
+		{
+			Threads.push_back( thread( RecordDecodingThread, &Job ) );
+		}
+		catch( ... )
+		{
+			break;
+		}
+	}
+	RecordDecodingThread( &Job );
+	for( vector< thread >::iterator iter = Threads.begin(); iter != Threads.end(); iter++ )
+		( *iter ).join();
+
+	return !Job.bFailed;
+}
+
 //============================================================================
 //    INTERFACE FUNCTIONS
 //============================================================================
@@ -57,42 +283,152 @@ VFS_DWORD g_FromPos;
 // Parse the Archive.
 VFS_BOOL CArchive::Parse()
 {
+	COperationTimer Timer( VFS_OP_ARCHIVE_PARSE );
+
+	AddStat( STAT_ARCHIVE_PARSES );
+
+	// The Index is read in big Pieces and parsed from Memory (the first Piece holds the whole Index of most Archives).
+	IFile* pSource = ( IFile* )( VFS_DWORD )m_hFile;
+	VFS_QWORD qwArchiveSize = ( VFS_QWORD )pSource->GetSize();
+	IndexBuffer Index;
+	Index.dwOffset = 0;
+	Index.dwPos = 0;
+	Index.qwFileSize = qwArchiveSize;
+
 	// Read in the Archive Header.
 	ARCHIVE_HEADER RawHeader;
-	if( !VFS_File_Read( m_hFile, ( VFS_BYTE* ) &RawHeader, sizeof( ARCHIVE_HEADER ) ) )
+	if( !ReadIndex( pSource, Index, &RawHeader, sizeof( ARCHIVE_HEADER ) ) )
+		return VFS_FALSE;
+
+	// We can't read Archives of future Versions.
+	if( RawHeader.wVersion > ARCHIVE_VERSION )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return VFS_FALSE;
+	}
+
+	// Read in the Checksums (the Index is checksummed while it's read).
+	ARCHIVE_CHECKSUMS RawChecksums;
+	m_Header.bChecksums = RawHeader.wVersion >= ARCHIVE_VERSION_1_1;
+	if( m_Header.bChecksums && !ReadIndex( pSource, Index, &RawChecksums, sizeof( ARCHIVE_CHECKSUMS ) ) )
+		return VFS_FALSE;
+	VFS_DWORD dwIndexChecksum = 0;
+
+	// Read in the Number of Solid Blocks.
+	ARCHIVE_BLOCKS RawBlocks;
+	RawBlocks.dwNumBlocks = 0;
+	if( RawHeader.wVersion >= ARCHIVE_VERSION_1_2 )
+	{
+		if( !ReadIndex( pSource, Index, &RawBlocks, sizeof( ARCHIVE_BLOCKS ) ) )
+			return VFS_FALSE;
+		dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) &RawBlocks, sizeof( ARCHIVE_BLOCKS ) );
+	}
+
+	// Read in the Number and the Size of the inline Files.
+	ARCHIVE_INLINE_FILES RawInline;
+	RawInline.dwNumFiles = 0;
+	RawInline.dwDataSize = 0;
+	if( RawHeader.wVersion >= ARCHIVE_VERSION_1_4 )
+	{
+		if( !ReadIndex( pSource, Index, &RawInline, sizeof( ARCHIVE_INLINE_FILES ) ) )
+			return VFS_FALSE;
+		dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) &RawInline, sizeof( ARCHIVE_INLINE_FILES ) );
+	}
+	VFS_BOOL bFileBlocks = RawHeader.wVersion >= ARCHIVE_VERSION_1_5 || RawBlocks.dwNumBlocks > 0 || RawInline.dwNumFiles > 0;
+	m_Header.bByDir = RawHeader.wVersion >= ARCHIVE_VERSION_1_5;
+	m_Header.dwNumFiles = RawHeader.dwNumFiles;
+
+	// Don't trust the Counts of a corrupt Archive (each Entry takes at least its Record in the File).
+	if( ( VFS_QWORD )RawHeader.dwNumFilters * sizeof( ARCHIVE_FILTER ) + ( VFS_QWORD )RawHeader.dwNumDirs * sizeof( ARCHIVE_DIR ) +
+		( VFS_QWORD )RawHeader.dwNumFiles * sizeof( ARCHIVE_FILE ) + ( VFS_QWORD )RawBlocks.dwNumBlocks * sizeof( ARCHIVE_BLOCK ) +
+		RawInline.dwDataSize > qwArchiveSize )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
 		return VFS_FALSE;
+	}
 
 	m_Header.dwDataOffset = sizeof( ARCHIVE_HEADER ) +
 							RawHeader.dwNumFilters * sizeof( ARCHIVE_FILTER ) +
 							RawHeader.dwNumDirs * sizeof( ARCHIVE_DIR ) +
 							RawHeader.dwNumFiles * sizeof( ARCHIVE_FILE );
-	m_Header.dwFileDataOffset = m_Header.dwDataOffset;
+	if( m_Header.bChecksums )
+		m_Header.dwDataOffset += sizeof( ARCHIVE_CHECKSUMS ) + RawHeader.dwNumFiles * sizeof( VFS_DWORD );
+	if( RawHeader.wVersion >= ARCHIVE_VERSION_1_2 )
+		m_Header.dwDataOffset += sizeof( ARCHIVE_BLOCKS ) + RawBlocks.dwNumBlocks * sizeof( ARCHIVE_BLOCK );
+	if( bFileBlocks )
+		m_Header.dwDataOffset += RawHeader.dwNumFiles * sizeof( ARCHIVE_FILE_BLOCK );
+	if( RawHeader.wVersion >= ARCHIVE_VERSION_1_3 )
+		m_Header.dwDataOffset += RawHeader.dwNumFilters * sizeof( VFS_DWORD );
+	if( RawHeader.wVersion >= ARCHIVE_VERSION_1_4 )
+		m_Header.dwDataOffset += sizeof( ARCHIVE_INLINE_FILES ) + RawInline.dwDataSize;
+	if( m_Header.bByDir )
+		m_Header.dwDataOffset += ( RawHeader.dwNumDirs + 1 ) * sizeof( ARCHIVE_DIR_FILES ) + RawBlocks.dwNumBlocks * sizeof( VFS_DWORD );
+
+	// The File Records follow the Dirs (and the Dir Files Table).
+	m_Header.dwFilesOffset = Index.dwPos + RawHeader.dwNumFilters * sizeof( ARCHIVE_FILTER ) + RawHeader.dwNumDirs * sizeof( ARCHIVE_DIR );
+	if( RawHeader.wVersion >= ARCHIVE_VERSION_1_3 )
+		m_Header.dwFilesOffset += RawHeader.dwNumFilters * sizeof( VFS_DWORD );
+	if( m_Header.bByDir )
+		m_Header.dwFilesOffset += ( RawHeader.dwNumDirs + 1 ) * sizeof( ARCHIVE_DIR_FILES );
+
+	// Read in the Part of the Index which is parsed right away in one go (for Archives ordered by Dir, that's everything up to
+	// the File Records, which are loaded by Dir).
+	if( !PrefetchIndex( pSource, Index, ( m_Header.bByDir ? m_Header.dwFilesOffset : m_Header.dwDataOffset ) - Index.dwPos ) )
+		return VFS_FALSE;
 
 	// Read in the Filters.
+	const VFS_BYTE* pRawRecords;
+	if( !GetIndex( pSource, Index, RawHeader.dwNumFilters * sizeof( ARCHIVE_FILTER ), pRawRecords ) )
+		return VFS_FALSE;
+	dwIndexChecksum = CRC32C( dwIndexChecksum, pRawRecords, RawHeader.dwNumFilters * sizeof( ARCHIVE_FILTER ) );
+
 	VFS_DWORD dwIndex;
 	for( dwIndex = 0; dwIndex < RawHeader.dwNumFilters; dwIndex++ )
 	{
-		ARCHIVE_FILTER RawFilter;
-		if( !VFS_File_Read( m_hFile, ( VFS_BYTE* ) &RawFilter, sizeof( ARCHIVE_FILTER ) ) )
-			return VFS_FALSE;
-
 		// Get the Filter for the Name.
+		const ARCHIVE_FILTER& RawFilter = ( ( const ARCHIVE_FILTER* ) pRawRecords )[ dwIndex ];
 		VFS_Filter* pFilter = ( VFS_Filter* ) VFS_GetFilter( RawFilter.szName );
 		if( pFilter == NULL )
 			return VFS_FALSE;
 
-        // Increase the File Data Offset.
-		m_Header.dwFileDataOffset += pFilter->GetConfigDataSize();
-
 		m_Header.Filters.push_back( pFilter );
+		m_Header.FilterConfigSizes.push_back( pFilter->GetConfigDataSize() );
 	}
 
+	// Read in the Sizes of the Filter Data (older Archives have Filter Data of the Size the Filters report).
+	if( RawHeader.wVersion >= ARCHIVE_VERSION_1_3 && RawHeader.dwNumFilters > 0 )
+	{
+		if( !ReadIndex( pSource, Index, m_Header.FilterConfigSizes.data(), RawHeader.dwNumFilters * sizeof( VFS_DWORD ) ) )
+			return VFS_FALSE;
+		dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) m_Header.FilterConfigSizes.data(), RawHeader.dwNumFilters * sizeof( VFS_DWORD ) );
+	}
+
+	// Increase the File Data Offset.
+	VFS_QWORD qwFileDataOffset = m_Header.dwDataOffset;
+	for( dwIndex = 0; dwIndex < RawHeader.dwNumFilters; dwIndex++ )
+		qwFileDataOffset += m_Header.FilterConfigSizes[ dwIndex ];
+	if( qwFileDataOffset > qwArchiveSize )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return VFS_FALSE;
+	}
+	m_Header.dwFileDataOffset = ( VFS_DWORD )qwFileDataOffset;
+	m_Header.Dirs.reserve( RawHeader.dwNumDirs );
+	m_Header.DirHash.reserve( RawHeader.dwNumDirs );
+
 	// Read in the Dirs.
+	if( !GetIndex( pSource, Index, RawHeader.dwNumDirs * sizeof( ARCHIVE_DIR ), pRawRecords ) )
+		return VFS_FALSE;
+	dwIndexChecksum = CRC32C( dwIndexChecksum, pRawRecords, RawHeader.dwNumDirs * sizeof( ARCHIVE_DIR ) );
+
 	for( dwIndex = 0; dwIndex < RawHeader.dwNumDirs; dwIndex++ )
 	{
-		ARCHIVE_DIR RawDir;
-		if( !VFS_File_Read( m_hFile, ( VFS_BYTE* ) &RawDir, sizeof( ARCHIVE_DIR ) ) )
+		const ARCHIVE_DIR& RawDir = ( ( const ARCHIVE_DIR* ) pRawRecords )[ dwIndex ];
+		if( RawDir.dwParentIndex != DIR_INDEX_ROOT && RawDir.dwParentIndex >= RawHeader.dwNumDirs )
+		{
+			SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
 			return VFS_FALSE;
+		}
 
 		ArchiveDir Dir;
 		Dir.dwParentDirIndex = RawDir.dwParentIndex;
@@ -101,46 +437,220 @@ VFS_BOOL CArchive::Parse()
 		m_Header.Dirs.push_back( Dir );
 	}
 
-	// Calculate the Full Name.
+	// Build the Subdir Table: count the Subdirs of each Dir, turn the Counts into Offsets and put each Dir into the Range of
+	// its Parent (so the Subdirs of a Dir are in the Order of their Indices).
+	m_Header.SubdirOffsets.assign( RawHeader.dwNumDirs + 2, 0 );
+	m_Header.Subdirs.resize( RawHeader.dwNumDirs );
 	for( dwIndex = 0; dwIndex < RawHeader.dwNumDirs; dwIndex++ )
+		m_Header.SubdirOffsets[ GetDirSlot( m_Header.Dirs[ dwIndex ].dwParentDirIndex ) + 1 ]++;
+	for( dwIndex = 0; dwIndex <= RawHeader.dwNumDirs; dwIndex++ )
+		m_Header.SubdirOffsets[ dwIndex + 1 ] += m_Header.SubdirOffsets[ dwIndex ];
+	vector< VFS_DWORD > NextSubdir( m_Header.SubdirOffsets.begin(), m_Header.SubdirOffsets.end() - 1 );
+	for( dwIndex = 0; dwIndex < RawHeader.dwNumDirs; dwIndex++ )
+		m_Header.Subdirs[ NextSubdir[ GetDirSlot( m_Header.Dirs[ dwIndex ].dwParentDirIndex ) ]++ ] = dwIndex;
+
+	// Calculate the Full Names from the Root Directory down, so each Dir just prefixes its Name with the Full Name of its
+	// Parent (Dirs which can't be reached from the Root Directory are Part of a Cycle).
+	vector< VFS_DWORD > Order( m_Header.Subdirs.begin() + m_Header.SubdirOffsets[ RawHeader.dwNumDirs ], m_Header.Subdirs.end() );
+	Order.reserve( RawHeader.dwNumDirs );
+	for( dwIndex = 0; dwIndex < Order.size(); dwIndex++ )
+	{
+		VFS_DWORD dwDirIndex = Order[ dwIndex ];
+		ArchiveDir& Dir = m_Header.Dirs[ dwDirIndex ];
+		if( Dir.dwParentDirIndex != DIR_INDEX_ROOT )
+			Dir.strName = m_Header.Dirs[ Dir.dwParentDirIndex ].strName + VFS_PATH_SEPARATOR + Dir.strName;
+		m_Header.DirHash[ Dir.strName ] = dwDirIndex;
+
+		Order.insert( Order.end(), m_Header.Subdirs.begin() + m_Header.SubdirOffsets[ dwDirIndex ], m_Header.Subdirs.begin() + m_Header.SubdirOffsets[ dwDirIndex + 1 ] );
+	}
+	if( Order.size() != RawHeader.dwNumDirs )
 	{
-		ArchiveDir* pBase = &m_Header.Dirs[ dwIndex ];
-		ArchiveDir* pDir = pBase;
-		while( pDir->dwParentDirIndex != DIR_INDEX_ROOT )
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return VFS_FALSE;
+	}
+
+	// Read in the Dir Files Table (the Ranges have to follow each other).
+	m_Header.DirFiles.resize( RawHeader.dwNumDirs + 1 );
+	if( m_Header.bByDir )
+	{
+		if( !ReadIndex( pSource, Index, m_Header.DirFiles.data(), ( RawHeader.dwNumDirs + 1 ) * sizeof( ARCHIVE_DIR_FILES ) ) )
+			return VFS_FALSE;
+		dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) m_Header.DirFiles.data(), ( RawHeader.dwNumDirs + 1 ) * sizeof( ARCHIVE_DIR_FILES ) );
+
+		VFS_QWORD qwFirstFile = 0;
+		for( dwIndex = 0; dwIndex <= RawHeader.dwNumDirs; dwIndex++ )
+		{
+			if( m_Header.DirFiles[ dwIndex ].dwFirstFile != qwFirstFile )
+			{
+				SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+				return VFS_FALSE;
+			}
+			qwFirstFile += m_Header.DirFiles[ dwIndex ].dwNumFiles;
+		}
+		if( qwFirstFile != RawHeader.dwNumFiles )
+		{
+			SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+			return VFS_FALSE;
+		}
+	}
+
+
+	// Read in the Files (Archives ordered by Dir only remember where their File Records are).
+	ArchiveFileList Files;
+	VFS_DWORD dwDataOffset = m_Header.dwFileDataOffset;
+	if( m_Header.bByDir )
+		Index.dwPos += RawHeader.dwNumFiles * ( sizeof( ARCHIVE_FILE ) + sizeof( VFS_DWORD ) );
+	else
+	{
+		if( !GetIndex( pSource, Index, RawHeader.dwNumFiles * sizeof( ARCHIVE_FILE ), pRawRecords ) )
+			return VFS_FALSE;
+		dwIndexChecksum = CRC32C( dwIndexChecksum, pRawRecords, RawHeader.dwNumFiles * sizeof( ARCHIVE_FILE ) );
+
+		Files.resize( RawHeader.dwNumFiles );
+		if( !DecodeFileRecords( m_Header.Dirs, ( const ARCHIVE_FILE* ) pRawRecords, RawHeader.dwNumFiles, Files.data() ) )
+		{
+			SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+			return VFS_FALSE;
+		}
+		for( dwIndex = 0; dwIndex < RawHeader.dwNumFiles; dwIndex++ )
+		{
+			Files[ dwIndex ].dwDataOffset = dwDataOffset;
+			dwDataOffset += Files[ dwIndex ].dwCompressedSize;
+		}
+
+		// Read in the File Checksums.
+		if( m_Header.bChecksums )
 		{
-			pDir = &m_Header.Dirs[ pDir->dwParentDirIndex ];
-			pBase->strName = pDir->strName + VFS_PATH_SEPARATOR + pBase->strName;
+			vector< VFS_DWORD > Checksums( RawHeader.dwNumFiles );
+			if( !ReadIndex( pSource, Index, Checksums.data(), RawHeader.dwNumFiles * sizeof( VFS_DWORD ) ) )
+				return VFS_FALSE;
+			dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) Checksums.data(), RawHeader.dwNumFiles * sizeof( VFS_DWORD ) );
+
+			for( dwIndex = 0; dwIndex < RawHeader.dwNumFiles; dwIndex++ )
+				Files[ dwIndex ].dwChecksum = Checksums[ dwIndex ];
 		}
+	}
+	if( m_Header.bChecksums )
+		m_Verified.assign( RawHeader.dwNumFiles, VFS_FALSE );
+
+	// Read in the Solid Blocks (and their Data Offsets).
+	if( RawBlocks.dwNumBlocks > 0 )
+	{
+		vector< ARCHIVE_BLOCK > Blocks( RawBlocks.dwNumBlocks );
+		vector< VFS_DWORD > BlockOffsets( m_Header.bByDir ? RawBlocks.dwNumBlocks : 0 );
+		if( !PrefetchIndex( pSource, Index, RawBlocks.dwNumBlocks * sizeof( ARCHIVE_BLOCK ) + ( VFS_DWORD )( BlockOffsets.size() * sizeof( VFS_DWORD ) ) ) ||
+			!ReadIndex( pSource, Index, Blocks.data(), RawBlocks.dwNumBlocks * sizeof( ARCHIVE_BLOCK ) ) ||
+			!ReadIndex( pSource, Index, BlockOffsets.data(), ( VFS_DWORD )( BlockOffsets.size() * sizeof( VFS_DWORD ) ) ) )
+			return VFS_FALSE;
+		dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) Blocks.data(), RawBlocks.dwNumBlocks * sizeof( ARCHIVE_BLOCK ) );
+		dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) BlockOffsets.data(), ( VFS_DWORD )( BlockOffsets.size() * sizeof( VFS_DWORD ) ) );
 
-		m_Header.DirHash[ m_Header.Dirs[ dwIndex ].strName ] = dwIndex;
+		m_Header.Blocks.resize( RawBlocks.dwNumBlocks );
+		for( dwIndex = 0; dwIndex < RawBlocks.dwNumBlocks; dwIndex++ )
+		{
+			m_Header.Blocks[ dwIndex ].dwDataOffset = BlockOffsets.empty() ? 0 : BlockOffsets[ dwIndex ];
+			m_Header.Blocks[ dwIndex ].dwCompressedSize = Blocks[ dwIndex ].dwCompressedSize;
+			m_Header.Blocks[ dwIndex ].dwUncompressedSize = Blocks[ dwIndex ].dwUncompressedSize;
+			m_Header.Blocks[ dwIndex ].dwChecksum = Blocks[ dwIndex ].dwChecksum;
+			if( ( VFS_QWORD )m_Header.Blocks[ dwIndex ].dwDataOffset + m_Header.Blocks[ dwIndex ].dwCompressedSize > qwArchiveSize )
+			{
+				SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+				return VFS_FALSE;
+			}
+		}
 	}
 
-	// Read in the Filter Data.
-	VFS_DWORD dwPos = VFS_File_Tell( m_hFile );
-	if( !Activate() )
+	// Read in the File Blocks (unless they are loaded by Dir).
+	m_Header.dwFileBlocksOffset = Index.dwPos;
+	vector< ARCHIVE_FILE_BLOCK > FileBlocks( bFileBlocks && !m_Header.bByDir ? RawHeader.dwNumFiles : 0 );
+	if( !ReadIndex( pSource, Index, FileBlocks.data(), ( VFS_DWORD )( FileBlocks.size() * sizeof( ARCHIVE_FILE_BLOCK ) ) ) )
+		return VFS_FALSE;
+	dwIndexChecksum = CRC32C( dwIndexChecksum, ( const VFS_BYTE* ) FileBlocks.data(), ( VFS_DWORD )( FileBlocks.size() * sizeof( ARCHIVE_FILE_BLOCK ) ) );
+	if( m_Header.bByDir )
+		Index.dwPos += RawHeader.dwNumFiles * sizeof( ARCHIVE_FILE_BLOCK );
+
+	// Read in the inline Data, together with the Filter Data which follows the Index.
+	m_Header.InlineData.resize( RawInline.dwDataSize );
+	if( !PrefetchIndex( pSource, Index, m_Header.dwFileDataOffset - Index.dwPos ) ||
+		!ReadIndex( pSource, Index, m_Header.InlineData.data(), RawInline.dwDataSize ) )
 		return VFS_FALSE;
-	VFS_File_Seek( m_hFile, dwPos, VFS_SET );
+	dwIndexChecksum = CRC32C( dwIndexChecksum, m_Header.InlineData.data(), RawInline.dwDataSize );
 
-	// Read in the Files.
-	VFS_DWORD dwDataOffset = m_Header.dwFileDataOffset;
-	for( dwIndex = 0; dwIndex < RawHeader.dwNumFiles; dwIndex++ )
+	// Lay out the Data again (the Data of a Block is stored at its first Member, the Members and the inline Files have no Data of their own).
+	if( !FileBlocks.empty() )
 	{
-		ARCHIVE_FILE RawFile;
-		if( !VFS_File_Read( m_hFile, ( VFS_BYTE* ) &RawFile, sizeof( ARCHIVE_FILE ) ) )
+		vector< VFS_BYTE > Placed( RawBlocks.dwNumBlocks, VFS_FALSE );
+		dwDataOffset = m_Header.dwFileDataOffset;
+		for( dwIndex = 0; dwIndex < RawHeader.dwNumFiles; dwIndex++ )
+		{
+			ArchiveFile& File = Files[ dwIndex ];
+			VFS_DWORD dwBlock = FileBlocks[ dwIndex ].dwBlockIndex;
+			if( dwBlock == BLOCK_INDEX_NONE )
+			{
+				File.dwDataOffset = dwDataOffset;
+				dwDataOffset += File.dwCompressedSize;
+				continue;
+			}
+
+			VFS_DWORD dwSize = dwBlock == BLOCK_INDEX_INLINE ? RawInline.dwDataSize :
+							   dwBlock < RawBlocks.dwNumBlocks ? m_Header.Blocks[ dwBlock ].dwUncompressedSize : 0;
+			if( ( dwBlock != BLOCK_INDEX_INLINE && dwBlock >= RawBlocks.dwNumBlocks ) ||
+				( VFS_QWORD )FileBlocks[ dwIndex ].dwBlockOffset + File.dwUncompressedSize > dwSize )
+			{
+				SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+				return VFS_FALSE;
+			}
+			if( dwBlock != BLOCK_INDEX_INLINE && !Placed[ dwBlock ] )
+			{
+				Placed[ dwBlock ] = VFS_TRUE;
+				m_Header.Blocks[ dwBlock ].dwDataOffset = dwDataOffset;
+				dwDataOffset += m_Header.Blocks[ dwBlock ].dwCompressedSize;
+			}
+			File.dwBlockIndex = dwBlock;
+			File.dwDataOffset = FileBlocks[ dwIndex ].dwBlockOffset;
+			File.dwCompressedSize = File.dwUncompressedSize;
+		}
+	}
+
+	// Verify the Index.
+	if( m_Header.bChecksums )
+	{
+		if( VFS_Archive_GetVerifyMode() != VFS_VERIFY_OFF && dwIndexChecksum != RawChecksums.dwIndexChecksum )
+		{
+			AddStat( STAT_CHECKSUM_MISMATCHES );
+			SetLastError( VFS_ERROR_CHECKSUM_MISMATCH );
 			return VFS_FALSE;
+		}
+	}
 
-		ArchiveFile File;
-		File.strName = RawFile.szName;
-		File.dwDirIndex = RawFile.dwDirIndex;
-		if( File.dwDirIndex != DIR_INDEX_ROOT )
-			File.strName = m_Header.Dirs[ File.dwDirIndex ].strName + VFS_PATH_SEPARATOR + File.strName;
-		File.dwCompressedSize = RawFile.dwCompressedSize;
-		File.dwUncompressedSize = RawFile.dwUncompressedSize;
-		File.dwDataOffset = dwDataOffset;
-		dwDataOffset += File.dwCompressedSize;
-		m_Header.Files.push_back( File );
+	// Activate ourselves with the Filter Data (it follows the Index).
+	const VFS_BYTE* pConfigData;
+	Index.dwPos = m_Header.dwDataOffset;
+	if( !GetIndex( pSource, Index, m_Header.dwFileDataOffset - m_Header.dwDataOffset, pConfigData ) || !Activate( pConfigData ) )
+		return VFS_FALSE;
+
+	// Archives ordered by Dir load the Files of the Root Directory right away, the ones of the other Dirs when they're needed.
+	m_Files.resize( RawHeader.dwNumDirs + 1 );
+	if( m_Header.bByDir )
+		return LoadDir( RawHeader.dwNumDirs );
+
+	// Older Archives are ordered by Dir here.
+	for( dwIndex = 0; dwIndex < RawHeader.dwNumFiles; dwIndex++ )
+		m_Header.DirFiles[ GetDirSlot( Files[ dwIndex ].dwDirIndex ) ].dwNumFiles++;
+	VFS_DWORD dwFirstFile = 0;
+	for( dwIndex = 0; dwIndex <= RawHeader.dwNumDirs; dwIndex++ )
+	{
+		m_Header.DirFiles[ dwIndex ].dwFirstFile = dwFirstFile;
+		m_Files[ dwIndex ].reserve( m_Header.DirFiles[ dwIndex ].dwNumFiles );
+		dwFirstFile += m_Header.DirFiles[ dwIndex ].dwNumFiles;
+	}
 
-		m_Header.FileHash[ m_Header.Files[ dwIndex ].strName ] = dwIndex;
+	m_FileHash.reserve( RawHeader.dwNumFiles );
+	for( dwIndex = 0; dwIndex < RawHeader.dwNumFiles; dwIndex++ )
+	{
+		VFS_DWORD dwSlot = GetDirSlot( Files[ dwIndex ].dwDirIndex );
+		m_FileHash[ Files[ dwIndex ].strName ] = m_Header.DirFiles[ dwSlot ].dwFirstFile + ( VFS_DWORD )m_Files[ dwSlot ].size();
+		m_Files[ dwSlot ].push_back( Files[ dwIndex ] );
 	}
 
 	return VFS_TRUE;
@@ -150,24 +660,31 @@ VFS_BOOL CArchive::Parse()
 CArchive::CArchive( VFS_String strAbsoluteFileName )
 {
 	m_strFileName = strAbsoluteFileName;
+	m_dwRefCount = 0;
+	Touch();
 
 	// Try to open the Archive.
-	m_hFile = VFS_File_Open( m_strFileName, VFS_READ );
+	m_hFile = OpenFile( VFS_Path( m_strFileName ), VFS_READ );
 	if( m_hFile == VFS_INVALID_HANDLE_VALUE )
 		return;
 
-	// Parse the Archive:
+	// Parse the Archive (a corrupt Index is reported as such).
 	if( !Parse() )
 	{
+		VFS_ErrorCode eError = VFS_GetLastError();
 		VFS_File_Close( m_hFile );
 		m_hFile = VFS_INVALID_HANDLE_VALUE;
-		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		SetLastError( eError == VFS_ERROR_CHECKSUM_MISMATCH ? eError : VFS_ERROR_INVALID_ARCHIVE_FORMAT );
 		return;
 	}
 }
 
 CArchive::~CArchive()
 {
+	// Another Archive might get our Address, so it mustn't take our Filter Data for its own.
+	if( m_pActive == this )
+		m_pActive = NULL;
+	UncacheBlocks( this );
 	if( m_hFile != VFS_INVALID_HANDLE_VALUE )
 		VFS_File_Close( m_hFile );
 }
@@ -190,108 +707,256 @@ const ArchiveHeader* CArchive::GetHeader() const
 	return &m_Header;
 }
 
-// Get the Reference Count (i.e. the Sum of the Reference Counts of all Open Files of this Archive).
+// Reference Counting (each open File of this Archive and each Level of a Directory Iterator in it holds a Reference).
+void CArchive::AddRef() const
+{
+	m_dwRefCount++;
+	Touch();
+}
+
+void CArchive::Release() const
+{
+	m_dwRefCount--;
+	Touch();
+}
+
 VFS_DWORD CArchive::GetRefCount() const
 {
-	VFS_DWORD dwRefCount = 0;
-	for( FileMap::iterator iter = GetOpenFiles().begin(); iter != GetOpenFiles().end(); iter++ )
+	return m_dwRefCount;
+}
+
+// Unload the Files of all Dirs except for the Root Directory.
+void CArchive::UnloadDirs()
+{
+	if( !m_Header.bByDir )
+		return;
+
+	for( VFS_DWORD dwSlot = 0; dwSlot < m_Header.Dirs.size(); dwSlot++ )
 	{
-		IFile* pFile = ( *iter ).second;
-		if( pFile->IsArchived() )
-		{
-			CArchiveFile* pArchiveFile = ( CArchiveFile* )pFile;
-			if( pArchiveFile->GetArchive() == this )
-				dwRefCount++;
-		}
+		for( ArchiveFileList::iterator iter = m_Files[ dwSlot ].begin(); iter != m_Files[ dwSlot ].end(); iter++ )
+			m_FileHash.erase( ( *iter ).strName );
+		ArchiveFileList().swap( m_Files[ dwSlot ] );
 	}
-	return dwRefCount;
 }
 
 // Directory Stuff.
-VFS_BOOL CArchive::ContainsDir( const VFS_String& strDirName ) const
+VFS_BOOL CArchive::ContainsDir( VFS_StringView strDirName ) const
 {
-	return m_Header.DirHash.find( ToLower( strDirName ) ) != m_Header.DirHash.end();
+	Touch();
+	return m_Header.DirHash.find( strDirName ) != m_Header.DirHash.end();
 }
 
-VFS_BOOL CArchive::IterateDir( const VFS_String& strDirName, VFS_DirIterationProc pIterationProc, VFS_BOOL bRecursive, void* pParam ) const
+// Find a Dir (the Root Directory is the empty Name).
+VFS_BOOL CArchive::FindDir( VFS_StringView strDirName, VFS_DWORD& dwDirIndex ) const
 {
-	// Get the dir for the name.
-	VFS_DWORD dwDirIndex;
-	VFS_String strDir = WithoutTrailingSeparator( ToLower( strDirName ), VFS_TRUE );
-	if( strDir != VFS_TEXT( "" ) )
+	Touch();
+	if( strDirName.empty() )
 	{
-		ArchiveDirMap::const_iterator iter = m_Header.DirHash.find( ToLower( strDir ) );
-		if( iter == m_Header.DirHash.end() )
-		{
-			SetLastError( VFS_ERROR_NOT_FOUND );
-			return VFS_FALSE;
-		}
-		dwDirIndex = ( *iter ).second;
-	}
-	else
 		dwDirIndex = DIR_INDEX_ROOT;
+		return VFS_TRUE;
+	}
 
-	// Iterate for all Dirs in the Dir and call IterateDir() on these (if in Recursive Mode).
-	VFS_DWORD dwIndex;
-	for( dwIndex = 0; dwIndex < m_Header.Dirs.size(); dwIndex++ )
+	ArchiveDirMap::const_iterator iter = m_Header.DirHash.find( strDirName );
+	if( iter == m_Header.DirHash.end() )
 	{
-		if( m_Header.Dirs[ dwIndex ].dwParentDirIndex != dwDirIndex )
-			continue;
+		SetLastError( VFS_ERROR_NOT_FOUND );
+		return VFS_FALSE;
+	}
+	dwDirIndex = ( *iter ).second;
+	return VFS_TRUE;
+}
 
-		VFS_EntityInfo Info;
-		Info.bArchived = VFS_TRUE;
-		Info.eType = VFS_DIR;
-		Info.lSize = 0;
-		Info.strPath = GetFileNameWithoutExtension() + VFS_PATH_SEPARATOR + m_Header.Dirs[ dwIndex ].strName;
-		if( !VFS_Util_GetName( Info.strPath, Info.strName ) )
-			return VFS_FALSE;
+// Get the Subdirs of a Dir (their Range in the Subdir Table).
+const VFS_DWORD* CArchive::GetSubdirs( VFS_DWORD dwDirIndex, VFS_DWORD& dwNumSubdirs ) const
+{
+	VFS_DWORD dwSlot = GetDirSlot( dwDirIndex );
+	dwNumSubdirs = m_Header.SubdirOffsets[ dwSlot + 1 ] - m_Header.SubdirOffsets[ dwSlot ];
+	return m_Header.Subdirs.data() + m_Header.SubdirOffsets[ dwSlot ];
+}
 
-		if( !pIterationProc( Info, pParam ) )
-			return VFS_TRUE;
+// Get the Files of a Dir (they are loaded if they aren't yet).
+const ArchiveFileList* CArchive::GetDirFiles( VFS_DWORD dwDirIndex ) const
+{
+	VFS_DWORD dwSlot = GetDirSlot( dwDirIndex );
+	if( !LoadDir( dwSlot ) )
+		return NULL;
+	return &m_Files[ dwSlot ];
+}
 
-        if( bRecursive && !IterateDir( m_Header.Dirs[ dwIndex ].strName, pIterationProc, bRecursive, pParam ) )
-			return VFS_FALSE;
+// File Stuff.
+VFS_BOOL CArchive::ContainsFile( VFS_StringView strFileName ) const
+{
+	Touch();
+	return strFileName.empty() ||							// Root Directory
+		   ( LoadDirOf( strFileName ) && m_FileHash.find( strFileName ) != m_FileHash.end() );
+}
+
+const ArchiveFile* CArchive::GetFile( VFS_StringView strFileName ) const
+{
+	if( !LoadDirOf( strFileName ) )
+		return NULL;
+
+	ArchiveFileMap::const_iterator iter = m_FileHash.find( strFileName );
+	if( iter == m_FileHash.end() )
+	{
+		SetLastError( VFS_ERROR_NOT_FOUND );
+		return NULL;
 	}
 
-	// Iterate for all Files in the Dir.
-	for( dwIndex = 0; dwIndex < m_Header.Files.size(); dwIndex++ )
+	return GetFileByIndex( ( *iter ).second );
+}
+
+// The Slot of a Dir in the Dir Files Table.
+VFS_DWORD CArchive::GetDirSlot( VFS_DWORD dwDirIndex ) const
+{
+	return dwDirIndex == DIR_INDEX_ROOT ? ( VFS_DWORD )m_Header.Dirs.size() : dwDirIndex;
+}
+
+// The Index of a (loaded) File.
+VFS_DWORD CArchive::GetFileIndex( const ArchiveFile& File ) const
+{
+	VFS_DWORD dwSlot = GetDirSlot( File.dwDirIndex );
+	return m_Header.DirFiles[ dwSlot ].dwFirstFile + ( VFS_DWORD )( &File - &m_Files[ dwSlot ][ 0 ] );
+}
+
+// Get a (loaded) File by its Index (the Dir is looked up in the Dir Files Table; empty Dirs share their First File with the next one).
+const ArchiveFile* CArchive::GetFileByIndex( VFS_DWORD dwIndex ) const
+{
+	VFS_DWORD dwLow = 0, dwHigh = ( VFS_DWORD )m_Header.DirFiles.size();
+	while( dwHigh - dwLow > 1 )
 	{
-		if( m_Header.Files[ dwIndex ].dwDirIndex != dwDirIndex )
-			continue;
+		VFS_DWORD dwMiddle = ( dwLow + dwHigh ) / 2;
+		if( m_Header.DirFiles[ dwMiddle ].dwFirstFile <= dwIndex )
+			dwLow = dwMiddle;
+		else
+			dwHigh = dwMiddle;
+	}
 
-		VFS_EntityInfo Info;
-		Info.bArchived = VFS_TRUE;
-		Info.eType = VFS_FILE;
-		Info.lSize = m_Header.Files[ dwIndex ].dwUncompressedSize;
-		Info.strPath = GetFileNameWithoutExtension() + VFS_PATH_SEPARATOR + m_Header.Files[ dwIndex ].strName;
-		if( !VFS_Util_GetName( Info.strPath, Info.strName ) )
+	return &m_Files[ dwLow ][ dwIndex - m_Header.DirFiles[ dwLow ].dwFirstFile ];
+}
+
+// Load the Files of a Dir (their Records, Checksums and File Block Records are read at once and checked against the Checksum of the Dir).
+VFS_BOOL CArchive::LoadDir( VFS_DWORD dwSlot ) const
+{
+	const ARCHIVE_DIR_FILES& DirFiles = m_Header.DirFiles[ dwSlot ];
+	if( m_Files[ dwSlot ].size() == DirFiles.dwNumFiles )
+		return VFS_TRUE;
+
+	AddStat( STAT_ARCHIVE_DIR_LOADS );
+
+	vector< ARCHIVE_FILE > RawFiles( DirFiles.dwNumFiles );
+	vector< VFS_DWORD > Checksums( DirFiles.dwNumFiles );
+	vector< ARCHIVE_FILE_BLOCK > FileBlocks( DirFiles.dwNumFiles );
+	if( !VFS_File_Seek( m_hFile, m_Header.dwFilesOffset + DirFiles.dwFirstFile * sizeof( ARCHIVE_FILE ), VFS_SET ) ||
+		!VFS_File_Read( m_hFile, ( VFS_BYTE* ) &*RawFiles.begin(), DirFiles.dwNumFiles * sizeof( ARCHIVE_FILE ) ) ||
+		!VFS_File_Seek( m_hFile, m_Header.dwFilesOffset + m_Header.dwNumFiles * sizeof( ARCHIVE_FILE ) + DirFiles.dwFirstFile * sizeof( VFS_DWORD ), VFS_SET ) ||
+		!VFS_File_Read( m_hFile, ( VFS_BYTE* ) &*Checksums.begin(), DirFiles.dwNumFiles * sizeof( VFS_DWORD ) ) ||
+		!VFS_File_Seek( m_hFile, m_Header.dwFileBlocksOffset + DirFiles.dwFirstFile * sizeof( ARCHIVE_FILE_BLOCK ), VFS_SET ) ||
+		!VFS_File_Read( m_hFile, ( VFS_BYTE* ) &*FileBlocks.begin(), DirFiles.dwNumFiles * sizeof( ARCHIVE_FILE_BLOCK ) ) )
+		return VFS_FALSE;
+
+	// Verify the Records.
+	if( VFS_Archive_GetVerifyMode() != VFS_VERIFY_OFF )
+	{
+		VFS_DWORD dwChecksum = CRC32C( 0, ( const VFS_BYTE* ) RawFiles.data(), DirFiles.dwNumFiles * sizeof( ARCHIVE_FILE ) );
+		dwChecksum = CRC32C( dwChecksum, ( const VFS_BYTE* ) Checksums.data(), DirFiles.dwNumFiles * sizeof( VFS_DWORD ) );
+		dwChecksum = CRC32C( dwChecksum, ( const VFS_BYTE* ) FileBlocks.data(), DirFiles.dwNumFiles * sizeof( ARCHIVE_FILE_BLOCK ) );
+		if( dwChecksum != DirFiles.dwChecksum )
+		{
+			AddStat( STAT_CHECKSUM_MISMATCHES );
+			SetLastError( VFS_ERROR_CHECKSUM_MISMATCH );
 			return VFS_FALSE;
+		}
+	}
 
-		if( !pIterationProc( Info, pParam ) )
-			return VFS_TRUE;
+	VFS_QWORD qwArchiveSize = ( VFS_QWORD )VFS_File_GetSize( m_hFile );
+	VFS_DWORD dwDirIndex = dwSlot == m_Header.Dirs.size() ? DIR_INDEX_ROOT : dwSlot;
+	ArchiveFileList Files( DirFiles.dwNumFiles );
+	if( !DecodeFileRecords( m_Header.Dirs, RawFiles.data(), DirFiles.dwNumFiles, Files.data() ) )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return VFS_FALSE;
+	}
+	for( VFS_DWORD dwIndex = 0; dwIndex < DirFiles.dwNumFiles; dwIndex++ )
+	{
+		ArchiveFile& File = Files[ dwIndex ];
+		File.dwDataOffset = FileBlocks[ dwIndex ].dwBlockOffset;
+		File.dwChecksum = Checksums[ dwIndex ];
+		File.dwBlockIndex = FileBlocks[ dwIndex ].dwBlockIndex;
+
+		// The Data of the File has to be in the Archive File, in its Block or in the inline Data.
+		VFS_QWORD qwSize = File.dwBlockIndex == BLOCK_INDEX_NONE ? qwArchiveSize :
+						   File.dwBlockIndex == BLOCK_INDEX_INLINE ? m_Header.InlineData.size() :
+						   File.dwBlockIndex < m_Header.Blocks.size() ? m_Header.Blocks[ File.dwBlockIndex ].dwUncompressedSize : 0;
+		if( File.dwBlockIndex != BLOCK_INDEX_NONE )
+			File.dwCompressedSize = File.dwUncompressedSize;
+		if( File.dwDirIndex != dwDirIndex || ( VFS_QWORD )File.dwDataOffset + File.dwCompressedSize > qwSize ||
+			( File.dwBlockIndex == BLOCK_INDEX_NONE && File.dwDataOffset < m_Header.dwFileDataOffset ) )
+		{
+			SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+			return VFS_FALSE;
+		}
 	}
 
+	m_Files[ dwSlot ].swap( Files );
+	for( VFS_DWORD dwIndex = 0; dwIndex < DirFiles.dwNumFiles; dwIndex++ )
+		m_FileHash[ m_Files[ dwSlot ][ dwIndex ].strName ] = DirFiles.dwFirstFile + dwIndex;
+
 	return VFS_TRUE;
 }
 
-// File Stuff.
-VFS_BOOL CArchive::ContainsFile( const VFS_String& strFileName ) const
+// Load the Files of the Dir of a File.
+VFS_BOOL CArchive::LoadDirOf( VFS_StringView strFileName ) const
 {
-	return strFileName == VFS_TEXT( "" ) ||							// Root Directory
-		   m_Header.FileHash.find( ToLower( strFileName ) ) != m_Header.FileHash.end();
+	VFS_StringView::size_type nPos = strFileName.rfind( VFS_PATH_SEPARATOR );
+	if( nPos == VFS_StringView::npos )
+		return LoadDir( GetDirSlot( DIR_INDEX_ROOT ) );
+
+	ArchiveDirMap::const_iterator iter = m_Header.DirHash.find( strFileName.substr( 0, nPos ) );
+	if( iter == m_Header.DirHash.end() )
+		return VFS_TRUE;
+
+	return LoadDir( GetDirSlot( ( *iter ).second ) );
 }
 
-const ArchiveFile* CArchive::GetFile( const VFS_String& strFileName ) const
+// Load the Files of all Dirs.
+VFS_BOOL CArchive::LoadAllDirs() const
 {
-	if( m_Header.FileHash.find( ToLower( strFileName ) ) == m_Header.FileHash.end() )
+	for( VFS_DWORD dwSlot = 0; dwSlot < m_Files.size(); dwSlot++ )
 	{
-		SetLastError( VFS_ERROR_NOT_FOUND );
-		return NULL;
+		if( !LoadDir( dwSlot ) )
+			return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// Does the stored Data of the File have to be verified (Archives older than Version 1.1 have no Checksums; inline Files are
+// Part of the Index, which is verified when it's read)?
+VFS_BOOL CArchive::NeedsVerification( const ArchiveFile& File, VFS_DWORD dwMode ) const
+{
+	if( !m_Header.bChecksums || dwMode == VFS_VERIFY_OFF || File.dwBlockIndex == BLOCK_INDEX_INLINE )
+		return VFS_FALSE;
+
+	return dwMode == VFS_VERIFY_ALWAYS || !m_Verified[ GetFileIndex( File ) ];
+}
+
+// Verify the stored Data of the File (if the Mode requires it).
+VFS_BOOL CArchive::VerifyFile( const ArchiveFile& File, const VFS_BYTE* pData, VFS_DWORD dwMode ) const
+{
+	if( !NeedsVerification( File, dwMode ) )
+		return VFS_TRUE;
+
+	AddStat( STAT_BYTES_VERIFIED, File.dwCompressedSize );
+	if( CRC32C( 0, pData, File.dwCompressedSize ) != File.dwChecksum )
+	{
+		AddStat( STAT_CHECKSUM_MISMATCHES );
+		SetLastError( VFS_ERROR_CHECKSUM_MISMATCH );
+		return VFS_FALSE;
 	}
 
-	ArchiveFileMap& Hash = const_cast< ArchiveFileMap& >( m_Header.FileHash );
-    VFS_DWORD dwIndex = Hash[ ToLower( strFileName ) ];
-	return &m_Header.Files[ dwIndex ];
+	m_Verified[ GetFileIndex( File ) ] = VFS_TRUE;
+	return VFS_TRUE;
 }
 
 // Extraction.
@@ -305,11 +970,11 @@ VFS_BOOL CArchive::Extract( const VFS_String& strTargetDir ) const
 		return VFS_FALSE;
 	VFS_String strTarget = WithoutTrailingSeparator( Info.strPath, VFS_TRUE ) + VFS_PATH_SEPARATOR;
 
-	// Activate ourselves.
-	if( !const_cast< CArchive* >( this )->Activate() )
+	// Activate ourselves and load all Files (the Threads mustn't load them).
+	if( !const_cast< CArchive* >( this )->Activate() || !LoadAllDirs() )
 		return VFS_FALSE;
 
-	// Extract all Dirs.
+	// Create the Directory Tree first, so the Threads don't have to care about it.
 	VFS_DWORD dwIndex;
 	for( dwIndex = 0; dwIndex <	m_Header.Dirs.size(); dwIndex++ )
 	{
@@ -319,76 +984,287 @@ VFS_BOOL CArchive::Extract( const VFS_String& strTargetDir ) const
 				return VFS_FALSE;
 	}
 
-	// Extract all Files.
-	for( dwIndex = 0; dwIndex <	m_Header.Files.size(); dwIndex++ )
+	// The Threads bypass the Open Files Map, so none of the Target Files may be open.
+	for( dwIndex = 0; dwIndex <	m_Header.dwNumFiles; dwIndex++ )
+	{
+		if( GetOpenFiles().find( ToLower( strTarget + GetFileByIndex( dwIndex )->strName ) ) != GetOpenFiles().end() )
+		{
+			SetLastError( VFS_ERROR_IN_USE );
+			return VFS_FALSE;
+		}
+	}
+
+	// Prepare the Job.
+	IFile* pArchiveFile = ( IFile* )( VFS_DWORD )m_hFile;
+	ExtractionJob Job;
+	Job.pArchive = this;
+	Job.strTarget = strTarget;
+	Job.dwNumFiles = m_Header.dwNumFiles;
+	Job.dwNextFile = 0;
+	Job.bFailed = false;
+	Job.eError = VFS_ERROR_NONE;
+
+	// Get the Number of Threads (we don't need more Threads than Files).
+	VFS_DWORD dwThreads = VFS_Archive_GetExtractionThreads();
+	if( dwThreads == 0 )
+		dwThreads = thread::hardware_concurrency();
+	if( dwThreads > Job.dwNumFiles )
+		dwThreads = Job.dwNumFiles;
+	if( dwThreads == 0 )
+		dwThreads = 1;
+
+	// Filters needn't be reentrant (they keep the Data of the active Archive), so filtered Archives are extracted by the calling
+	// Thread only; so are Archives inside other Archives, there's no Standard File the Threads could open.
+	if( !m_Header.Filters.empty() || pArchiveFile->IsArchived() )
+		dwThreads = 1;
+	Job.pSource = dwThreads == 1 ? pArchiveFile : NULL;
+	if( Job.pSource == NULL )
+		Job.strSource = static_cast< CStdIOFile* >( pArchiveFile )->GetPath();
+
+	// Start the Threads (the calling Thread is one of them).
+	vector< thread > Threads;
+	for( dwIndex = 1; dwIndex < dwThreads; dwIndex++ )
 	{
-		VFS_String strFileName = strTarget + m_Header.Files[ dwIndex ].strName;
+		try
+		{
+			Threads.push_back( thread( ExtractionThread, &Job ) );
+		}
+		catch( ... )
+		{
+			break;
+		}
+	}
+	ExtractionThread( &Job );
+	for( vector< thread >::iterator iter = Threads.begin(); iter != Threads.end(); iter++ )
+		( *iter ).join();
+
+	if( Job.bFailed )
+	{
+		SetLastError( Job.eError );
+		return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
 
-		// Read in the File.
-		if( !VFS_File_Seek( m_hFile, m_Header.Files[ dwIndex ].dwDataOffset, VFS_SET ) )
+// Extract a single File.
+VFS_BOOL CArchive::ExtractFile( IFile* pSource, VFS_DWORD dwIndex, const VFS_String& strTarget ) const
+{
+	const ArchiveFile& File = *GetFileByIndex( dwIndex );
+	VFS_String strFileName = strTarget + File.strName;
+
+	// Unfiltered Files are copied straight from their Byte Range in the Archive (inside the Kernel if possible) unless they have to be verified
+	// or the Archive File is itself archived.
+	VFS_DWORD dwVerifyMode = GetVerifyMode( 0 );
+	if( m_Header.Filters.empty() && File.dwBlockIndex == BLOCK_INDEX_NONE && !pSource->IsArchived() && !NeedsVerification( File, dwVerifyMode ) )
+	{
+		CStdIOFile* pTarget = static_cast< CStdIOFile* >( CStdIOFile::Create( strFileName, VFS_WRITE ) );
+		if( pTarget == NULL )
 			return VFS_FALSE;
-		g_FromBuffer.resize( m_Header.Files[ dwIndex ].dwCompressedSize );
-		if( !VFS_File_Read( m_hFile, &*g_FromBuffer.begin(), m_Header.Files[ dwIndex ].dwCompressedSize ) )
+
+		VFS_BOOL bResult = static_cast< CStdIOFile* >( pSource )->CopyRange( pTarget, File.dwDataOffset, File.dwCompressedSize, 0 );
+		pTarget->Release();
+
+		return bResult;
+	}
+
+	// Get the decoded Data.
+	const VFS_BYTE* pData;
+	VFS_DWORD dwSize;
+	DecodedBlock pBlock;
+	if( !DecodeFile( pSource, File, dwVerifyMode, g_FromBuffer, pData, dwSize, pBlock ) )
+		return VFS_FALSE;
+
+	// Create the Target File (directly, the Open Files Map isn't thread-safe).
+	IFile* pTarget = CStdIOFile::Create( strFileName, VFS_WRITE );
+	if( pTarget == NULL )
+		return VFS_FALSE;
+
+	// Reserve the Space and write the Data.
+	VFS_BOOL bResult = pTarget->Preallocate( ( VFS_LONG )dwSize ) &&
+		pTarget->Write( pData, dwSize, NULL );
+
+	// Close the Target File.
+	pTarget->Release();
+
+	return bResult;
+}
+
+// Get a decoded Solid Block.
+DecodedBlock CArchive::LoadBlock( IFile* pSource, VFS_DWORD dwIndex, VFS_DWORD dwVerifyMode ) const
+{
+	DecodedBlock pBlock = GetCachedBlock( this, dwIndex );
+	if( pBlock )
+	{
+		AddStat( STAT_BLOCK_CACHE_HITS );
+		return pBlock;
+	}
+	AddStat( STAT_BLOCK_CACHE_MISSES );
+
+	// Read in the Block.
+	const ArchiveBlock& Block = m_Header.Blocks[ dwIndex ];
+	g_FromBuffer.resize( Block.dwCompressedSize );
+	VFS_DWORD dwRead;
+	if( !pSource->Seek( Block.dwDataOffset, VFS_SET ) || !pSource->Read( g_FromBuffer.data(), Block.dwCompressedSize, &dwRead ) )
+		return DecodedBlock();
+	if( dwRead != Block.dwCompressedSize )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return DecodedBlock();
+	}
+
+	// Check the stored Data each Time the Block is loaded (unless Verification is off; the Members are checked when they are read).
+	if( dwVerifyMode != VFS_VERIFY_OFF )
+	{
+		AddStat( STAT_BYTES_VERIFIED, Block.dwCompressedSize );
+		if( CRC32C( 0, g_FromBuffer.data(), Block.dwCompressedSize ) != Block.dwChecksum )
+		{
+			AddStat( STAT_CHECKSUM_MISMATCHES );
+			SetLastError( VFS_ERROR_CHECKSUM_MISMATCH );
+			return DecodedBlock();
+		}
+	}
+
+	// Apply the Filters (a Block has no Name of its own, so the Filters get the one of the Archive).
+	VFS_EntityInfo Info;
+	Info.bArchived = VFS_TRUE;
+	Info.eType = VFS_FILE;
+	Info.lSize = Block.dwCompressedSize;
+	Info.strPath = GetFileNameWithoutExtension();
+	VFS_Util_GetName( Info.strPath, Info.strName );
+	if( !DecodeBuffer( Info ) )
+		return DecodedBlock();
+	if( g_FromBuffer.size() != Block.dwUncompressedSize )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return DecodedBlock();
+	}
+
+	pBlock = make_shared< const vector< VFS_BYTE > >( g_FromBuffer );
+	CacheBlock( this, dwIndex, pBlock );
+	return pBlock;
+}
+
+// Get the decoded Data of a File.
+VFS_BOOL CArchive::DecodeFile( IFile* pSource, const ArchiveFile& File, VFS_DWORD dwVerifyMode, vector< VFS_BYTE >& Buffer,
+							   const VFS_BYTE*& pData, VFS_DWORD& dwSize, DecodedBlock& pBlock ) const
+{
+	dwSize = File.dwUncompressedSize;
+
+	// Inline Files are in the Index already.
+	if( File.dwBlockIndex == BLOCK_INDEX_INLINE )
+	{
+		pData = m_Header.InlineData.data() + File.dwDataOffset;
+		return VFS_TRUE;
+	}
+
+	// Members of Solid Blocks are in their decoded Block.
+	if( File.dwBlockIndex != BLOCK_INDEX_NONE )
+	{
+		pBlock = LoadBlock( pSource, File.dwBlockIndex, dwVerifyMode );
+		if( !pBlock )
 			return VFS_FALSE;
+		pData = pBlock->data() + File.dwDataOffset;
+		return VerifyFile( File, pData, dwVerifyMode );
+	}
 
-		// Apply the Filters.
+	// Read in the File.
+	Buffer.resize( File.dwCompressedSize );
+	if( !ReadStoredFile( pSource, File, dwVerifyMode, Buffer.data() ) )
+		return VFS_FALSE;
+
+	// Apply the Filters (the Buffer is swapped in and out, so the Data isn't copied; it may be the From Buffer itself).
+	if( !m_Header.Filters.empty() )
+	{
 		VFS_EntityInfo Info;
 		Info.bArchived = VFS_TRUE;
 		Info.eType = VFS_FILE;
-		Info.lSize = m_Header.Files[ dwIndex ].dwCompressedSize;
-		Info.strPath = GetFileNameWithoutExtension() + VFS_PATH_SEPARATOR + m_Header.Files[ dwIndex ].strName;
+		Info.lSize = File.dwCompressedSize;
+		Info.strPath = GetFileNameWithoutExtension() + VFS_PATH_SEPARATOR + File.strName;
 		VFS_Util_GetName( Info.strPath, Info.strName );
 
-		for( VFS_DWORD dwFilter = 0; dwFilter != m_Header.Filters.size(); dwFilter++ )
-		{
-			g_FromPos = 0;
-			if( !m_Header.Filters[ dwFilter ]->Decode( Reader, Writer, Info ) )
-			{
-				VFS_ErrorCode eError = VFS_GetLastError();
-				if( eError == VFS_ERROR_NONE )
-					eError = VFS_ERROR_GENERIC;
-				SetLastError( eError );
-				return VFS_FALSE;
-			}
-			g_FromBuffer = g_ToBuffer;
-			g_ToBuffer.clear();
-		}
-
-		// Create the Target File.
-		VFS_Handle hFile = VFS_File_Create( strFileName, VFS_WRITE );
-		if( hFile == VFS_INVALID_HANDLE_VALUE )
+		g_FromBuffer.swap( Buffer );
+		VFS_BOOL bResult = DecodeBuffer( Info );
+		g_FromBuffer.swap( Buffer );
+		if( !bResult )
 			return VFS_FALSE;
+	}
 
-		// Write the Data.
-		if( !VFS_File_Write( hFile, &*g_FromBuffer.begin(), ( VFS_DWORD )g_FromBuffer.size() ) )
-			return VFS_FALSE;
+	pData = Buffer.data();
+	dwSize = ( VFS_DWORD )Buffer.size();
+	return VFS_TRUE;
+}
 
-		// Close the Target File.
-		if( !VFS_File_Close( hFile ) )
+// Read the stored Data of a File.
+VFS_BOOL CArchive::ReadStoredFile( IFile* pSource, const ArchiveFile& File, VFS_DWORD dwVerifyMode, VFS_BYTE* pBuffer ) const
+{
+	VFS_QWORD qwReadStart = GetTimeStamp();
+	VFS_DWORD dwRead;
+	if( !pSource->Seek( File.dwDataOffset, VFS_SET ) || !pSource->Read( pBuffer, File.dwCompressedSize, &dwRead ) )
+		return VFS_FALSE;
+	if( dwRead != File.dwCompressedSize )
+	{
+		SetLastError( VFS_ERROR_INVALID_ARCHIVE_FORMAT );
+		return VFS_FALSE;
+	}
+	AddLatency( VFS_OP_ARCHIVE_READ, GetTimeStamp() - qwReadStart );
+
+	// Check the Data before the Filters get to see it.
+	return VerifyFile( File, pBuffer, dwVerifyMode );
+}
+
+// Run the Data in the From Buffer through the Filters (the Result is in the From Buffer again).
+VFS_BOOL CArchive::DecodeBuffer( const VFS_EntityInfo& Info ) const
+{
+	VFS_QWORD qwStart = GetTimeStamp();
+	for( VFS_DWORD dwFilter = 0; dwFilter != m_Header.Filters.size(); dwFilter++ )
+	{
+		g_FromPos = 0;
+		if( !m_Header.Filters[ dwFilter ]->Decode( Reader, Writer, Info ) )
+		{
+			VFS_ErrorCode eError = VFS_GetLastError();
+			if( eError == VFS_ERROR_NONE )
+				eError = VFS_ERROR_GENERIC;
+			SetLastError( eError );
 			return VFS_FALSE;
+		}
+		g_FromBuffer.swap( g_ToBuffer );
+		g_ToBuffer.clear();
+	}
+	if( !m_Header.Filters.empty() )
+	{
+		VFS_QWORD qwDecodeTime = GetTimeStamp() - qwStart;
+		AddStat( STAT_DECODE_NANOSECONDS, qwDecodeTime );
+		AddLatency( VFS_OP_DECODE, qwDecodeTime );
+		AddStat( STAT_BYTES_DECODED, g_FromBuffer.size() );
 	}
 
 	return VFS_TRUE;
 }
 
 // Activation.
-VFS_BOOL CArchive::Activate()
+VFS_BOOL CArchive::Activate( const VFS_BYTE* pConfigData )
 {
 	if( m_pActive == this )
 		return VFS_TRUE;
 
-	VFS_DWORD dwDataOffset = m_Header.dwDataOffset;
-	if( !VFS_File_Seek( m_hFile, dwDataOffset, VFS_SET ) )
-		return VFS_FALSE;
-	FilterList::const_iterator iter;
-	for( iter = m_Header.Filters.begin(); iter != m_Header.Filters.end(); iter++ )
+	// Read in the Filter Data (unless it's passed).
+	vector< VFS_BYTE > ConfigData;
+	if( pConfigData == NULL )
 	{
-		g_FromBuffer.resize( ( *iter )->GetConfigDataSize() );
-		if( !VFS_File_Read( m_hFile, &*g_FromBuffer.begin(), ( VFS_DWORD )g_FromBuffer.size() ) )
+		ConfigData.resize( m_Header.dwFileDataOffset - m_Header.dwDataOffset );
+		if( !ConfigData.empty() && ( !VFS_File_Seek( m_hFile, m_Header.dwDataOffset, VFS_SET ) ||
+			!VFS_File_Read( m_hFile, ConfigData.data(), ( VFS_DWORD )ConfigData.size() ) ) )
 			return VFS_FALSE;
-		dwDataOffset += ( *iter )->GetConfigDataSize();
+		pConfigData = ConfigData.data();
+	}
+
+	for( VFS_DWORD dwFilter = 0; dwFilter < m_Header.Filters.size(); dwFilter++ )
+	{
+		g_FromBuffer.assign( pConfigData, pConfigData + m_Header.FilterConfigSizes[ dwFilter ] );
+		pConfigData += m_Header.FilterConfigSizes[ dwFilter ];
 		g_FromPos = 0;
-		( *iter )->LoadConfigData( Reader );
+		m_Header.Filters[ dwFilter ]->LoadConfigData( Reader );
 	}
 
 	m_pActive = this;
@@ -396,6 +1272,11 @@ VFS_BOOL CArchive::Activate()
 	return VFS_TRUE;
 }
 
+void CArchive::Deactivate()
+{
+	m_pActive = NULL;
+}
+
 // Open an Archive.
 CArchive* CArchive::Open( const VFS_String& strAbsoluteFileName )
 {
@@ -412,10 +1293,20 @@ CArchive* CArchive::Open( const VFS_String& strAbsoluteFileName )
 	return pArchive;
 }
 
-// Check the File Existence.
+// Check the File Existence (under the given Name or the lower-cased one, like Open() does, since the VFS creates its Archives
+// with lower-cased Names).
 VFS_BOOL CArchive::Exists( const VFS_String& strAbsoluteFileName )
 {
-	return VFS_EXISTS( CheckExtension( strAbsoluteFileName ) );
+	VFS_String strFileName = CheckExtension( strAbsoluteFileName );
+	AddStat( STAT_SYSCALLS );
+	if( VFS_EXISTS( strFileName ) )
+		return VFS_TRUE;
+
+	VFS_String strLowerFileName = ToLower( strFileName );
+	if( strLowerFileName == strFileName )
+		return VFS_FALSE;
+	AddStat( STAT_SYSCALLS );
+	return VFS_EXISTS( strLowerFileName );
 }
 
 // Check / modify the Archive Extension.
@@ -424,8 +1315,7 @@ VFS_String CArchive::CheckExtension( VFS_String strFileName )
 	static const VFS_String RIGHT( VFS_String( VFS_TEXT( "." ) ) + VFS_ARCHIVE_FILE_EXTENSION );
 
 	if( strFileName.size() < RIGHT.size() ||
-		ToLower( strFileName.substr( strFileName.size() - RIGHT.size(), RIGHT.size() ) ) !=
-			ToLower( RIGHT ) )
+		!EqualsNoCase( VFS_StringView( strFileName ).substr( strFileName.size() - RIGHT.size() ), RIGHT ) )
 		return strFileName + VFS_TEXT( "." ) + VFS_ARCHIVE_FILE_EXTENSION;
 	return strFileName;
 }
@@ -439,15 +1329,14 @@ VFS_BOOL Reader( VFS_BYTE* pBuffer, VFS_DWORD dwBytesToRead, VFS_DWORD* pBytesRe
 	if( dwBytesToRead > 0 && g_FromPos >= g_FromBuffer.size() )
 		return VFS_FALSE;
 
+	VFS_DWORD dwRead = ( VFS_DWORD )g_FromBuffer.size() - g_FromPos;
+	if( dwRead > dwBytesToRead )
+		dwRead = dwBytesToRead;
+	if( dwRead > 0 )
+		memcpy( pBuffer, g_FromBuffer.data() + g_FromPos, dwRead );
+	g_FromPos += dwRead;
 	if( pBytesRead )
-		*pBytesRead = 0;
-	for( VFS_DWORD i = 0; ( i < dwBytesToRead ) && ( g_FromPos < g_FromBuffer.size() ); i++ )
-	{
-		pBuffer[ i ] = g_FromBuffer[ g_FromPos ];
-		g_FromPos++;
-		if( pBytesRead )
-			( *pBytesRead )++;
-	}
+		*pBytesRead = dwRead;
 
 	return VFS_TRUE;
 }
@@ -457,10 +1346,7 @@ VFS_BOOL Writer( const VFS_BYTE* pBuffer, VFS_DWORD dwBytesToWrite, VFS_DWORD* p
 	if( pBuffer == NULL )
 		return VFS_FALSE;
 
-	for( VFS_DWORD i = 0; i < dwBytesToWrite; i++ )
-	{
-		g_ToBuffer.push_back( pBuffer[ i ] );
-	}
+	g_ToBuffer.insert( g_ToBuffer.end(), pBuffer, pBuffer + dwBytesToWrite );
 
 	if( pBytesWritten )
 		*pBytesWritten = dwBytesToWrite;
@@ -47,18 +47,18 @@ static VFS_String StripArchiveExtension( const VFS_String& strArchive );
 //============================================================================
 static VFS_String StripArchiveExtension( const VFS_String& strArchive )
 {
-	VFS_String ToRemove = VFS_String( VFS_TEXT( "." ) ) + ToLower( VFS_ARCHIVE_FILE_EXTENSION );
-	VFS_String strResult = ToLower( strArchive );
+	static const VFS_String ToRemove = VFS_String( VFS_TEXT( "." ) ) + VFS_ARCHIVE_FILE_EXTENSION;
+	VFS_StringView strResult = strArchive;
 
 	if( strResult.size() >= ToRemove.size() )
 	{
-		if( strResult.substr( strResult.size() - ToRemove.size(), ToRemove.size() ) == ToRemove )
+		if( EqualsNoCase( strResult.substr( strResult.size() - ToRemove.size() ), ToRemove ) )
 		{
 			strResult = strResult.substr( 0, strResult.size() - ToRemove.size() );
 		}
 	}
 
-	return strResult;
+	return ToLower( strResult );
 }
 
 //============================================================================
@@ -66,7 +66,7 @@ static VFS_String StripArchiveExtension( const VFS_String& strArchive )
 //============================================================================
 /// --- Archive File Class ---
 // Constructor / Destructor.
-CArchiveFile::CArchiveFile( const CArchive* pArchive, const VFS_String& strFileName, VFS_BOOL bOpen )
+CArchiveFile::CArchiveFile( const CArchive* pArchive, const VFS_String& strFileName, VFS_BOOL bOpen, VFS_DWORD dwVerifyMode )
 : IFile( pArchive ? ( StripArchiveExtension( pArchive->GetFileName() ) + VFS_PATH_SEPARATOR + strFileName ) : VFS_TEXT( "(invalid)" ) )
 {
 	// Invalid Archive Pointer?
@@ -96,64 +96,39 @@ CArchiveFile::CArchiveFile( const CArchive* pArchive, const VFS_String& strFileN
 
 		// Set the Member Variables.
 		m_pArchive = pArchive;
-		m_pArchiveFile = pArchive->GetFile( strFileName );
-		if( m_pArchiveFile == NULL )
+		const ArchiveFile* pArchiveFile = pArchive->GetFile( strFileName );
+		if( pArchiveFile == NULL )
 		{
 			m_pArchive = NULL;
 			return;
 		}
 
-		// Activate the Archive.
-		const_cast< CArchive* >( m_pArchive )->Activate();
+		m_dwPos = 0;
 
-		// Read in the File.
-		if( !VFS_File_Seek( m_pArchive->GetFile(), m_pArchiveFile->dwDataOffset, VFS_SET ) )
-		{
-			m_pArchive = NULL;
-			return;
-		}
-		g_FromBuffer.resize( m_pArchiveFile->dwCompressedSize );
-		if( !VFS_File_Read( m_pArchive->GetFile(), &*g_FromBuffer.begin(), m_pArchiveFile->dwCompressedSize ) )
+		// Activate the Archive (no Filters are applied to inline Files).
+		if( pArchiveFile->dwBlockIndex != BLOCK_INDEX_INLINE )
+			const_cast< CArchive* >( m_pArchive )->Activate();
+
+		// Decode the File (a File which is neither inline nor in a Solid Block is decoded right in our Buffer, the others are copied).
+		IFile* pSource = ( IFile* )( VFS_DWORD )m_pArchive->GetFile();
+		const VFS_BYTE* pData;
+		VFS_DWORD dwSize;
+		DecodedBlock pBlock;
+		if( !m_pArchive->DecodeFile( pSource, *pArchiveFile, dwVerifyMode, m_Data, pData, dwSize, pBlock ) )
 		{
 			m_pArchive = NULL;
 			return;
 		}
-
-		// Apply the Filters.
-		VFS_EntityInfo Info;
-		Info.bArchived = VFS_TRUE;
-		Info.eType = VFS_FILE;
-		Info.lSize = m_pArchiveFile->dwCompressedSize;
-		Info.strPath = strFileName;
-		VFS_Util_GetName( Info.strPath, Info.strName );
-
-		for( VFS_DWORD dwFilter = 0; dwFilter != m_pArchive->GetHeader()->Filters.size(); dwFilter++ )
-		{
-			g_FromPos = 0;
-			if( !m_pArchive->GetHeader()->Filters[ dwFilter ]->Decode( Reader, Writer, Info ) )
-			{
-				VFS_ErrorCode eError = VFS_GetLastError();
-				if( eError == VFS_ERROR_NONE )
-					eError = VFS_ERROR_GENERIC;
-				SetLastError( eError );
-				m_pArchive = NULL;
-				return;
-			}
-			g_FromBuffer = g_ToBuffer;
-			g_ToBuffer.clear();
-		}
-
-        // Et voila...
-		m_Data = g_FromBuffer;
-
-		// Set some Helper Variables...
-		m_dwPos = 0;
+		if( pData != m_Data.data() )
+			m_Data.assign( pData, pData + dwSize );
 	}
 }
 
 CArchiveFile::~CArchiveFile()
 {
-	// Just do nothing.
+	// Let the Archive go.
+	if( m_pArchive != NULL )
+		m_pArchive->Release();
 }
 
 // Is the File valid?
@@ -234,6 +209,12 @@ VFS_BOOL CArchiveFile::Resize( VFS_LONG lSize )
 	return VFS_FALSE;
 }
 
+VFS_BOOL CArchiveFile::Preallocate( VFS_LONG lSize )
+{
+	SetLastError( VFS_ERROR_CANT_MANIPULATE_ARCHIVES );
+	return VFS_FALSE;
+}
+
 VFS_LONG CArchiveFile::GetSize() const
 {
 	return ( VFS_LONG )m_Data.size();
@@ -258,18 +239,28 @@ IFile* CArchiveFile::Open( const VFS_String& strAbsoluteFileName, VFS_DWORD dwFl
 		return NULL;
 	}
 
-	CArchiveFile* pFile = new CArchiveFile( pArchive, strFileName, VFS_TRUE );
+	CArchiveFile* pFile = new CArchiveFile( pArchive, strFileName, VFS_TRUE, GetVerifyMode( dwFlags ) );
 	if( !pFile->IsValid() )
 	{
 		delete pFile;
 		return NULL;
 	}
 
+	// The Archive stays open as long as the File is.
+	pArchive->AddRef();
+
+	AddStat( STAT_ARCHIVE_FILE_OPENS );
 	return pFile;
 }
 
-VFS_BOOL CArchiveFile::Exists( const VFS_String& strAbsoluteFileName, CArchive** ppArchive, VFS_String* pFileName )
+VFS_BOOL CArchiveFile::Exists( VFS_StringView strAbsoluteFileName, CArchive** ppArchive, VFS_String* pFileName )
 {
+	COperationTimer Timer( VFS_OP_ARCHIVE_LOOKUP );
+
+	// The Archives and their Files are stored lower-cased (we don't have to copy the Name if it's lower-cased already).
+	VFS_String strStorage;
+	strAbsoluteFileName = ToLowerView( strAbsoluteFileName, strStorage );
+
 	// Parse the File Name.
 	// For instance if we have
 	// /alpha/beta/gamma.txt
@@ -280,31 +271,33 @@ VFS_BOOL CArchiveFile::Exists( const VFS_String& strAbsoluteFileName, CArchive**
 		if( strAbsoluteFileName[ dwIndex ] == VFS_PATH_SEPARATOR && dwIndex != 0 &&
 		    ( dwIndex != 2 || ( !isalpha( strAbsoluteFileName[ 0 ] ) || strAbsoluteFileName[ 1 ] != VFS_TEXT( ':' ) ) ) )
 		{
-			VFS_String strArchive = ToLower( strAbsoluteFileName.substr( 0, dwIndex ) );
-			VFS_String strSecond = ToLower( strAbsoluteFileName.substr( dwIndex + 1 ) );
+			VFS_StringView strArchive = strAbsoluteFileName.substr( 0, dwIndex );
+			VFS_StringView strSecond = strAbsoluteFileName.substr( dwIndex + 1 );
+
+			// Open the Archive if it isn't open yet (only then we have to look for its File).
+			ArchiveMap::iterator iter = GetOpenArchives().find( strArchive );
+			if( iter == GetOpenArchives().end() )
+			{
+				VFS_String strArchiveName( strArchive );
+				if( !VFS_File_Exists( strArchiveName + VFS_TEXT( "." ) + VFS_ARCHIVE_FILE_EXTENSION ) )
+					continue;
+
+				CArchive* pArchive = CArchive::Open( strArchiveName );
+				if( pArchive == NULL )
+					return VFS_FALSE;
+				iter = AddOpenArchive( strArchiveName, pArchive );
+			}
 
-			if( VFS_File_Exists( strArchive + VFS_TEXT( "." ) + VFS_ARCHIVE_FILE_EXTENSION ) )
+			// Check if it contains such a File.
+			if( ( *iter ).second->ContainsFile( strSecond ) )
 			{
-				// Open the Archive if it isn't open yet.
-				if( GetOpenArchives().find( strArchive ) == GetOpenArchives().end() )
-				{
-					CArchive* pArchive = CArchive::Open( strArchive );
-					if( pArchive == NULL )
-						return VFS_FALSE;
-					GetOpenArchives()[ strArchive ] = pArchive;
-				}
-
-				// Check if it contains such a File.
-				if( GetOpenArchives()[ strArchive ]->ContainsFile( strSecond ) )
-				{
-					// Success.
-					if( ppArchive )
-						*ppArchive = GetOpenArchives()[ strArchive ];
-					if( pFileName )
-						*pFileName = strSecond;
-
-					return VFS_TRUE;
-				}
+				// Success.
+				if( ppArchive )
+					*ppArchive = ( *iter ).second;
+				if( pFileName )
+					pFileName->assign( strSecond.data(), strSecond.size() );
+
+				return VFS_TRUE;
 			}
 		}
 	}
@@ -15,6 +15,8 @@
 //    IMPLEMENTATION HEADERS
 //============================================================================
 #include "VFS_Implementation.h"
+#include <list>
+#include <mutex>
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
@@ -25,14 +27,46 @@
 //============================================================================
 //    IMPLEMENTATION PRIVATE STRUCTURES / UTILITY CLASSES
 //============================================================================
+// A Block in the Block Cache.
+typedef pair< const CArchive*, VFS_DWORD > BlockKey;
+struct CachedBlock {
+	BlockKey Key;
+	DecodedBlock Block;
+};
+typedef list< CachedBlock > BlockCacheList;
+
 //============================================================================
 //    IMPLEMENTATION REQUIRED EXTERNAL REFERENCES (AVOID)
 //============================================================================
 //============================================================================
 //    IMPLEMENTATION PRIVATE DATA
 //============================================================================
-// The Open Archives.
+// The Open Archives (unreferenced Archives beyond the Maximum are closed, the least recently used first).
 static ArchiveMap g_OpenArchives;
+static VFS_DWORD g_dwMaxOpenArchives = 256;
+
+// The Number of Extraction Threads (0 = one per Core).
+static VFS_DWORD g_dwExtractionThreads = 0;
+
+// The default Checksum Verification Mode.
+static VFS_DWORD g_dwVerifyMode = VFS_VERIFY_FIRST_READ;
+
+// The Solid Block Settings.
+static VFS_DWORD g_dwSolidBlockSize = 0;
+static VFS_DWORD g_dwSolidFileSizeLimit = 4 * 1024;
+
+// Files up to this Size are stored in the Index (0 = none).
+static VFS_DWORD g_dwInlineFileSizeLimit = 0;
+
+// The maximum Amount of Sample Data the Filters are trained with (0 = no Training).
+static VFS_DWORD g_dwTrainingSampleSize = 0;
+
+// The Block Cache (the most recently used Block comes first; the Extraction Threads use it, too, so it's locked).
+static BlockCacheList g_BlockCache;
+static map< BlockKey, BlockCacheList::iterator > g_BlockCacheMap;
+static VFS_DWORD g_dwBlockCacheFill = 0;
+static VFS_DWORD g_dwBlockCacheSize = 4 * 1024 * 1024;
+static mutex g_BlockCacheMutex;
 
 //============================================================================
 //    INTERFACE DATA
@@ -40,56 +74,182 @@ static ArchiveMap g_OpenArchives;
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
 //============================================================================
+typedef vector< VFS_FileNameMap::const_iterator > LayoutOrder;
+static void GetLayoutOrder( const VFS_FileNameMap& Files, const VFS_FileNameList& AccessOrder, LayoutOrder& Order );
+static VFS_BOOL SourceFileExists( const VFS_String& strFileName );
+static VFS_BOOL ReadSourceFile( const VFS_String& strFileName, vector< VFS_BYTE >& Data, VFS_EntityInfo* pInfo = NULL );
+static VFS_BOOL CreateArchive( const VFS_String& strArchiveFileName, const VFS_FileNameMap& Files, const CHashMap< VFS_LONG >* pSourceSizes,
+							   const VFS_FilterNameList& UsedFilters, const VFS_FileNameList& AccessOrder );
+static VFS_BOOL EncodeBuffer( const VFS_FilterList& Filters, const VFS_EntityInfo& Info );
+static void TrimBlockCache();
+static void TrimOpenArchives( VFS_DWORD dwRoom );
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTIONS
 //============================================================================
-//============================================================================
-//    INTERFACE FUNCTIONS
-//============================================================================
-// Create an Archive.
-
-// Create an Archive from the specified Source Directory.
-VFS_BOOL VFS_Archive_CreateFromDirectory( const VFS_String& strArchiveFileName, const VFS_String& strDirName, const VFS_FilterNameList& UsedFilters, VFS_BOOL bRecursive )
+// Orders the Files for the Data Layout: the Files of the Access Order come first (in that Order, each at its first Access),
+// the others follow in Name Order. Access Order Entries may be Source File Names or In-Archive Names with any Prefix (so
+// the Paths of a recorded Trace, like "data/pack/alpha/beta.txt" for "alpha/beta.txt", can be used directly).
+static void GetLayoutOrder( const VFS_FileNameMap& Files, const VFS_FileNameList& AccessOrder, LayoutOrder& Order )
 {
-	// Not initialized yet?
-	if( !IsInit() )
+	Order.clear();
+	Order.reserve( Files.size() );
+
+	LayoutOrder ByIndex;
+	ByIndex.reserve( Files.size() );
+	CHashMap< VFS_DWORD > SourceNames, ArchivedNames;
+	SourceNames.reserve( Files.size() );
+	ArchivedNames.reserve( Files.size() );
+	for( VFS_FileNameMap::const_iterator iter = Files.begin(); iter != Files.end(); iter++ )
 	{
-		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
-		return VFS_FALSE;
+		SourceNames[ ( *iter ).first ] = ( VFS_DWORD )ByIndex.size();
+		ArchivedNames[ ( *iter ).second ] = ( VFS_DWORD )ByIndex.size();
+		ByIndex.push_back( iter );
 	}
 
-	// Get the Directory Contents.
-	VFS_EntityInfoList EntityInfos;
-	if( !VFS_Dir_GetContents( strDirName, EntityInfos, bRecursive ) )
+	// Place the Files in the Access Order.
+	vector< VFS_BYTE > Placed( ByIndex.size(), VFS_FALSE );
+	for( VFS_FileNameList::const_iterator iter2 = AccessOrder.begin(); iter2 != AccessOrder.end(); iter2++ )
+	{
+		VFS_StringView strName = *iter2;
+		CHashMap< VFS_DWORD >::const_iterator found = SourceNames.find( strName );
+		if( found == SourceNames.end() )
+		{
+			// Strip one leading Path Component after the other.
+			found = ArchivedNames.find( strName );
+			while( found == ArchivedNames.end() && strName.find( VFS_PATH_SEPARATOR ) != VFS_StringView::npos )
+			{
+				strName.remove_prefix( strName.find( VFS_PATH_SEPARATOR ) + 1 );
+				found = ArchivedNames.find( strName );
+			}
+			if( found == ArchivedNames.end() )
+				continue;
+		}
+
+		if( !Placed[ ( *found ).second ] )
+		{
+			Placed[ ( *found ).second ] = VFS_TRUE;
+			Order.push_back( ByIndex[ ( *found ).second ] );
+		}
+	}
+
+	// Append the others.
+	for( VFS_DWORD dwIndex = 0; dwIndex < ByIndex.size(); dwIndex++ )
+	{
+		if( !Placed[ dwIndex ] )
+			Order.push_back( ByIndex[ dwIndex ] );
+	}
+}
+
+// Check if a Source File exists (Standard Files are only looked up in the File System instead of being opened; the Source Files
+// aren't added to the Access Trace).
+static VFS_BOOL SourceFileExists( const VFS_String& strFileName )
+{
+	if( VFS_Util_IsAbsoluteFileName( strFileName ) && CStdIOFile::Exists( strFileName ) )
+		return !VFS_IS_DIR( strFileName );
+
+	VFS_Handle hSrc = OpenFile( VFS_Path( strFileName ), VFS_READ );
+	if( hSrc == VFS_INVALID_HANDLE_VALUE )
 		return VFS_FALSE;
+	return VFS_File_Close( hSrc );
+}
 
-	// Get the absolute Path of the Directory.
-	VFS_EntityInfo Info;
-	if( !VFS_Dir_GetInfo( strDirName, Info ) )
+// Append a Source File to the Data (it's read straight into the Buffer with a single Read).
+static VFS_BOOL ReadSourceFile( const VFS_String& strFileName, vector< VFS_BYTE >& Data, VFS_EntityInfo* pInfo )
+{
+	VFS_Handle hSrc = OpenFile( VFS_Path( strFileName ), VFS_READ );
+	if( hSrc == VFS_INVALID_HANDLE_VALUE )
 		return VFS_FALSE;
 
-	// Get the Start Position for the In-Archive Name.
-	VFS_INT nStart = ( VFS_INT )Info.strPath.size();
-	if( !IsRootDir( Info.strPath ) )
-		nStart++;
+	// The Information for the Filters is taken from the open File.
+	if( pInfo != NULL && !VFS_File_GetInfo( hSrc, *pInfo ) )
+	{
+		VFS_File_Close( hSrc );
+		return VFS_FALSE;
+	}
 
-	// Make a File Name List out of the Entity Info List.
-	VFS_FileNameMap Files;
-	for( VFS_EntityInfoList::iterator iter = EntityInfos.begin(); iter != EntityInfos.end(); iter++ )
+	VFS_DWORD dwStart = ( VFS_DWORD )Data.size();
+	VFS_LONG lSize = VFS_File_GetSize( hSrc );
+	VFS_DWORD dwRead = 0;
+	if( lSize > 0 )
+	{
+		Data.resize( dwStart + lSize );
+		if( !VFS_File_Read( hSrc, Data.data() + dwStart, ( VFS_DWORD )lSize, &dwRead ) )
+		{
+			Data.resize( dwStart );
+			VFS_File_Close( hSrc );
+			return VFS_FALSE;
+		}
+	}
+	Data.resize( dwStart + dwRead );
+
+	return VFS_File_Close( hSrc );
+}
+
+// Run the Data in the From Buffer through the Filters (the Result is in the From Buffer again).
+static VFS_BOOL EncodeBuffer( const VFS_FilterList& Filters, const VFS_EntityInfo& Info )
+{
+	g_ToBuffer.clear();
+	for( VFS_FilterList::const_iterator iter = Filters.begin(); iter != Filters.end(); iter++ )
 	{
-		if( ( *iter ).eType == VFS_FILE )
-			Files[ ( *iter ).strPath ] = ( *iter ).strPath.substr( nStart );
+		g_FromPos = 0;
+		if( !( *iter )->Encode( Reader, Writer, Info ) )
+		{
+			VFS_ErrorCode eError = VFS_GetLastError();
+			if( eError == VFS_ERROR_NONE )
+				eError = VFS_ERROR_GENERIC;
+			SetLastError( eError );
+			return VFS_FALSE;
+		}
+		g_FromBuffer.swap( g_ToBuffer );
+		g_ToBuffer.clear();
 	}
 
-	// Try to create an Archive from the File List.
-	return VFS_Archive_CreateFromFileList( strArchiveFileName, Files, UsedFilters );
+	return VFS_TRUE;
 }
 
-// Create an Archive from the specified File List.
-VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, const VFS_FileNameMap& Files, const VFS_FilterNameList& UsedFilters )
+// Drop the least recently used Blocks until the Cache fits (the Cache must be locked).
+static void TrimBlockCache()
+{
+	while( g_dwBlockCacheFill > g_dwBlockCacheSize )
+	{
+		g_dwBlockCacheFill -= ( VFS_DWORD )g_BlockCache.back().Block->size();
+		g_BlockCacheMap.erase( g_BlockCache.back().Key );
+		g_BlockCache.pop_back();
+	}
+}
+
+// Close the least recently used unreferenced Archives until there's Room for the specified Number of Archives (there are
+// only a few hundred open Archives, so they are simply searched).
+static void TrimOpenArchives( VFS_DWORD dwRoom )
 {
-	static VFS_BYTE Chunk[ FILE_COPY_CHUNK_SIZE ];
+	if( g_dwMaxOpenArchives == 0 )
+		return;
+
+	while( GetOpenArchives().size() + dwRoom > g_dwMaxOpenArchives )
+	{
+		ArchiveMap::iterator oldest = GetOpenArchives().end();
+		for( ArchiveMap::iterator iter = GetOpenArchives().begin(); iter != GetOpenArchives().end(); iter++ )
+		{
+			if( ( *iter ).second->GetRefCount() == 0 &&
+				( oldest == GetOpenArchives().end() || ( *iter ).second->GetLastUse() < ( *oldest ).second->GetLastUse() ) )
+				oldest = iter;
+		}
 
+		// All of them are in use.
+		if( oldest == GetOpenArchives().end() )
+			return;
+
+		delete ( *oldest ).second;
+		GetOpenArchives().erase( oldest );
+		AddStat( STAT_ARCHIVE_EVICTIONS );
+	}
+}
+
+// Create an Archive from a File List (the Sizes of the Source Files may be known already, e.g. from a Directory Walk).
+static VFS_BOOL CreateArchive( const VFS_String& strArchiveFileName, const VFS_FileNameMap& Files, const CHashMap< VFS_LONG >* pSourceSizes,
+							   const VFS_FilterNameList& UsedFilters, const VFS_FileNameList& AccessOrder )
+{
 	// If there's already an Archive with the same File Name and it's open...
 	VFS_EntityInfo Info;
 	if( VFS_Archive_GetInfo( ToLower( strArchiveFileName ), Info ) )
@@ -133,10 +293,37 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 		Filters.push_back( VFS_GetFilter( *iter ) );
 	}
 
-	// Check all Files.
-	for( VFS_FileNameMap::const_iterator iter2 = Files.begin(); iter2 != Files.end(); iter2++ )
+	// Get the Order in which the Data of the Files is laid out.
+	LayoutOrder Order;
+	GetLayoutOrder( Files, AccessOrder, Order );
+
+	// Check all Files (without Filters, the Archive Size is known in advance, so sum up the Sizes as well; they are needed for
+	// grouping the Files into Solid Blocks and for picking the Training Samples, too).
+	VFS_BOOL bTrain = !Filters.empty() && g_dwTrainingSampleSize > 0;
+	VFS_BOOL bSizes = Filters.empty() || g_dwSolidBlockSize > 0 || g_dwInlineFileSizeLimit > 0 || bTrain;
+	vector< VFS_LONG > Sizes( Order.size(), 0 );
+	VFS_LONG lDataSize = 0;
+	for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
 	{
-		if( !VFS_File_Exists( ( *iter2 ).first ) )
+		VFS_FileNameMap::const_iterator iter2 = Order[ dwFile ];
+		CHashMap< VFS_LONG >::const_iterator size;
+		if( pSourceSizes != NULL && ( size = pSourceSizes->find( ( *iter2 ).first ) ) != pSourceSizes->end() )
+		{
+			Sizes[ dwFile ] = ( *size ).second;
+			lDataSize += ( *size ).second;
+		}
+		else if( bSizes )
+		{
+			VFS_EntityInfo FileInfo;
+			if( !VFS_File_GetInfo( ( *iter2 ).first, FileInfo ) )
+			{
+				SetLastError( VFS_ERROR_NOT_FOUND );
+				return VFS_FALSE;
+			}
+			Sizes[ dwFile ] = FileInfo.lSize;
+			lDataSize += FileInfo.lSize;
+		}
+		else if( !SourceFileExists( ( *iter2 ).first ) )
 		{
 			SetLastError( VFS_ERROR_NOT_FOUND );
 			return VFS_FALSE;
@@ -151,52 +338,171 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 		}
 	}
 
-	// Make a list of the Directories to create.
+	// Read in the tiny Files right away, they are stored in the Index (so its Size has to be known in advance).
+	vector< VFS_DWORD > FileBlocks( Order.size(), BLOCK_INDEX_NONE );
+	vector< VFS_DWORD > FileChecksums( Order.size(), 0 );
+	vector< VFS_DWORD > MemberSizes( Order.size(), 0 );
+	vector< ARCHIVE_FILE_BLOCK > RawFileBlocks( Order.size() );
+	vector< VFS_BYTE > InlineData;
+	ARCHIVE_INLINE_FILES InlineFiles;
+	InlineFiles.dwNumFiles = 0;
+	if( g_dwInlineFileSizeLimit > 0 )
+	{
+		for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
+		{
+			if( Sizes[ dwFile ] > ( VFS_LONG )g_dwInlineFileSizeLimit )
+				continue;
+
+			VFS_DWORD dwStart = ( VFS_DWORD )InlineData.size();
+			if( !ReadSourceFile( ( *Order[ dwFile ] ).first, InlineData ) )
+				return VFS_FALSE;
+			FileBlocks[ dwFile ] = BLOCK_INDEX_INLINE;
+			RawFileBlocks[ dwFile ].dwBlockOffset = dwStart;
+			MemberSizes[ dwFile ] = ( VFS_DWORD )InlineData.size() - dwStart;
+			FileChecksums[ dwFile ] = CRC32C( 0, InlineData.data() + dwStart, MemberSizes[ dwFile ] );
+			InlineFiles.dwNumFiles++;
+		}
+	}
+	InlineFiles.dwDataSize = ( VFS_DWORD )InlineData.size();
+
+	// Group the (other) small Files into Solid Blocks, in the Layout Order (a Block of a single File would only add Overhead).
+	vector< vector< VFS_DWORD > > Blocks;
+	if( g_dwSolidBlockSize > 0 )
+	{
+		vector< vector< VFS_DWORD > > Candidates;
+		VFS_LONG lBlockSize = 0;
+		for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
+		{
+			if( Sizes[ dwFile ] > ( VFS_LONG )g_dwSolidFileSizeLimit || FileBlocks[ dwFile ] != BLOCK_INDEX_NONE )
+				continue;
+
+			if( Candidates.empty() || lBlockSize + Sizes[ dwFile ] > ( VFS_LONG )g_dwSolidBlockSize )
+			{
+				Candidates.push_back( vector< VFS_DWORD >() );
+				lBlockSize = 0;
+			}
+			Candidates.back().push_back( dwFile );
+			lBlockSize += Sizes[ dwFile ];
+		}
+
+		for( vector< vector< VFS_DWORD > >::iterator iter = Candidates.begin(); iter != Candidates.end(); iter++ )
+		{
+			if( ( *iter ).size() < 2 )
+				continue;
+
+			for( vector< VFS_DWORD >::iterator member = ( *iter ).begin(); member != ( *iter ).end(); member++ )
+				FileBlocks[ *member ] = ( VFS_DWORD )Blocks.size();
+			Blocks.push_back( *iter );
+		}
+	}
+
+	// Train the Filters with Samples of the small Files which aren't inline (every n-th one if they don't all fit, so the Samples are spread over the Archive).
+	if( bTrain )
+	{
+		VFS_LONG lSmallSize = 0;
+		for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
+		{
+			if( Sizes[ dwFile ] <= ( VFS_LONG )g_dwSolidFileSizeLimit && FileBlocks[ dwFile ] != BLOCK_INDEX_INLINE )
+				lSmallSize += Sizes[ dwFile ];
+		}
+
+		VFS_FilterSamples Samples;
+		VFS_LONG lStep = lSmallSize / g_dwTrainingSampleSize + 1;
+		VFS_LONG lSmall = 0;
+		for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
+		{
+			if( Sizes[ dwFile ] == 0 || Sizes[ dwFile ] > ( VFS_LONG )g_dwSolidFileSizeLimit || FileBlocks[ dwFile ] == BLOCK_INDEX_INLINE || lSmall++ % lStep != 0 ||
+				( VFS_LONG )Samples.Data.size() + Sizes[ dwFile ] > ( VFS_LONG )g_dwTrainingSampleSize )
+				continue;
+
+			VFS_DWORD dwStart = ( VFS_DWORD )Samples.Data.size();
+			if( !ReadSourceFile( ( *Order[ dwFile ] ).first, Samples.Data ) )
+				return VFS_FALSE;
+			Samples.Sizes.push_back( ( VFS_DWORD )Samples.Data.size() - dwStart );
+		}
+
+		for( VFS_FilterList::iterator iter = Filters.begin(); iter != Filters.end(); iter++ )
+		{
+			if( !const_cast< VFS_Filter* >( *iter )->Train( Samples ) )
+			{
+				if( VFS_GetLastError() == VFS_ERROR_NONE )
+					SetLastError( VFS_ERROR_GENERIC );
+				return VFS_FALSE;
+			}
+		}
+
+		// The Filters don't hold the Filter Data of the active Archive anymore.
+		CArchive::Deactivate();
+	}
+
+	// Let the Filters save their Configuration Data.
+	vector< vector< VFS_BYTE > > FilterConfigs;
+	vector< VFS_DWORD > FilterConfigSizes;
+	for( VFS_FilterList::iterator iter6 = Filters.begin(); iter6 != Filters.end(); iter6++ )
+	{
+		// Setup diverse global Variables.
+		g_ToBuffer.clear();
+
+		// Call the Saver Proc.
+		if( !( *iter6 )->SaveConfigData( Writer ) )
+			return VFS_FALSE;
+
+		FilterConfigs.push_back( g_ToBuffer );
+		FilterConfigSizes.push_back( ( VFS_DWORD )g_ToBuffer.size() );
+	}
+
+	// Make a list of the Directories to create (with their Indices in a Map, the Parent Dirs are looked up there).
 	typedef vector< VFS_String > NameMap;
 	NameMap Dirs;
+	CHashMap< VFS_DWORD > DirIndices;
 	for( VFS_FileNameMap::const_iterator iter3 = Files.begin(); iter3 != Files.end(); iter3++ )
 	{
 		VFS_String strDir;
 		VFS_Util_GetPath( ( *iter3 ).second, strDir );
 		strDir = ToLower( strDir );
-		if( strDir != VFS_TEXT( "" ) && find( Dirs.begin(), Dirs.end(), strDir ) == Dirs.end() )
+
+		// Add the Dir and its Parent Dirs up to the first one which is there already.
+		while( !strDir.empty() && DirIndices.find( strDir ) == DirIndices.end() )
 		{
-			// Add the top-level Dirs.
-			while( strDir.rfind( VFS_PATH_SEPARATOR ) != VFS_String::npos )
+			if( strDir.size() > VFS_MAX_NAME_LENGTH )
 			{
-				if( find( Dirs.begin(), Dirs.end(), strDir ) != Dirs.end() )
-					break;
-				Dirs.push_back( ToLower( strDir ) );
-				if( strDir.size() > VFS_MAX_NAME_LENGTH )
-				{
-					SetLastError( VFS_ERROR_INVALID_PARAMETER );
-					return VFS_FALSE;
-				}
-
-				strDir = strDir.substr( 0, strDir.rfind( VFS_PATH_SEPARATOR ) );
+				SetLastError( VFS_ERROR_INVALID_PARAMETER );
+				return VFS_FALSE;
 			}
+			DirIndices[ strDir ] = ( VFS_DWORD )Dirs.size();
+			Dirs.push_back( strDir );
 
-			if( find( Dirs.begin(), Dirs.end(), strDir ) == Dirs.end() )
-			{
-				Dirs.push_back( ToLower( strDir ) );
-				if( strDir.size() > VFS_MAX_NAME_LENGTH )
-				{
-					SetLastError( VFS_ERROR_INVALID_PARAMETER );
-					return VFS_FALSE;
-				}
-			}
+			VFS_String::size_type nPos = strDir.rfind( VFS_PATH_SEPARATOR );
+			strDir = nPos != VFS_String::npos ? strDir.substr( 0, nPos ) : VFS_String();
 		}
 	}
 
+	// The Size of the Tables besides the Filter, Dir and File Records and the File Checksums.
+	VFS_DWORD dwTablesSize = sizeof( ARCHIVE_BLOCKS ) + ( VFS_DWORD )Blocks.size() * ( sizeof( ARCHIVE_BLOCK ) + sizeof( VFS_DWORD ) ) +
+		sizeof( ARCHIVE_INLINE_FILES ) + InlineFiles.dwDataSize + ( VFS_DWORD )( Dirs.size() + 1 ) * sizeof( ARCHIVE_DIR_FILES ) +
+		( VFS_DWORD )Order.size() * sizeof( ARCHIVE_FILE_BLOCK );
+
 	// (Re)create the Target File.
 	VFS_Handle hFile = VFS_File_Create( Info.strPath + VFS_TEXT( "." ) + VFS_ARCHIVE_FILE_EXTENSION, VFS_READ | VFS_WRITE );
 	if( hFile == VFS_INVALID_HANDLE_VALUE )
 		return VFS_FALSE;
 
+	// Reserve the Space.
+	if( Filters.empty() )
+	{
+		VFS_LONG lSize = sizeof( ARCHIVE_HEADER ) + sizeof( ARCHIVE_CHECKSUMS ) + dwTablesSize + Dirs.size() * sizeof( ARCHIVE_DIR ) +
+			Files.size() * ( sizeof( ARCHIVE_FILE ) + sizeof( VFS_DWORD ) ) + lDataSize - InlineFiles.dwDataSize;
+		if( !VFS_File_Preallocate( hFile, lSize ) )
+		{
+			VFS_File_Close( hFile );
+			return VFS_FALSE;
+		}
+	}
+
 	// Write the Header.
 	ARCHIVE_HEADER Header;
 	memcpy( Header.ID, ARCHIVE_ID, sizeof( ARCHIVE_ID ) );
-	Header.wVersion = VFS_VERSION;
+	Header.wVersion = ARCHIVE_VERSION;
 	Header.dwNumFilters = ( VFS_DWORD )Filters.size();
 	Header.dwNumDirs = ( VFS_DWORD )Dirs.size();
 	Header.dwNumFiles = ( VFS_DWORD )Files.size();
@@ -207,6 +513,33 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 		return VFS_FALSE;
 	}
 
+	// Reserve the Space for the Checksums (they are known when all Files have been written).
+	ARCHIVE_CHECKSUMS Checksums;
+	Checksums.dwIndexChecksum = 0;
+	if( !VFS_File_Write( hFile, ( const VFS_BYTE* ) &Checksums, sizeof( ARCHIVE_CHECKSUMS ) ) )
+	{
+		VFS_File_Close( hFile );
+		return VFS_FALSE;
+	}
+
+	// Write the Number of Solid Blocks (their Records follow the File Checksums).
+	ARCHIVE_BLOCKS BlockCount;
+	BlockCount.dwNumBlocks = ( VFS_DWORD )Blocks.size();
+	if( !VFS_File_Write( hFile, ( const VFS_BYTE* ) &BlockCount, sizeof( ARCHIVE_BLOCKS ) ) )
+	{
+		VFS_File_Close( hFile );
+		return VFS_FALSE;
+	}
+	Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) &BlockCount, sizeof( ARCHIVE_BLOCKS ) );
+
+	// Write the Number and the Size of the inline Files (their Data follows the Block Records).
+	if( !VFS_File_Write( hFile, ( const VFS_BYTE* ) &InlineFiles, sizeof( ARCHIVE_INLINE_FILES ) ) )
+	{
+		VFS_File_Close( hFile );
+		return VFS_FALSE;
+	}
+	Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) &InlineFiles, sizeof( ARCHIVE_INLINE_FILES ) );
+
 	// Write the Filters.
 	for( VFS_FilterList::iterator iter4 = Filters.begin(); iter4 != Filters.end(); iter4++ )
 	{
@@ -217,7 +550,17 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 			VFS_File_Close( hFile );
 			return VFS_FALSE;
 		}
+		Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) &Filter, sizeof( ARCHIVE_FILTER ) );
+	}
+
+	// Write the Sizes of the Filter Data.
+	VFS_DWORD dwConfigSizesSize = ( VFS_DWORD )( FilterConfigSizes.size() * sizeof( VFS_DWORD ) );
+	if( dwConfigSizesSize > 0 && !VFS_File_Write( hFile, ( const VFS_BYTE* ) FilterConfigSizes.data(), dwConfigSizesSize ) )
+	{
+		VFS_File_Close( hFile );
+		return VFS_FALSE;
 	}
+	Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) FilterConfigSizes.data(), dwConfigSizesSize );
 
 	// Write the Directories.
 	for( NameMap::iterator iter5 = Dirs.begin(); iter5 != Dirs.end(); iter5++ )
@@ -236,8 +579,8 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 			VFS_String strParentDir = ( *iter5 ).substr( 0, ( *iter5 ).rfind( VFS_PATH_SEPARATOR ) );
 
 			// Get the Index of the Parent Directory.
-			assert( find( Dirs.begin(), Dirs.end(), ToLower( strParentDir ) ) != Dirs.end() );
-			Dir.dwParentIndex = ( VFS_DWORD )( find( Dirs.begin(), Dirs.end(), ToLower( strParentDir ) ) - Dirs.begin() );
+			assert( DirIndices.find( strParentDir ) != DirIndices.end() );
+			Dir.dwParentIndex = DirIndices[ strParentDir ];
 		}
 		else
 			Dir.dwParentIndex = DIR_INDEX_ROOT;
@@ -247,38 +590,33 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 			VFS_File_Close( hFile );
 			return VFS_FALSE;
 		}
+		Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) &Dir, sizeof( ARCHIVE_DIR ) );
 	}
 
 	// Get the starting offset for the file data.
-	VFS_DWORD dwOffset = sizeof( ARCHIVE_HEADER ) + Header.dwNumFilters * sizeof( ARCHIVE_FILTER ) +
-		Header.dwNumDirs * sizeof( ARCHIVE_DIR ) + Header.dwNumFiles * sizeof( ARCHIVE_FILE );
+	VFS_DWORD dwOffset = sizeof( ARCHIVE_HEADER ) + sizeof( ARCHIVE_CHECKSUMS ) + dwTablesSize + Header.dwNumFilters * ( sizeof( ARCHIVE_FILTER ) + sizeof( VFS_DWORD ) ) +
+		Header.dwNumDirs * sizeof( ARCHIVE_DIR ) + Header.dwNumFiles * ( sizeof( ARCHIVE_FILE ) + sizeof( VFS_DWORD ) );
 
-	// Let the Filters store the configuration Data.
-	for( VFS_FilterList::iterator iter6 = Filters.begin(); iter6 != Filters.end(); iter6++ )
+	// Store the Configuration Data of the Filters.
+	for( vector< vector< VFS_BYTE > >::iterator iter6 = FilterConfigs.begin(); iter6 != FilterConfigs.end(); iter6++ )
 	{
-		// Setup diverse global Variables.
-		g_ToBuffer.clear();
-
-		// Call the Saver Proc.
-		if( !( *iter6 )->SaveConfigData( Writer ) )
-		{
-			VFS_File_Close( hFile );
-			return VFS_FALSE;
-		}
-
-		// Save it.
 		VFS_DWORD dwPos = VFS_File_Tell( hFile );
 		VFS_File_Seek( hFile, dwOffset, VFS_SET );
-		VFS_File_Write( hFile, &*g_ToBuffer.begin(), ( VFS_DWORD )g_ToBuffer.size() );
+		VFS_File_Write( hFile, ( *iter6 ).data(), ( VFS_DWORD )( *iter6 ).size() );
 		VFS_File_Seek( hFile, dwPos, VFS_SET );
-		dwOffset += ( VFS_DWORD )g_ToBuffer.size();
+		dwOffset += ( VFS_DWORD )( *iter6 ).size();
 	}
 
-	// Write the Files.
-	for( VFS_FileNameMap::const_iterator iter7 = Files.begin(); iter7 != Files.end(); iter7++ )
+	// Write the Data of the Files in the Layout Order (their Records are written afterwards, ordered by Dir).
+	vector< ARCHIVE_FILE > RawFiles( Order.size() );
+	vector< ARCHIVE_BLOCK > RawBlocks( Blocks.size() );
+	vector< VFS_DWORD > BlockOffsets( Blocks.size() );
+	for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
 	{
+		VFS_FileNameMap::const_iterator iter7 = Order[ dwFile ];
+
 		// Prepare the record.
-		ARCHIVE_FILE File;
+		ARCHIVE_FILE& File = RawFiles[ dwFile ];
 
 		// Get the Name of the File and add it.
 		VFS_String strName;
@@ -292,81 +630,161 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 			VFS_String strParentDir = ( *iter7 ).second.substr( 0, ( *iter7 ).second.rfind( VFS_PATH_SEPARATOR ) );
 
 			// Get the Index of the Parent Directory.
-			assert( find( Dirs.begin(), Dirs.end(), ToLower( strParentDir ) ) != Dirs.end() );
-			File.dwDirIndex = ( VFS_DWORD )( find( Dirs.begin(), Dirs.end(), ToLower( strParentDir ) ) - Dirs.begin() );
+			assert( DirIndices.find( ToLower( strParentDir ) ) != DirIndices.end() );
+			File.dwDirIndex = DirIndices[ ToLower( strParentDir ) ];
 		}
 		else
 			File.dwDirIndex = DIR_INDEX_ROOT;
 
-		// Open the Source File.
-		VFS_Handle hSrc = VFS_File_Open( ( *iter7 ).first, VFS_READ );
-		if( hSrc == VFS_INVALID_HANDLE_VALUE )
+		VFS_DWORD dwBlock = FileBlocks[ dwFile ];
+		RawFileBlocks[ dwFile ].dwBlockIndex = dwBlock;
+		if( dwBlock == BLOCK_INDEX_NONE )
 		{
-			VFS_File_Close( hFile );
-			return VFS_FALSE;
-		}
-
-		// Store the uncompressed size.
-		File.dwUncompressedSize = VFS_File_GetSize( hSrc );
-
-		// Setup diverse global Variables.
-		g_FromBuffer.clear();
-		g_ToBuffer.clear();
+			RawFileBlocks[ dwFile ].dwBlockOffset = dwOffset;
 
-		// Read in the File.
-		VFS_DWORD dwRead;
-		g_FromPos = 0;
-		do
-		{
-			if( !VFS_File_Read( hSrc, Chunk, FILE_COPY_CHUNK_SIZE, &dwRead ) )
+			// Read in the File.
+			VFS_EntityInfo Info;
+			g_FromBuffer.clear();
+			if( !ReadSourceFile( ( *iter7 ).first, g_FromBuffer, &Info ) )
 			{
-				VFS_File_Close( hSrc );
 				VFS_File_Close( hFile );
 				return VFS_FALSE;
 			}
-			g_FromBuffer.reserve( g_FromBuffer.size() + dwRead );
-			for( VFS_DWORD dwIndex = 0; dwIndex < dwRead; dwIndex++ )
-				g_FromBuffer.push_back( Chunk[ dwIndex ] );
-		}
-		while( dwRead > 0 );
 
-		// Close the File.
-		VFS_File_Close( hSrc );
+			// Store the uncompressed size.
+			File.dwUncompressedSize = ( VFS_DWORD )g_FromBuffer.size();
 
-		// Call the Filters.
-		VFS_EntityInfo Info;
-		VFS_File_GetInfo( ( *iter7 ).first, Info );
-		for( VFS_FilterList::iterator iter8 = Filters.begin(); iter8 != Filters.end(); iter8++ )
-		{
-			g_FromPos = 0;
-			if( !( *iter8 )->Encode( Reader, Writer, Info ) )
+			// Call the Filters.
+			if( !EncodeBuffer( Filters, Info ) )
 			{
-				VFS_ErrorCode eError = VFS_GetLastError();
-				if( eError == VFS_ERROR_NONE )
-					eError = VFS_ERROR_GENERIC;
-				SetLastError( eError );
 				VFS_File_Close( hFile );
 				return VFS_FALSE;
 			}
-			g_FromBuffer = g_ToBuffer;
-			g_ToBuffer.clear();
+
+			// Store the final Result.
+			VFS_DWORD dwPos = VFS_File_Tell( hFile );
+			VFS_File_Seek( hFile, dwOffset, VFS_SET );
+			VFS_File_Write( hFile, g_FromBuffer.data(), ( VFS_DWORD )g_FromBuffer.size() );
+			File.dwCompressedSize = ( VFS_DWORD )g_FromBuffer.size();
+			VFS_File_Seek( hFile, dwPos, VFS_SET );
+			dwOffset += File.dwCompressedSize;
+			FileChecksums[ dwFile ] = CRC32C( 0, g_FromBuffer.data(), File.dwCompressedSize );
+		}
+		else if( dwBlock == BLOCK_INDEX_INLINE )
+		{
+			File.dwUncompressedSize = MemberSizes[ dwFile ];
+			File.dwCompressedSize = 0;
 		}
+		else
+		{
+			// The Data of a Block is stored at its first Member: read in all Members and filter them as a whole.
+			if( Blocks[ dwBlock ].front() == dwFile )
+			{
+				VFS_EntityInfo Info;
+				g_FromBuffer.clear();
+				for( vector< VFS_DWORD >::iterator member = Blocks[ dwBlock ].begin(); member != Blocks[ dwBlock ].end(); member++ )
+				{
+					VFS_DWORD dwStart = ( VFS_DWORD )g_FromBuffer.size();
+					if( !ReadSourceFile( ( *Order[ *member ] ).first, g_FromBuffer, member == Blocks[ dwBlock ].begin() ? &Info : NULL ) )
+					{
+						VFS_File_Close( hFile );
+						return VFS_FALSE;
+					}
+					RawFileBlocks[ *member ].dwBlockOffset = dwStart;
+					MemberSizes[ *member ] = ( VFS_DWORD )g_FromBuffer.size() - dwStart;
+					FileChecksums[ *member ] = CRC32C( 0, g_FromBuffer.data() + dwStart, MemberSizes[ *member ] );
+				}
+				RawBlocks[ dwBlock ].dwUncompressedSize = ( VFS_DWORD )g_FromBuffer.size();
 
-		// Store the final Result.
-		VFS_DWORD dwPos = VFS_File_Tell( hFile );
-		VFS_File_Seek( hFile, dwOffset, VFS_SET );
-		VFS_File_Write( hFile, &*g_FromBuffer.begin(), ( VFS_DWORD )g_FromBuffer.size() );
-		File.dwCompressedSize = ( VFS_DWORD )g_FromBuffer.size();
-		VFS_File_Seek( hFile, dwPos, VFS_SET );
-		dwOffset += File.dwCompressedSize;
+				// Call the Filters (with the Information of the first Member, except for the Size).
+				Info.lSize = RawBlocks[ dwBlock ].dwUncompressedSize;
+				if( !EncodeBuffer( Filters, Info ) )
+				{
+					VFS_File_Close( hFile );
+					return VFS_FALSE;
+				}
 
-		if( !VFS_File_Write( hFile, ( const VFS_BYTE* ) &File, sizeof( ARCHIVE_FILE ) ) )
-		{
-			VFS_File_Close( hFile );
-			return VFS_FALSE;
+				// Store the final Result.
+				VFS_DWORD dwPos = VFS_File_Tell( hFile );
+				VFS_File_Seek( hFile, dwOffset, VFS_SET );
+				VFS_File_Write( hFile, g_FromBuffer.data(), ( VFS_DWORD )g_FromBuffer.size() );
+				VFS_File_Seek( hFile, dwPos, VFS_SET );
+				BlockOffsets[ dwBlock ] = dwOffset;
+				RawBlocks[ dwBlock ].dwCompressedSize = ( VFS_DWORD )g_FromBuffer.size();
+				RawBlocks[ dwBlock ].dwChecksum = CRC32C( 0, g_FromBuffer.data(), RawBlocks[ dwBlock ].dwCompressedSize );
+				dwOffset += RawBlocks[ dwBlock ].dwCompressedSize;
+			}
+
+			File.dwUncompressedSize = MemberSizes[ dwFile ];
+			File.dwCompressedSize = 0;
 		}
 	}
 
+	// Order the File Records, their Checksums and their File Block Records by Dir (the Root Directory's Files come last).
+	VFS_DWORD dwRootSlot = ( VFS_DWORD )Dirs.size();
+	vector< ARCHIVE_DIR_FILES > DirFiles( Dirs.size() + 1 );
+	for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
+		DirFiles[ RawFiles[ dwFile ].dwDirIndex == DIR_INDEX_ROOT ? dwRootSlot : RawFiles[ dwFile ].dwDirIndex ].dwNumFiles++;
+
+	vector< VFS_DWORD > NextFile( Dirs.size() + 1 );
+	VFS_DWORD dwFirstFile = 0;
+	for( VFS_DWORD dwSlot = 0; dwSlot <= dwRootSlot; dwSlot++ )
+	{
+		DirFiles[ dwSlot ].dwFirstFile = NextFile[ dwSlot ] = dwFirstFile;
+		dwFirstFile += DirFiles[ dwSlot ].dwNumFiles;
+	}
+
+	vector< ARCHIVE_FILE > DirRawFiles( Order.size() );
+	vector< VFS_DWORD > DirChecksums( Order.size() );
+	vector< ARCHIVE_FILE_BLOCK > DirFileBlocks( Order.size() );
+	for( VFS_DWORD dwFile = 0; dwFile < Order.size(); dwFile++ )
+	{
+		VFS_DWORD dwIndex = NextFile[ RawFiles[ dwFile ].dwDirIndex == DIR_INDEX_ROOT ? dwRootSlot : RawFiles[ dwFile ].dwDirIndex ]++;
+		DirRawFiles[ dwIndex ] = RawFiles[ dwFile ];
+		DirChecksums[ dwIndex ] = FileChecksums[ dwFile ];
+		DirFileBlocks[ dwIndex ] = RawFileBlocks[ dwFile ];
+	}
+
+	for( VFS_DWORD dwSlot = 0; dwSlot <= dwRootSlot; dwSlot++ )
+	{
+		VFS_DWORD dwFirst = DirFiles[ dwSlot ].dwFirstFile;
+		VFS_DWORD dwNum = DirFiles[ dwSlot ].dwNumFiles;
+		DirFiles[ dwSlot ].dwChecksum = CRC32C( 0, ( const VFS_BYTE* ) ( DirRawFiles.data() + dwFirst ), dwNum * sizeof( ARCHIVE_FILE ) );
+		DirFiles[ dwSlot ].dwChecksum = CRC32C( DirFiles[ dwSlot ].dwChecksum, ( const VFS_BYTE* ) ( DirChecksums.data() + dwFirst ), dwNum * sizeof( VFS_DWORD ) );
+		DirFiles[ dwSlot ].dwChecksum = CRC32C( DirFiles[ dwSlot ].dwChecksum, ( const VFS_BYTE* ) ( DirFileBlocks.data() + dwFirst ), dwNum * sizeof( ARCHIVE_FILE_BLOCK ) );
+	}
+
+	// Write the Dir Files Table, the File Records, the File Checksums, the Block Records and their Data Offsets, the File Block Records and the inline Data.
+	VFS_DWORD dwDirFilesSize = ( VFS_DWORD )( DirFiles.size() * sizeof( ARCHIVE_DIR_FILES ) );
+	VFS_DWORD dwFilesSize = ( VFS_DWORD )( DirRawFiles.size() * sizeof( ARCHIVE_FILE ) );
+	VFS_DWORD dwChecksumsSize = ( VFS_DWORD )( DirChecksums.size() * sizeof( VFS_DWORD ) );
+	VFS_DWORD dwBlocksSize = ( VFS_DWORD )( RawBlocks.size() * sizeof( ARCHIVE_BLOCK ) );
+	VFS_DWORD dwBlockOffsetsSize = ( VFS_DWORD )( BlockOffsets.size() * sizeof( VFS_DWORD ) );
+	VFS_DWORD dwFileBlocksSize = ( VFS_DWORD )( DirFileBlocks.size() * sizeof( ARCHIVE_FILE_BLOCK ) );
+	Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) DirFiles.data(), dwDirFilesSize );
+	Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) RawBlocks.data(), dwBlocksSize );
+	Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, ( const VFS_BYTE* ) BlockOffsets.data(), dwBlockOffsetsSize );
+	Checksums.dwIndexChecksum = CRC32C( Checksums.dwIndexChecksum, InlineData.data(), InlineFiles.dwDataSize );
+	if( !VFS_File_Write( hFile, ( const VFS_BYTE* ) DirFiles.data(), dwDirFilesSize ) ||
+		( dwFilesSize > 0 && !VFS_File_Write( hFile, ( const VFS_BYTE* ) DirRawFiles.data(), dwFilesSize ) ) ||
+		( dwChecksumsSize > 0 && !VFS_File_Write( hFile, ( const VFS_BYTE* ) DirChecksums.data(), dwChecksumsSize ) ) ||
+		( dwBlocksSize > 0 && !VFS_File_Write( hFile, ( const VFS_BYTE* ) RawBlocks.data(), dwBlocksSize ) ) ||
+		( dwBlockOffsetsSize > 0 && !VFS_File_Write( hFile, ( const VFS_BYTE* ) BlockOffsets.data(), dwBlockOffsetsSize ) ) ||
+		( dwFileBlocksSize > 0 && !VFS_File_Write( hFile, ( const VFS_BYTE* ) DirFileBlocks.data(), dwFileBlocksSize ) ) ||
+		( InlineFiles.dwDataSize > 0 && !VFS_File_Write( hFile, InlineData.data(), InlineFiles.dwDataSize ) ) )
+	{
+		VFS_File_Close( hFile );
+		return VFS_FALSE;
+	}
+
+	// Finally write the Index Checksum.
+	if( !VFS_File_Seek( hFile, sizeof( ARCHIVE_HEADER ), VFS_SET ) ||
+		!VFS_File_Write( hFile, ( const VFS_BYTE* ) &Checksums, sizeof( ARCHIVE_CHECKSUMS ) ) )
+	{
+		VFS_File_Close( hFile );
+		return VFS_FALSE;
+	}
+
 	// Close the File.
 	if( !VFS_File_Close( hFile ) )
 		return VFS_FALSE;
@@ -374,9 +792,69 @@ VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, c
 	return VFS_TRUE;
 }
 
+//============================================================================
+//    INTERFACE FUNCTIONS
+//============================================================================
+// Create an Archive.
+
+// Create an Archive from the specified Source Directory.
+VFS_BOOL VFS_Archive_CreateFromDirectory( const VFS_String& strArchiveFileName, const VFS_String& strDirName, const VFS_FilterNameList& UsedFilters, VFS_BOOL bRecursive, const VFS_FileNameList& AccessOrder )
+{
+	COperationTimer Timer( VFS_OP_ARCHIVE_CREATE_FROM_DIRECTORY );
+
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	// Get the absolute Path of the Directory.
+	VFS_EntityInfo Info;
+	if( !VFS_Dir_GetInfo( strDirName, Info ) )
+		return VFS_FALSE;
+
+	// Get the Start Position for the In-Archive Name.
+	VFS_INT nStart = ( VFS_INT )Info.strPath.size();
+	if( !IsRootDir( Info.strPath ) )
+		nStart++;
+
+	// Make a File Name List while walking the Directory (the Sizes are remembered, so the Files don't have to be checked again).
+	VFS_DirFilter Filter;
+	Filter.dwTypes = 1 << VFS_FILE;
+	VFS_DirIterator Iterator;
+	if( !Iterator.Open( strDirName, bRecursive, &Filter ) )
+		return VFS_FALSE;
+
+	VFS_FileNameMap Files;
+	CHashMap< VFS_LONG > SourceSizes;
+	while( Iterator.Next() )
+	{
+		VFS_String strPath( Iterator.GetPath() );
+		SourceSizes[ strPath ] = Iterator.GetSize();
+		Files[ strPath ] = strPath.substr( nStart );
+	}
+	if( VFS_GetLastError() != VFS_ERROR_NONE )
+		return VFS_FALSE;
+	Iterator.Close();
+
+	// Try to create an Archive from the File List.
+	return CreateArchive( strArchiveFileName, Files, &SourceSizes, UsedFilters, AccessOrder );
+}
+
+// Create an Archive from the specified File List.
+VFS_BOOL VFS_Archive_CreateFromFileList( const VFS_String& strArchiveFileName, const VFS_FileNameMap& Files, const VFS_FilterNameList& UsedFilters, const VFS_FileNameList& AccessOrder )
+{
+	COperationTimer Timer( VFS_OP_ARCHIVE_CREATE_FROM_FILE_LIST );
+
+	return CreateArchive( strArchiveFileName, Files, NULL, UsedFilters, AccessOrder );
+}
+
 // Extract an Archive.
 VFS_BOOL VFS_Archive_Extract( const VFS_String& strArchiveFileName, const VFS_String& strTargetDir )
 {
+	COperationTimer Timer( VFS_OP_ARCHIVE_EXTRACT );
+
 	// Get Information about that Archive.
 	VFS_EntityInfo Info;
 	if( !VFS_Archive_GetInfo( strArchiveFileName, Info ) )
@@ -391,7 +869,7 @@ VFS_BOOL VFS_Archive_Extract( const VFS_String& strArchiveFileName, const VFS_St
 			return VFS_FALSE;
 
 		// Add the Archive to the Open Archives List.
-		GetOpenArchives()[ Info.strPath ] = pArchive;
+		AddOpenArchive( ToLower( Info.strPath ), pArchive );
 	}
 
 	// Extract the Archive to the Target Directory.
@@ -401,23 +879,70 @@ VFS_BOOL VFS_Archive_Extract( const VFS_String& strArchiveFileName, const VFS_St
 // Extract a File.
 VFS_BOOL VFS_Archive_ExtractFile( const VFS_String& strArchiveFileName, const VFS_String& strFile, const VFS_String& strTargetFile )
 {
+	COperationTimer Timer( VFS_OP_ARCHIVE_EXTRACT_FILE );
+
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
     // Create the Source File Name.
 	VFS_String strFileName = WithoutTrailingSeparator( strArchiveFileName, VFS_TRUE ) + VFS_PATH_SEPARATOR + strFile;
 
-	// Check if the File exists.
-	VFS_EntityInfo Info;
-	if( !VFS_File_GetInfo( strFileName, Info ) )
-		return VFS_FALSE;
+	// Find the Archive containing the File (without opening the File, which would decode it).
+	CArchive* pArchive = NULL;
+	VFS_String strArchivedName;
+	if( VFS_Util_IsAbsoluteFileName( strFileName ) )
+		CArchiveFile::Exists( strFileName, &pArchive, &strArchivedName );
+	else
+	{
+		for( VFS_RootPathList::iterator iter = GetRootPaths().begin(); iter != GetRootPaths().end() && pArchive == NULL; iter++ )
+		{
+			AddStat( STAT_ROOT_PATH_PROBES );
+			CArchiveFile::Exists( WithoutTrailingSeparator( *iter, VFS_TRUE ) + VFS_PATH_SEPARATOR + strFileName, &pArchive, &strArchivedName );
+		}
+	}
 
 	// The file must be in an Archive.
-	if( !Info.bArchived )
+	if( pArchive == NULL )
 	{
-		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		SetLastError( VFS_File_Exists( strFileName ) ? VFS_ERROR_INVALID_PARAMETER : VFS_ERROR_NOT_FOUND );
 		return VFS_FALSE;
 	}
 
-    // Extract...
-	return VFS_File_Copy( strFileName, strTargetFile );
+	const ArchiveFile* pFile = pArchive->GetFile( strArchivedName );
+	if( pFile == NULL )
+		return VFS_FALSE;
+
+	// Filtered Files and Members of Solid Blocks have to be decoded (and Files which have to be verified are checked when they are opened),
+	// so do the Files of an Archive which is itself archived (its Handle isn't a Standard File).
+	IFile* pSource = ( IFile* )( VFS_DWORD )pArchive->GetFile();
+	if( !pArchive->GetHeader()->Filters.empty() || pFile->dwBlockIndex != BLOCK_INDEX_NONE || pArchive->NeedsVerification( *pFile, GetVerifyMode( 0 ) ) ||
+		pSource->IsArchived() )
+		return VFS_File_Copy( strFileName, strTargetFile );
+
+	// Otherwise copy the Byte Range directly from the Archive File.
+
+	VFS_Handle hOut = VFS_File_Create( strTargetFile, VFS_WRITE );
+	if( hOut == VFS_INVALID_HANDLE_VALUE )
+		return VFS_FALSE;
+
+	// The Target might be an open archived File, the Copy deals with it.
+	IFile* pTarget = ( IFile* )( VFS_DWORD )hOut;
+	if( pTarget->IsArchived() )
+	{
+		VFS_File_Close( hOut );
+		return VFS_File_Copy( strFileName, strTargetFile );
+	}
+
+	VFS_BOOL bResult = static_cast< CStdIOFile* >( pSource )->CopyRange( static_cast< CStdIOFile* >( pTarget ), pFile->dwDataOffset, pFile->dwCompressedSize, 0 );
+
+	if( !VFS_File_Close( hOut ) )
+		return VFS_FALSE;
+
+	return bResult;
 }
 
 // Information.
@@ -437,6 +962,8 @@ VFS_BOOL VFS_Archive_Exists( const VFS_String& strArchiveFileName )
 
 VFS_BOOL VFS_Archive_GetInfo( const VFS_String& strArchiveFileName, VFS_EntityInfo& Info )
 {
+	COperationTimer Timer( VFS_OP_ARCHIVE_GET_INFO );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -452,7 +979,7 @@ VFS_BOOL VFS_Archive_GetInfo( const VFS_String& strArchiveFileName, VFS_EntityIn
 	VFS_String strExtension;
 	if( !VFS_Util_GetExtension( Info.strName, strExtension ) )
 		return VFS_FALSE;
-	if( ToLower( strExtension ) != ToLower( VFS_ARCHIVE_FILE_EXTENSION ) )
+	if( !EqualsNoCase( strExtension, VFS_ARCHIVE_FILE_EXTENSION ) )
 	{
 		SetLastError( VFS_ERROR_NOT_AN_ARCHIVE );
 		return VFS_FALSE;
@@ -484,7 +1011,7 @@ VFS_BOOL VFS_Archive_GetUsedFilters( const VFS_String& strArchiveFileName, VFS_F
 			return VFS_FALSE;
 
 		// Add the Archive to the Open Archives List.
-		GetOpenArchives()[ Info.strPath ] = pArchive;
+		AddOpenArchive( ToLower( Info.strPath ), pArchive );
 	}
 
 	// Get the Filter Names List.
@@ -514,6 +1041,8 @@ VFS_BOOL VFS_Archive_Delete( const VFS_String& strArchiveFileName )
 // Flush the Archive System.
 VFS_BOOL VFS_Archive_Flush()
 {
+	COperationTimer Timer( VFS_OP_ARCHIVE_FLUSH );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -527,11 +1056,14 @@ VFS_BOOL VFS_Archive_Flush()
 	// For each open Archive.
 	for( ArchiveMap::iterator iter = GetOpenArchives().begin(); iter != GetOpenArchives().end(); iter++ )
 	{
-		// If there are no more References to this Archive, then add it to the To Close List.
+		// If there are no more References to this Archive, then add it to the To Close List (otherwise free the Files of its Dirs,
+		// the open Files don't need them anymore).
 		if( ( *iter ).second->GetRefCount() == 0 )
 		{
 			ToClose.push_back( ( *iter ).first );
 		}
+		else
+			( *iter ).second->UnloadDirs();
 	}
 
 	// Close the Archives to Close.
@@ -544,12 +1076,184 @@ VFS_BOOL VFS_Archive_Flush()
 	return VFS_TRUE;
 }
 
+// Set / Get the Number of Extraction Threads.
+VFS_BOOL VFS_Archive_SetExtractionThreads( VFS_DWORD dwThreads )
+{
+	g_dwExtractionThreads = dwThreads;
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetExtractionThreads()
+{
+	return g_dwExtractionThreads;
+}
+
+// Set / Get the default Checksum Verification Mode.
+VFS_BOOL VFS_Archive_SetVerifyMode( VFS_DWORD dwMode )
+{
+	// Not a single Mode?
+	if( dwMode != VFS_VERIFY_OFF && dwMode != VFS_VERIFY_FIRST_READ && dwMode != VFS_VERIFY_ALWAYS )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	g_dwVerifyMode = dwMode;
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetVerifyMode()
+{
+	return g_dwVerifyMode;
+}
+
+// Set / Get the Solid Block Settings.
+VFS_BOOL VFS_Archive_SetSolidBlockSize( VFS_DWORD dwSize )
+{
+	g_dwSolidBlockSize = dwSize;
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetSolidBlockSize()
+{
+	return g_dwSolidBlockSize;
+}
+
+VFS_BOOL VFS_Archive_SetSolidFileSizeLimit( VFS_DWORD dwSize )
+{
+	g_dwSolidFileSizeLimit = dwSize;
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetSolidFileSizeLimit()
+{
+	return g_dwSolidFileSizeLimit;
+}
+
+// Set / Get the Size Limit for inline Files.
+VFS_BOOL VFS_Archive_SetInlineFileSizeLimit( VFS_DWORD dwSize )
+{
+	g_dwInlineFileSizeLimit = dwSize;
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetInlineFileSizeLimit()
+{
+	return g_dwInlineFileSizeLimit;
+}
+
+// Set / Get the Amount of Sample Data for the Training of the Filters.
+VFS_BOOL VFS_Archive_SetTrainingSampleSize( VFS_DWORD dwSize )
+{
+	g_dwTrainingSampleSize = dwSize;
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetTrainingSampleSize()
+{
+	return g_dwTrainingSampleSize;
+}
+
+// Set / Get the maximum Number of open Archives (unreferenced Archives beyond the new Maximum are closed right away).
+VFS_BOOL VFS_Archive_SetMaxOpenArchives( VFS_DWORD dwMax )
+{
+	g_dwMaxOpenArchives = dwMax;
+	TrimOpenArchives( 0 );
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetMaxOpenArchives()
+{
+	return g_dwMaxOpenArchives;
+}
+
+// Set / Get the Size of the Block Cache (Blocks which don't fit anymore are dropped).
+VFS_BOOL VFS_Archive_SetBlockCacheSize( VFS_DWORD dwSize )
+{
+	lock_guard< mutex > Lock( g_BlockCacheMutex );
+	g_dwBlockCacheSize = dwSize;
+	TrimBlockCache();
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_Archive_GetBlockCacheSize()
+{
+	return g_dwBlockCacheSize;
+}
+
+// Look a Block up in the Block Cache (it becomes the most recently used one).
+DecodedBlock GetCachedBlock( const CArchive* pArchive, VFS_DWORD dwIndex )
+{
+	lock_guard< mutex > Lock( g_BlockCacheMutex );
+	map< BlockKey, BlockCacheList::iterator >::iterator iter = g_BlockCacheMap.find( BlockKey( pArchive, dwIndex ) );
+	if( iter == g_BlockCacheMap.end() )
+		return DecodedBlock();
+
+	g_BlockCache.splice( g_BlockCache.begin(), g_BlockCache, ( *iter ).second );
+	return g_BlockCache.front().Block;
+}
+
+// Add a Block to the Block Cache (unless it's there already or it doesn't fit at all).
+void CacheBlock( const CArchive* pArchive, VFS_DWORD dwIndex, const DecodedBlock& Block )
+{
+	lock_guard< mutex > Lock( g_BlockCacheMutex );
+	BlockKey Key( pArchive, dwIndex );
+	if( Block->size() > g_dwBlockCacheSize || g_BlockCacheMap.find( Key ) != g_BlockCacheMap.end() )
+		return;
+
+	CachedBlock NewBlock;
+	NewBlock.Key = Key;
+	NewBlock.Block = Block;
+	g_BlockCache.push_front( NewBlock );
+	g_BlockCacheMap[ Key ] = g_BlockCache.begin();
+	g_dwBlockCacheFill += ( VFS_DWORD )Block->size();
+	TrimBlockCache();
+}
+
+// Drop all Blocks of an Archive.
+void UncacheBlocks( const CArchive* pArchive )
+{
+	lock_guard< mutex > Lock( g_BlockCacheMutex );
+	for( BlockCacheList::iterator iter = g_BlockCache.begin(); iter != g_BlockCache.end(); )
+	{
+		if( ( *iter ).Key.first != pArchive )
+		{
+			iter++;
+			continue;
+		}
+
+		g_dwBlockCacheFill -= ( VFS_DWORD )( *iter ).Block->size();
+		g_BlockCacheMap.erase( ( *iter ).Key );
+		iter = g_BlockCache.erase( iter );
+	}
+}
+
+// Get the Checksum Verification Mode for the Open Flags.
+VFS_DWORD GetVerifyMode( VFS_DWORD dwFlags )
+{
+	if( ( dwFlags & VFS_VERIFY_ALWAYS ) == VFS_VERIFY_ALWAYS )
+		return VFS_VERIFY_ALWAYS;
+	if( ( dwFlags & VFS_VERIFY_FIRST_READ ) == VFS_VERIFY_FIRST_READ )
+		return VFS_VERIFY_FIRST_READ;
+	if( ( dwFlags & VFS_VERIFY_OFF ) == VFS_VERIFY_OFF )
+		return VFS_VERIFY_OFF;
+
+	return g_dwVerifyMode;
+}
+
 // Return a Map containing all Open Files.
 ArchiveMap& GetOpenArchives()
 {
 	return g_OpenArchives;
 }
 
+// Add an opened Archive to the Open Archives Map (after making Room for it).
+ArchiveMap::iterator AddOpenArchive( const VFS_String& strArchiveName, CArchive* pArchive )
+{
+	TrimOpenArchives( 1 );
+	return GetOpenArchives().insert( ArchiveMap::value_type( strArchiveName, pArchive ) ).first;
+}
+
 //============================================================================
 //    INTERFACE CLASS BODIES
 //============================================================================
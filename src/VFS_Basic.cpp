@@ -16,15 +16,61 @@
 //============================================================================
 #include "VFS_Implementation.h"
 
+// SIMD Kernels for the Case Folding and the Checksums (SSE2 is always there on x64, AVX2 and SSE4.2 are detected at Runtime).
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#	define VFS_USE_SSE2
+#	include <emmintrin.h>
+#	if defined( __GNUC__ ) || defined( __clang__ )
+#		define VFS_USE_AVX2
+#		include <immintrin.h>
+#		if defined( __x86_64__ )
+#			define VFS_USE_SSE42
+#		endif
+#	endif
+#endif
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
 //============================================================================
+// The Multipliers of the Path Hash.
+static const VFS_QWORD HASH_MULTIPLIER_1 = 0x9E3779B97F4A7C15ULL;
+static const VFS_QWORD HASH_MULTIPLIER_2 = 0xBF58476D1CE4E5B9ULL;
+static const VFS_QWORD HASH_MULTIPLIER_3 = 0x94D049BB133111EBULL;
+
+// 8 Bytes with the same Value (for SWAR Operations on 64 Bit Words).
+#define VFS_BYTES( byte )	( 0x0101010101010101ULL * ( VFS_BYTE )( byte ) )
+
+// The (reflected) CRC32C Polynomial.
+static const VFS_UINT CRC32C_POLYNOMIAL = 0x82F63B78;
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE CLASS PROTOTYPES / EXTERNAL CLASS REFERENCES
 //============================================================================
 //============================================================================
 //    IMPLEMENTATION PRIVATE STRUCTURES / UTILITY CLASSES
 //============================================================================
+// The Tables of the Slicing-by-8 CRC32C (used if the CPU lacks SSE4.2).
+struct CRC32CTables
+{
+	VFS_UINT Table[ 8 ][ 256 ];
+
+	CRC32CTables()
+	{
+		for( VFS_DWORD dwByte = 0; dwByte < 256; dwByte++ )
+		{
+			VFS_UINT uCRC = dwByte;
+			for( VFS_DWORD dwBit = 0; dwBit < 8; dwBit++ )
+				uCRC = ( uCRC >> 1 ) ^ ( ( uCRC & 1 ) ? CRC32C_POLYNOMIAL : 0 );
+			Table[ 0 ][ dwByte ] = uCRC;
+		}
+		for( VFS_DWORD dwSlice = 1; dwSlice < 8; dwSlice++ )
+		{
+			for( VFS_DWORD dwByte = 0; dwByte < 256; dwByte++ )
+				Table[ dwSlice ][ dwByte ] = ( Table[ dwSlice - 1 ][ dwByte ] >> 8 ) ^ Table[ 0 ][ Table[ dwSlice - 1 ][ dwByte ] & 0xFF ];
+		}
+	}
+};
+
 //============================================================================
 //    IMPLEMENTATION REQUIRED EXTERNAL REFERENCES (AVOID)
 //============================================================================
@@ -32,7 +78,7 @@
 //    IMPLEMENTATION PRIVATE DATA
 //============================================================================
 static VFS_BOOL g_bInit = VFS_FALSE;
-static VFS_ErrorCode g_eLastError = VFS_ERROR_NONE;
+static thread_local VFS_ErrorCode g_eLastError = VFS_ERROR_NONE;
 static VFS_PCSTR g_ErrorStrings[] =
 {
 	VFS_TEXT( "No Error (VFS_ERROR_NONE)" ),
@@ -49,7 +95,8 @@ static VFS_PCSTR g_ErrorStrings[] =
 	VFS_TEXT( "Can't manipulate Archives (VFS_ERROR_CANT_MANIPULATE_ARCHIVES)" ),
 	VFS_TEXT( "Not an Archive (VFS_ERROR_NOT_AN_ARCHIVE)" ),
 	VFS_TEXT( "Missing Filters (VFS_ERROR_MISSING_FILTERS)" ),
-	VFS_TEXT( "Invalid Archive Format (VFS_ERROR_INVALID_ARCHIVE_FORMAT)" )
+	VFS_TEXT( "Invalid Archive Format (VFS_ERROR_INVALID_ARCHIVE_FORMAT)" ),
+	VFS_TEXT( "Checksum Mismatch (VFS_ERROR_CHECKSUM_MISMATCH)" )
 };
 static FilterMap g_Filters;
 static VFS_RootPathList g_RootPaths;
@@ -60,9 +107,161 @@ static VFS_RootPathList g_RootPaths;
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
 //============================================================================
+static inline VFS_CHAR FoldChar( VFS_CHAR c );
+static inline VFS_QWORD FoldWord( VFS_QWORD qwWord );
+static inline VFS_QWORD LoadWord( const VFS_CHAR* pChars, VFS_DWORD dwBytes );
+static inline VFS_QWORD MixWord( VFS_QWORD qwHash, VFS_QWORD qwWord );
+static VFS_BOOL HasAVX2();
+static VFS_BOOL HasSSE42();
+static VFS_UINT CRC32CTable( VFS_UINT uCRC, const VFS_BYTE* pData, VFS_DWORD dwSize );
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTIONS
 //============================================================================
+// Folds an ASCII Character (the Paths are compared byte-wise, so we don't depend on the Locale).
+static inline VFS_CHAR FoldChar( VFS_CHAR c )
+{
+	return ( c >= VFS_TEXT( 'A' ) && c <= VFS_TEXT( 'Z' ) ) ? ( VFS_CHAR )( c + ( VFS_TEXT( 'a' ) - VFS_TEXT( 'A' ) ) ) : c;
+}
+
+// Folds 8 ASCII Characters at once (Bytes >= 0x80 are left alone).
+static inline VFS_QWORD FoldWord( VFS_QWORD qwWord )
+{
+	VFS_QWORD qwLow = qwWord & VFS_BYTES( 0x7F );
+	VFS_QWORD qwAboveZ = qwLow + VFS_BYTES( 0x7F - 'Z' );
+	VFS_QWORD qwAtLeastA = qwLow + VFS_BYTES( 0x80 - 'A' );
+	VFS_QWORD qwUpper = ( qwAtLeastA ^ qwAboveZ ) & ~qwWord & VFS_BYTES( 0x80 );
+	return qwWord | ( qwUpper >> 2 );
+}
+
+// Loads up to 8 Bytes as a little-endian Word (missing Bytes are 0).
+static inline VFS_QWORD LoadWord( const VFS_CHAR* pChars, VFS_DWORD dwBytes )
+{
+	VFS_BYTE Bytes[ 8 ] = { 0 };
+	memcpy( Bytes, pChars, dwBytes );
+
+	VFS_QWORD qwWord = 0;
+	for( VFS_DWORD dwByte = 0; dwByte < 8; dwByte++ )
+		qwWord |= ( VFS_QWORD )Bytes[ dwByte ] << ( dwByte * 8 );
+	return qwWord;
+}
+
+// Mixes a Word into the Hash.
+static inline VFS_QWORD MixWord( VFS_QWORD qwHash, VFS_QWORD qwWord )
+{
+	qwHash = ( qwHash ^ qwWord ) * HASH_MULTIPLIER_1;
+	return qwHash ^ ( qwHash >> 32 );
+}
+
+// Does the CPU support AVX2?
+static VFS_BOOL HasAVX2()
+{
+#if defined( VFS_USE_AVX2 )
+	static const VFS_BOOL bAVX2 = __builtin_cpu_supports( "avx2" ) ? VFS_TRUE : VFS_FALSE;
+	return bAVX2;
+#else
+	return VFS_FALSE;
+#endif
+}
+
+// Does the CPU support SSE4.2 (and thus the CRC32 Instruction)?
+static VFS_BOOL HasSSE42()
+{
+#if defined( VFS_USE_SSE42 )
+	static const VFS_BOOL bSSE42 = __builtin_cpu_supports( "sse4.2" ) ? VFS_TRUE : VFS_FALSE;
+	return bSSE42;
+#else
+	return VFS_FALSE;
+#endif
+}
+
+// Continues a (non-inverted) CRC32C using the Tables, 8 Bytes per Step (the Bytes are loaded one by one, so it doesn't depend on the Byte Order).
+static VFS_UINT CRC32CTable( VFS_UINT uCRC, const VFS_BYTE* pData, VFS_DWORD dwSize )
+{
+	static const CRC32CTables Tables;
+	const VFS_UINT ( *Table )[ 256 ] = Tables.Table;
+
+	for( ; dwSize >= 8; pData += 8, dwSize -= 8 )
+	{
+		uCRC ^= ( VFS_UINT )pData[ 0 ] | ( ( VFS_UINT )pData[ 1 ] << 8 ) | ( ( VFS_UINT )pData[ 2 ] << 16 ) | ( ( VFS_UINT )pData[ 3 ] << 24 );
+		uCRC = Table[ 7 ][ uCRC & 0xFF ] ^ Table[ 6 ][ ( uCRC >> 8 ) & 0xFF ] ^ Table[ 5 ][ ( uCRC >> 16 ) & 0xFF ] ^ Table[ 4 ][ uCRC >> 24 ] ^
+			Table[ 3 ][ pData[ 4 ] ] ^ Table[ 2 ][ pData[ 5 ] ] ^ Table[ 1 ][ pData[ 6 ] ] ^ Table[ 0 ][ pData[ 7 ] ];
+	}
+	for( ; dwSize > 0; pData++, dwSize-- )
+		uCRC = ( uCRC >> 8 ) ^ Table[ 0 ][ ( uCRC ^ *pData ) & 0xFF ];
+
+	return uCRC;
+}
+
+#if defined( VFS_USE_SSE42 )
+// Continues a (non-inverted) CRC32C using the CRC32 Instruction (8 Bytes per Instruction).
+__attribute__( ( target( "sse4.2" ) ) ) static VFS_UINT CRC32CSSE42( VFS_UINT uCRC, const VFS_BYTE* pData, VFS_DWORD dwSize )
+{
+	VFS_QWORD qwCRC = uCRC;
+	for( ; dwSize >= 8; pData += 8, dwSize -= 8 )
+	{
+		VFS_QWORD qwWord;
+		memcpy( &qwWord, pData, sizeof( qwWord ) );
+		qwCRC = _mm_crc32_u64( qwCRC, qwWord );
+	}
+
+	uCRC = ( VFS_UINT )qwCRC;
+	for( ; dwSize > 0; pData++, dwSize-- )
+		uCRC = _mm_crc32_u8( uCRC, *pData );
+
+	return uCRC;
+}
+#endif
+
+#if defined( VFS_USE_SSE2 )
+// Returns a Mask of the upper-case Bytes (moving 'A' to -128 makes 'A'..'Z' the 26 smallest signed Bytes, so one signed Comparison finds them).
+static inline __m128i UpperMask16( __m128i Chars )
+{
+	__m128i Shifted = _mm_add_epi8( Chars, _mm_set1_epi8( ( char )( 0x80 - 'A' ) ) );
+	return _mm_cmplt_epi8( Shifted, _mm_set1_epi8( ( char )( -128 + 26 ) ) );
+}
+
+static inline __m128i Fold16( __m128i Chars )
+{
+	return _mm_or_si128( Chars, _mm_and_si128( UpperMask16( Chars ), _mm_set1_epi8( 0x20 ) ) );
+}
+#endif
+
+#if defined( VFS_USE_AVX2 )
+__attribute__( ( target( "avx2" ) ) ) static inline __m256i Fold32( __m256i Chars )
+{
+	__m256i Shifted = _mm256_add_epi8( Chars, _mm256_set1_epi8( ( char )( 0x80 - 'A' ) ) );
+	__m256i Upper = _mm256_cmpgt_epi8( _mm256_set1_epi8( ( char )( -128 + 26 ) ), Shifted );
+	return _mm256_or_si256( Chars, _mm256_and_si256( Upper, _mm256_set1_epi8( 0x20 ) ) );
+}
+
+// Folds 32 Characters at once; returns the Number of Characters processed.
+__attribute__( ( target( "avx2" ) ) ) static VFS_DWORD FoldAVX2( VFS_CHAR* pChars, VFS_DWORD dwCount )
+{
+	VFS_DWORD dwIndex = 0;
+	for( ; dwIndex + 32 <= dwCount; dwIndex += 32 )
+	{
+		__m256i Chars = _mm256_loadu_si256( ( const __m256i* )( pChars + dwIndex ) );
+		_mm256_storeu_si256( ( __m256i* )( pChars + dwIndex ), Fold32( Chars ) );
+	}
+	return dwIndex;
+}
+
+// Compares 32 Characters at once; returns the Number of equal Characters processed (stops at the first Block with a Difference).
+__attribute__( ( target( "avx2" ) ) ) static VFS_DWORD CompareAVX2( const VFS_CHAR* pFirst, const VFS_CHAR* pSecond, VFS_DWORD dwCount )
+{
+	VFS_DWORD dwIndex = 0;
+	for( ; dwIndex + 32 <= dwCount; dwIndex += 32 )
+	{
+		__m256i First = Fold32( _mm256_loadu_si256( ( const __m256i* )( pFirst + dwIndex ) ) );
+		__m256i Second = Fold32( _mm256_loadu_si256( ( const __m256i* )( pSecond + dwIndex ) ) );
+		if( ( VFS_UINT )_mm256_movemask_epi8( _mm256_cmpeq_epi8( First, Second ) ) != 0xFFFFFFFF )
+			break;
+	}
+	return dwIndex;
+}
+#endif
+
 //============================================================================
 //    INTERFACE FUNCTIONS
 //============================================================================
@@ -99,7 +298,8 @@ VFS_BOOL VFS_Shutdown()
 		return VFS_FALSE;
 	}
 
-	// Flush all the stuff.
+	// Stop the Prefetcher and flush all the stuff.
+	ShutdownTrace();
 	VFS_Flush();
 
 #ifdef VFS_DEBUG
@@ -184,8 +384,8 @@ VFS_BOOL VFS_RegisterFilter( VFS_Filter* pFilter )
 		return VFS_FALSE;
 	}
 
-	// Add.
-	g_Filters[ ToLower( pFilter->GetName() ) ] = pFilter;
+	// Add (the Filters are kept ordered by Name, so their Indices are stable).
+	g_Filters.insert_sorted( FilterMap::value_type( ToLower( pFilter->GetName() ), pFilter ) );
 
 	return VFS_TRUE;
 }
@@ -215,7 +415,7 @@ VFS_BOOL VFS_UnregisterFilter( VFS_Filter* pFilter )
 	}
 
 	// Remove.
-	g_Filters.erase( pFilter->GetName() );
+	g_Filters.erase_stable( g_Filters.find( pFilter->GetName() ) );
 
 	return VFS_TRUE;
 }
@@ -238,14 +438,14 @@ VFS_BOOL VFS_UnregisterFilter( VFS_DWORD dwIndex )
 	}
 
 	// Get the Iterator to the first Element.
-	map< VFS_String, VFS_Filter* >::iterator iter = g_Filters.begin();
+	FilterMap::iterator iter = g_Filters.begin();
 
 	// Jump to the specified Index.
 	while( dwIndex-- > 0 )
 		iter++;
 
 	// Remove the Filter.
-	g_Filters.erase( iter );
+	g_Filters.erase_stable( iter );
 
 	return VFS_TRUE;
 }
@@ -268,7 +468,7 @@ VFS_BOOL VFS_UnregisterFilter( const VFS_String& strFilterName )
 	}
 
 	// Remove.
-	g_Filters.erase( strFilterName );
+	g_Filters.erase_stable( g_Filters.find( strFilterName ) );
 
 	return VFS_TRUE;
 }
@@ -319,18 +519,18 @@ const VFS_Filter* VFS_GetFilter( VFS_DWORD dwIndex )
 	if( !IsInit() )
 	{
 		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
-		return VFS_FALSE;
+		return VFS_INVALID_POINTER_VALUE;
 	}
 
 	// Invalid Parameter?
 	if( dwIndex >= g_Filters.size() )
 	{
 		SetLastError( VFS_ERROR_INVALID_PARAMETER );
-		return VFS_FALSE;
+		return VFS_INVALID_POINTER_VALUE;
 	}
 
 	// Get the Iterator to the first Element.
-	map< VFS_String, VFS_Filter* >::iterator iter = g_Filters.begin();
+	FilterMap::iterator iter = g_Filters.begin();
 
 	// Jump to the specified Index.
 	while( dwIndex-- > 0 )
@@ -517,6 +717,8 @@ VFS_BOOL VFS_GetRootPaths( VFS_RootPathList& RootPaths )
 // Flushes the VFS.
 VFS_BOOL VFS_Flush()
 {
+	COperationTimer Timer( VFS_OP_FLUSH );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -553,6 +755,8 @@ VFS_BOOL VFS_Flush()
 // - File
 VFS_BOOL VFS_ExistsEntity( const VFS_String& strPath )
 {
+	COperationTimer Timer( VFS_OP_EXISTS_ENTITY );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -578,6 +782,8 @@ VFS_BOOL VFS_ExistsEntity( const VFS_String& strPath )
 // - File
 VFS_BOOL VFS_GetEntityInfo( const VFS_String& strPath, VFS_EntityInfo& Info )
 {
+	COperationTimer Timer( VFS_OP_GET_ENTITY_INFO );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -681,14 +887,152 @@ VFS_BOOL IsRootDir( const VFS_String& strFileName )
 }
 
 // Makes a String lower-cased.
-VFS_String ToLower( const VFS_String& strString )
+VFS_String ToLower( VFS_StringView strString )
 {
-	VFS_String strResult = strString;
-	for( VFS_String::iterator iter = strResult.begin(); iter != strResult.end(); iter++ )
-		*iter = tolower( *iter );
+	VFS_String strResult( strString );
+	ToLowerInPlace( strResult );
 	return strResult;
 }
 
+// Returns a lower-cased View of a String (Paths are usually lower-cased already, so we don't copy them then).
+VFS_StringView ToLowerView( VFS_StringView strString, VFS_String& strStorage )
+{
+	if( !HasUpperCase( strString ) )
+		return strString;
+
+	strStorage.assign( strString.data(), strString.size() );
+	ToLowerInPlace( strStorage );
+	return strStorage;
+}
+
+// Makes a String lower-cased in place.
+void ToLowerInPlace( VFS_String& strString )
+{
+	VFS_CHAR* pChars = &strString[ 0 ];
+	VFS_DWORD dwCount = ( VFS_DWORD )strString.size();
+	VFS_DWORD dwIndex = 0;
+
+	if constexpr( sizeof( VFS_CHAR ) == 1 )
+	{
+#if defined( VFS_USE_AVX2 )
+		if( HasAVX2() )
+			dwIndex = FoldAVX2( pChars, dwCount );
+#endif
+#if defined( VFS_USE_SSE2 )
+		for( ; dwIndex + 16 <= dwCount; dwIndex += 16 )
+		{
+			__m128i Chars = _mm_loadu_si128( ( const __m128i* )( pChars + dwIndex ) );
+			_mm_storeu_si128( ( __m128i* )( pChars + dwIndex ), Fold16( Chars ) );
+		}
+#endif
+	}
+
+	for( ; dwIndex < dwCount; dwIndex++ )
+		pChars[ dwIndex ] = FoldChar( pChars[ dwIndex ] );
+}
+
+// Does the String contain upper-case Characters?
+VFS_BOOL HasUpperCase( VFS_StringView strString )
+{
+	const VFS_CHAR* pChars = strString.data();
+	VFS_DWORD dwCount = ( VFS_DWORD )strString.size();
+	VFS_DWORD dwIndex = 0;
+
+	if constexpr( sizeof( VFS_CHAR ) == 1 )
+	{
+#if defined( VFS_USE_SSE2 )
+		for( ; dwIndex + 16 <= dwCount; dwIndex += 16 )
+		{
+			if( _mm_movemask_epi8( UpperMask16( _mm_loadu_si128( ( const __m128i* )( pChars + dwIndex ) ) ) ) != 0 )
+				return VFS_TRUE;
+		}
+#endif
+	}
+
+	for( ; dwIndex < dwCount; dwIndex++ )
+	{
+		if( FoldChar( pChars[ dwIndex ] ) != pChars[ dwIndex ] )
+			return VFS_TRUE;
+	}
+
+	return VFS_FALSE;
+}
+
+// Compares two Strings ignoring the Case (without creating lower-cased Copies).
+VFS_BOOL EqualsNoCase( VFS_StringView strFirst, VFS_StringView strSecond )
+{
+	if( strFirst.size() != strSecond.size() )
+		return VFS_FALSE;
+
+	const VFS_CHAR* pFirst = strFirst.data();
+	const VFS_CHAR* pSecond = strSecond.data();
+	VFS_DWORD dwCount = ( VFS_DWORD )strFirst.size();
+	VFS_DWORD dwIndex = 0;
+
+	if constexpr( sizeof( VFS_CHAR ) == 1 )
+	{
+#if defined( VFS_USE_AVX2 )
+		if( HasAVX2() )
+			dwIndex = CompareAVX2( pFirst, pSecond, dwCount );
+#endif
+#if defined( VFS_USE_SSE2 )
+		for( ; dwIndex + 16 <= dwCount; dwIndex += 16 )
+		{
+			__m128i First = Fold16( _mm_loadu_si128( ( const __m128i* )( pFirst + dwIndex ) ) );
+			__m128i Second = Fold16( _mm_loadu_si128( ( const __m128i* )( pSecond + dwIndex ) ) );
+			if( _mm_movemask_epi8( _mm_cmpeq_epi8( First, Second ) ) != 0xFFFF )
+				return VFS_FALSE;
+		}
+#endif
+	}
+
+	for( ; dwIndex < dwCount; dwIndex++ )
+	{
+		if( FoldChar( pFirst[ dwIndex ] ) != FoldChar( pSecond[ dwIndex ] ) )
+			return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// Hashes a Path ignoring the Case, so the Hash of a Name equals the Hash of its lower-cased Version. The Characters
+// are folded and mixed in 64 Bit Words (one Multiplication per 8 Bytes) and the Result is finalized like SplitMix64.
+VFS_QWORD HashPath( VFS_StringView strPath )
+{
+	const VFS_CHAR* pChars = strPath.data();
+	VFS_DWORD dwCount = ( VFS_DWORD )strPath.size();
+	VFS_QWORD qwHash = dwCount * HASH_MULTIPLIER_2;
+
+	if constexpr( sizeof( VFS_CHAR ) == 1 )
+	{
+		VFS_DWORD dwIndex = 0;
+		for( ; dwIndex + 8 <= dwCount; dwIndex += 8 )
+			qwHash = MixWord( qwHash, FoldWord( LoadWord( pChars + dwIndex, 8 ) ) );
+		if( dwIndex < dwCount )
+			qwHash = MixWord( qwHash, FoldWord( LoadWord( pChars + dwIndex, dwCount - dwIndex ) ) );
+	}
+	else
+	{
+		for( VFS_DWORD dwIndex = 0; dwIndex < dwCount; dwIndex++ )
+			qwHash = MixWord( qwHash, ( VFS_QWORD )FoldChar( pChars[ dwIndex ] ) );
+	}
+
+	qwHash = ( qwHash ^ ( qwHash >> 30 ) ) * HASH_MULTIPLIER_2;
+	qwHash = ( qwHash ^ ( qwHash >> 27 ) ) * HASH_MULTIPLIER_3;
+	return qwHash ^ ( qwHash >> 31 );
+}
+
+// Continues a CRC32C Checksum (the Checksum is inverted before and after, so Checksums can be chained and the CRC of no Data is 0).
+VFS_DWORD CRC32C( VFS_DWORD dwCRC, const VFS_BYTE* pData, VFS_DWORD dwSize )
+{
+	VFS_UINT uCRC = ~( VFS_UINT )dwCRC;
+#if defined( VFS_USE_SSE42 )
+	if( HasSSE42() )
+		return ( VFS_UINT )~CRC32CSSE42( uCRC, pData, dwSize );
+#endif
+	return ( VFS_UINT )~CRC32CTable( uCRC, pData, dwSize );
+}
+
 //============================================================================
 //    INTERFACE CLASS BODIES
 //============================================================================
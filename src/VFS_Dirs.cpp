@@ -15,6 +15,7 @@
 //    IMPLEMENTATION HEADERS
 //============================================================================
 #include "VFS_Implementation.h"
+#include <cerrno>
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
@@ -25,6 +26,46 @@
 //============================================================================
 //    IMPLEMENTATION PRIVATE STRUCTURES / UTILITY CLASSES
 //============================================================================
+// An Entry of a Standard Dir read by a Directory Iterator (its Name is in the Names of the Level).
+struct DirIterationEntry {
+	VFS_EntityType eType;
+	VFS_DWORD dwNameOffset;
+	VFS_DWORD dwNameLength;
+	VFS_LONG lSize;
+};
+typedef vector< DirIterationEntry > DirIterationEntryList;
+
+// A Dir being iterated: an Archive Dir (its Subdirs and Files are taken from the Archive Index) or a Standard Dir (its
+// Entries are read when it's entered; Files which don't pass the Filter aren't kept).
+struct DirIterationLevel {
+	const CArchive* pArchive;
+	VFS_DWORD dwDirIndex;
+	VFS_String strPrefix;	// Prepended to the Names to get the Paths (it ends with a Path Separator).
+	VFS_String strNames;
+	DirIterationEntryList Dirs;
+	DirIterationEntryList Files;
+	VFS_BOOL bFiles;	// Are the Files iterated already (they follow the Dirs)?
+	VFS_DWORD dwPos;
+};
+typedef vector< DirIterationLevel > DirIterationLevelList;
+
+// The State of a Directory Iterator (the Levels beyond the Depth are kept to reuse their Buffers; the Archive Levels up to the
+// Depth hold a Reference to their Archive, so it isn't closed while it's iterated).
+struct VFS_DirIteratorState {
+	VFS_BOOL bRecursive;
+	VFS_DirFilter Filter;
+	DirIterationLevelList Levels;
+	VFS_DWORD dwDepth;
+
+	// The Path of the current Entry and the Name found last in a Standard Dir.
+	VFS_String strPath;
+	VFS_String strFoundName;
+
+	// Enter the current Entry (a Dir) with the next Call of Next()?
+	VFS_BOOL bDescend;
+	VFS_DWORD dwDescendIndex;
+};
+
 //============================================================================
 //    IMPLEMENTATION REQUIRED EXTERNAL REFERENCES (AVOID)
 //============================================================================
@@ -42,6 +83,14 @@ static VFS_BOOL GetAbsoluteDirInfo( const VFS_String& strAbsoluteDirName, VFS_En
 static VFS_BOOL DeletionCallback( const VFS_EntityInfo& pInfo, void* pParam );
 static VFS_BOOL ContentRetrievationCallback( const VFS_EntityInfo& pInfo, void* pParam );
 static VFS_BOOL GetAllEntities( const VFS_String& strAbsoluteDirName, VFS_EntityInfoList& Files, VFS_EntityInfoList& Dirs );
+static VFS_BOOL MoveRecursively( const VFS_String& strAbsoluteFrom, const VFS_String& strAbsoluteTo );
+static VFS_StringView GetExtensionView( VFS_StringView strName );
+static VFS_BOOL AcceptsType( const VFS_DirFilter& Filter, VFS_EntityType eType );
+static VFS_BOOL AcceptsFile( const VFS_DirFilter& Filter, VFS_StringView strName, VFS_LONG lSize );
+static DirIterationLevel& PushLevel( VFS_DirIteratorState& State );
+static void PopLevel( VFS_DirIteratorState& State );
+static void PushArchiveDir( VFS_DirIteratorState& State, const CArchive* pArchive, VFS_DWORD dwDirIndex );
+static void PushStdDir( VFS_DirIteratorState& State, const VFS_String& strAbsoluteDirName );
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTIONS
@@ -72,6 +121,7 @@ static VFS_BOOL CreateRecursively( const VFS_String& strAbsoluteDirName )
 	}
 
     // Try to create the directory.
+	AddStat( STAT_SYSCALLS );
 	if( !VFS_MKDIR( strAbsoluteDirName ) )
 	{
 		if( VFS_Dir_Exists( strAbsoluteDirName ) )
@@ -87,6 +137,7 @@ static VFS_BOOL CreateRecursively( const VFS_String& strAbsoluteDirName )
 static VFS_BOOL GetAbsoluteDirInfo( const VFS_String& strAbsoluteDirName, VFS_EntityInfo& Info )
 {
 	// Make a quick check first.
+	AddStat( STAT_SYSCALLS, 2 );
 	if( ( VFS_EXISTS( strAbsoluteDirName ) && VFS_IS_DIR( strAbsoluteDirName ) ) )
 	{
 		// Fill out the Information.
@@ -124,6 +175,7 @@ static VFS_BOOL GetAbsoluteDirInfo( const VFS_String& strAbsoluteDirName, VFS_En
 	for( PairMap::iterator iter = Pairs.begin(); iter != Pairs.end(); iter++ )
 	{
 		// Exists the Directory?
+		AddStat( STAT_SYSCALLS, 2 );
 		if( VFS_EXISTS( ( *iter ).first ) && VFS_IS_DIR( ( *iter ).first ) )
 			continue;
 
@@ -139,7 +191,7 @@ static VFS_BOOL GetAbsoluteDirInfo( const VFS_String& strAbsoluteDirName, VFS_En
 					return VFS_FALSE;
 
 				// Add it to the Open Archives Map.
-				GetOpenArchives()[ ToLower( ( *iter ).first ) ] = pArchive;
+				AddOpenArchive( ToLower( ( *iter ).first ), pArchive );
 			}
 
 			// Is there a Subdirectory with the path saved in the second part of the Pair?
@@ -202,7 +254,8 @@ static VFS_BOOL GetAllEntities( const VFS_String& strAbsoluteDirName, VFS_Entity
 	VFS_String strName;
 	VFS_BOOL bIsDir;
 	VFS_LONG lSize;
-	if( !VFS_FIND_FILE( WithoutTrailingSeparator( strAbsoluteDirName, VFS_TRUE ) + VFS_PATH_SEPARATOR + VFS_TEXT( "*" ), strName, bIsDir, lSize, 0 ) )
+	VFS_FindHandle hFind;
+	if( !VFS_FIND_FILE( hFind, WithoutTrailingSeparator( strAbsoluteDirName, VFS_TRUE ) + VFS_PATH_SEPARATOR + VFS_TEXT( "*" ), strName, bIsDir, lSize, 0 ) )
 		return VFS_TRUE;
 
 	// Find more files.
@@ -221,7 +274,7 @@ static VFS_BOOL GetAllEntities( const VFS_String& strAbsoluteDirName, VFS_Entity
 		{
 			VFS_String strExtension;
 			VFS_Util_GetExtension( Info.strName, strExtension );
-			if( ToLower( strExtension ) == ToLower( VFS_ARCHIVE_FILE_EXTENSION ) )
+			if( EqualsNoCase( strExtension, VFS_ARCHIVE_FILE_EXTENSION ) )
 				Info.eType = VFS_ARCHIVE;
 			Dirs.push_back( Info );
 		}
@@ -230,10 +283,199 @@ static VFS_BOOL GetAllEntities( const VFS_String& strAbsoluteDirName, VFS_Entity
 			Files.push_back( Info );
 		}
 	}
-	while( VFS_FIND_FILE( VFS_TEXT( "wedontcare" ), strName, bIsDir, lSize, 1 ) );
+	while( VFS_FIND_FILE( hFind, VFS_TEXT( "wedontcare" ), strName, bIsDir, lSize, 1 ) );
 
 	// End the Search.
-	return VFS_FIND_FILE( VFS_TEXT( "wedontcare" ), strName, bIsDir, lSize, 2 );
+	return VFS_FIND_FILE( hFind, VFS_TEXT( "wedontcare" ), strName, bIsDir, lSize, 2 );
+}
+
+// Copy a Directory Tree (the Directories are recreated, the Files are copied one by one by their real Paths).
+static VFS_BOOL CopyRecursively( const VFS_String& strAbsoluteFrom, const VFS_String& strAbsoluteTo )
+{
+	VFS_EntityInfoList Files, Dirs;
+	if( !GetAllEntities( strAbsoluteFrom, Files, Dirs ) )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	// Create the Target Directory.
+	AddStat( STAT_SYSCALLS );
+	if( !VFS_MKDIR( strAbsoluteTo ) )
+	{
+		SetLastError( VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	// Copy all Subdirs...
+	VFS_String strTarget = WithoutTrailingSeparator( strAbsoluteTo, VFS_TRUE ) + VFS_PATH_SEPARATOR;
+	for( VFS_EntityInfoList::iterator iter = Dirs.begin(); iter != Dirs.end(); iter++ )
+	{
+		if( !CopyRecursively( ( *iter ).strPath, strTarget + ( *iter ).strName ) )
+			return VFS_FALSE;
+	}
+
+	// ... and all Files.
+	for( VFS_EntityInfoList::iterator iter2 = Files.begin(); iter2 != Files.end(); iter2++ )
+	{
+		if( !CStdIOFile::Copy( ( *iter2 ).strPath, strTarget + ( *iter2 ).strName ) )
+			return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// Remove a Directory Tree (the Caller sets the Error).
+static VFS_BOOL RemoveRecursively( const VFS_String& strAbsoluteDirName )
+{
+	VFS_EntityInfoList Files, Dirs;
+	VFS_BOOL bResult = GetAllEntities( strAbsoluteDirName, Files, Dirs );
+
+	// Remove all Subdirs...
+	for( VFS_EntityInfoList::iterator iter = Dirs.begin(); iter != Dirs.end(); iter++ )
+	{
+		if( !RemoveRecursively( ( *iter ).strPath ) )
+			bResult = VFS_FALSE;
+	}
+
+	// ... and all Files.
+	for( VFS_EntityInfoList::iterator iter2 = Files.begin(); iter2 != Files.end(); iter2++ )
+	{
+		AddStat( STAT_SYSCALLS );
+		if( !VFS_UNLINK( ( *iter2 ).strPath ) )
+			bResult = VFS_FALSE;
+	}
+
+	// The Directory is empty now.
+	AddStat( STAT_SYSCALLS );
+	if( !VFS_RMDIR( strAbsoluteDirName ) )
+		bResult = VFS_FALSE;
+
+	return bResult;
+}
+
+// Move a Directory Tree to another Device. The Tree is copied before the Source is removed, so if the Copy fails the Source is
+// untouched and the partial Target is removed again. This isn't atomic though: if the Source can't be removed completely,
+// the Target is complete but the Rest of the Source is left behind.
+static VFS_BOOL MoveRecursively( const VFS_String& strAbsoluteFrom, const VFS_String& strAbsoluteTo )
+{
+	if( !CopyRecursively( strAbsoluteFrom, strAbsoluteTo ) )
+	{
+		RemoveRecursively( strAbsoluteTo );
+		return VFS_FALSE;
+	}
+
+	if( !RemoveRecursively( strAbsoluteFrom ) )
+	{
+		SetLastError( VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// The Extension of a Name (empty if there's none).
+static VFS_StringView GetExtensionView( VFS_StringView strName )
+{
+	VFS_StringView::size_type nPoint = strName.rfind( VFS_TEXT( '.' ) );
+	return nPoint != VFS_StringView::npos ? strName.substr( nPoint + 1 ) : VFS_StringView();
+}
+
+// Check an Entry against the Filter of a Directory Iterator.
+static VFS_BOOL AcceptsType( const VFS_DirFilter& Filter, VFS_EntityType eType )
+{
+	return Filter.dwTypes == 0 || ( Filter.dwTypes & ( 1 << eType ) ) != 0;
+}
+
+static VFS_BOOL AcceptsFile( const VFS_DirFilter& Filter, VFS_StringView strName, VFS_LONG lSize )
+{
+	if( !AcceptsType( Filter, VFS_FILE ) )
+		return VFS_FALSE;
+	if( lSize < Filter.lMinSize || ( Filter.lMaxSize != VFS_INVALID_LONG_VALUE && lSize > Filter.lMaxSize ) )
+		return VFS_FALSE;
+	return Filter.strExtension.empty() || EqualsNoCase( GetExtensionView( strName ), Filter.strExtension );
+}
+
+// Add a Level to a Directory Iterator (References to the other Levels may become invalid).
+static DirIterationLevel& PushLevel( VFS_DirIteratorState& State )
+{
+	if( State.dwDepth == State.Levels.size() )
+		State.Levels.push_back( DirIterationLevel() );
+
+	DirIterationLevel& Level = State.Levels[ State.dwDepth++ ];
+	Level.pArchive = NULL;
+	Level.dwDirIndex = 0;
+	Level.strNames.clear();
+	Level.Dirs.clear();
+	Level.Files.clear();
+	Level.bFiles = VFS_FALSE;
+	Level.dwPos = 0;
+	return Level;
+}
+
+// Leave the current Dir.
+static void PopLevel( VFS_DirIteratorState& State )
+{
+	DirIterationLevel& Level = State.Levels[ --State.dwDepth ];
+	if( Level.pArchive != NULL )
+		Level.pArchive->Release();
+	Level.pArchive = NULL;
+}
+
+// Enter a Dir of an Archive.
+static void PushArchiveDir( VFS_DirIteratorState& State, const CArchive* pArchive, VFS_DWORD dwDirIndex )
+{
+	DirIterationLevel& Level = PushLevel( State );
+	Level.pArchive = pArchive;
+	pArchive->AddRef();
+	Level.dwDirIndex = dwDirIndex;
+	Level.strPrefix = pArchive->GetFileNameWithoutExtension();
+	Level.strPrefix += VFS_PATH_SEPARATOR;
+}
+
+// Enter a Standard Dir (its Entries are read right away).
+static void PushStdDir( VFS_DirIteratorState& State, const VFS_String& strAbsoluteDirName )
+{
+	DirIterationLevel& Level = PushLevel( State );
+	Level.strPrefix = strAbsoluteDirName;
+	if( Level.strPrefix.empty() || Level.strPrefix[ Level.strPrefix.size() - 1 ] != VFS_PATH_SEPARATOR )
+		Level.strPrefix += VFS_PATH_SEPARATOR;
+
+	VFS_BOOL bIsDir;
+	VFS_LONG lSize;
+	VFS_FindHandle hFind;
+	if( !VFS_FIND_FILE( hFind, Level.strPrefix + VFS_TEXT( "*" ), State.strFoundName, bIsDir, lSize, 0 ) )
+		return;
+
+	do
+	{
+		const VFS_String& strName = State.strFoundName;
+		if( strName == VFS_TEXT( "." ) || strName == VFS_TEXT( ".." ) )
+			continue;
+
+		// Dirs are kept for the Recursion even if the Filter doesn't accept them, Files are checked right here.
+		DirIterationEntry Entry;
+		if( bIsDir )
+		{
+			Entry.eType = EqualsNoCase( GetExtensionView( strName ), VFS_ARCHIVE_FILE_EXTENSION ) ? VFS_ARCHIVE : VFS_DIR;
+			if( !State.bRecursive && !AcceptsType( State.Filter, Entry.eType ) )
+				continue;
+		}
+		else
+		{
+			Entry.eType = VFS_FILE;
+			if( !AcceptsFile( State.Filter, strName, lSize ) )
+				continue;
+		}
+		Entry.dwNameOffset = ( VFS_DWORD )Level.strNames.size();
+		Entry.dwNameLength = ( VFS_DWORD )strName.size();
+		Entry.lSize = lSize;
+		Level.strNames += strName;
+		( bIsDir ? Level.Dirs : Level.Files ).push_back( Entry );
+	}
+	while( VFS_FIND_FILE( hFind, VFS_TEXT( "wedontcare" ), State.strFoundName, bIsDir, lSize, 1 ) );
+
+	VFS_FIND_FILE( hFind, VFS_TEXT( "wedontcare" ), State.strFoundName, bIsDir, lSize, 2 );
 }
 
 //============================================================================
@@ -244,6 +486,8 @@ static VFS_BOOL GetAllEntities( const VFS_String& strAbsoluteDirName, VFS_Entity
 // Create a new Directory in the first root path.
 VFS_BOOL VFS_Dir_Create( const VFS_String& strDirName, VFS_BOOL bRecursive )	// Recursive mode would create a directory c:\alpha\beta even if alpha doesn't exist.
 {
+	COperationTimer Timer( VFS_OP_DIR_CREATE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -275,6 +519,7 @@ VFS_BOOL VFS_Dir_Create( const VFS_String& strDirName, VFS_BOOL bRecursive )	//
 		return CreateRecursively( strAbsoluteDirName );
 
     // Try to create the directory.
+	AddStat( STAT_SYSCALLS );
 	if( !VFS_MKDIR( strAbsoluteDirName ) )
 	{
 		if( VFS_Dir_Exists( strAbsoluteDirName ) )
@@ -290,6 +535,8 @@ VFS_BOOL VFS_Dir_Create( const VFS_String& strDirName, VFS_BOOL bRecursive )	//
 // Delete the Directory with the specified Name.
 VFS_BOOL VFS_Dir_Delete( const VFS_String& strDirName, VFS_BOOL bRecursive )	// Recursive mode would delete a directory c:\alpha even if it contains files and/or subdirectories.
 {
+	COperationTimer Timer( VFS_OP_DIR_DELETE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -332,6 +579,7 @@ VFS_BOOL VFS_Dir_Delete( const VFS_String& strDirName, VFS_BOOL bRecursive )	//
 		}
 	}
 
+	AddStat( STAT_SYSCALLS );
 	if( !VFS_RMDIR( Info.strPath ) )
 	{
 		SetLastError( VFS_ERROR_GENERIC );
@@ -341,9 +589,79 @@ VFS_BOOL VFS_Dir_Delete( const VFS_String& strDirName, VFS_BOOL bRecursive )	//
 	return VFS_TRUE;
 }
 
+// Move the Directory with the specified Name (and everything it contains).
+VFS_BOOL VFS_Dir_Move( const VFS_String& strFrom, const VFS_String& strTo )
+{
+	COperationTimer Timer( VFS_OP_DIR_MOVE );
+
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	VFS_EntityInfo Info;
+	if( !VFS_Dir_GetInfo( strFrom, Info ) )
+		return VFS_FALSE;
+
+	// If the Directory resides in an Archive, fail.
+	if( Info.bArchived )
+	{
+		SetLastError( VFS_ERROR_CANT_MANIPULATE_ARCHIVES );
+		return VFS_FALSE;
+	}
+
+	// No Root Paths specified yet?
+	if( GetRootPaths().size() == 0 && !VFS_Util_IsAbsoluteFileName( strTo ) )
+	{
+		SetLastError( VFS_ERROR_NO_ROOT_PATHS_DEFINED );
+		return VFS_FALSE;
+	}
+
+	// Make the Target absolute...
+	VFS_String strAbsoluteTo = WithoutTrailingSeparator( strTo, VFS_FALSE );
+	if( !VFS_Util_IsAbsoluteFileName( strAbsoluteTo ) )
+		strAbsoluteTo = WithoutTrailingSeparator( GetRootPaths()[ 0 ], VFS_TRUE ) + VFS_PATH_SEPARATOR + strAbsoluteTo;
+
+	// ... it mustn't exist yet (rename() would replace empty Directories).
+	AddStat( STAT_SYSCALLS );
+	if( VFS_EXISTS( strAbsoluteTo ) )
+	{
+		SetLastError( VFS_ERROR_ALREADY_EXISTS );
+		return VFS_FALSE;
+	}
+
+	// Close the unused Archives and check if any File in the Tree is still open.
+	VFS_Archive_Flush();
+	VFS_String strPrefix = ToLower( WithoutTrailingSeparator( Info.strPath, VFS_TRUE ) + VFS_PATH_SEPARATOR );
+	for( FileMap::iterator iter = GetOpenFiles().begin(); iter != GetOpenFiles().end(); iter++ )
+	{
+		if( ( *iter ).first.compare( 0, strPrefix.size(), strPrefix ) == 0 )
+		{
+			SetLastError( VFS_ERROR_IN_USE );
+			return VFS_FALSE;
+		}
+	}
+
+	// Try to rename the Directory.
+	AddStat( STAT_SYSCALLS );
+	if( VFS_RENAME( Info.strPath, strAbsoluteTo ) )
+		return VFS_TRUE;
+
+	// Other Device? Then move everything one by one.
+	if( errno == EXDEV )
+		return MoveRecursively( Info.strPath, strAbsoluteTo );
+
+	SetLastError( errno == ENOENT ? VFS_ERROR_NOT_FOUND : VFS_ERROR_PERMISSION_DENIED );
+	return VFS_FALSE;
+}
+
 // Information.
 VFS_BOOL VFS_Dir_Exists( const VFS_String& strDirName )
 {
+	COperationTimer Timer( VFS_OP_DIR_EXISTS );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -364,6 +682,8 @@ VFS_BOOL VFS_Dir_Exists( const VFS_String& strDirName )
 
 VFS_BOOL VFS_Dir_GetInfo( const VFS_String& strDirName, VFS_EntityInfo& Info )
 {
+	COperationTimer Timer( VFS_OP_DIR_GET_INFO );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -392,6 +712,7 @@ VFS_BOOL VFS_Dir_GetInfo( const VFS_String& strDirName, VFS_EntityInfo& Info )
 	for( VFS_RootPathList::iterator iter = GetRootPaths().begin(); iter != GetRootPaths().end(); iter++ )
 	{
 		VFS_String strAbsoluteDirName = WithoutTrailingSeparator( *iter, VFS_TRUE ) + VFS_PATH_SEPARATOR + strDirName;
+		AddStat( STAT_ROOT_PATH_PROBES );
 		if( GetAbsoluteDirInfo( strAbsoluteDirName, Info ) )
 			return VFS_TRUE;
 	}
@@ -403,6 +724,72 @@ VFS_BOOL VFS_Dir_GetInfo( const VFS_String& strDirName, VFS_EntityInfo& Info )
 // Iterate a Directory and call the iteration procedure for each 
 VFS_BOOL VFS_Dir_Iterate( const VFS_String& strDirName, VFS_DirIterationProc pIterationProc, VFS_BOOL bRecursive, void* pParam )
 {
+	COperationTimer Timer( VFS_OP_DIR_ITERATE );
+
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	VFS_DirIterator Iterator;
+	if( !Iterator.Open( strDirName, bRecursive ) )
+		return VFS_FALSE;
+
+	VFS_EntityInfo Info;
+	while( Iterator.Next() )
+	{
+		// Iterate.
+		Iterator.GetInfo( Info );
+		if( !pIterationProc( Info, pParam ) )
+			return VFS_TRUE;
+	}
+
+	return VFS_GetLastError() == VFS_ERROR_NONE;
+}
+
+// Get the Contents of a Directory.
+VFS_BOOL VFS_Dir_GetContents( const VFS_String& strDirName, VFS_EntityInfoList& EntityInfoList, VFS_BOOL bRecursive )
+{
+	COperationTimer Timer( VFS_OP_DIR_GET_CONTENTS );
+
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	return VFS_Dir_Iterate( strDirName, ContentRetrievationCallback, bRecursive, ( void* ) &EntityInfoList );
+}
+
+//============================================================================
+//    INTERFACE CLASS BODIES
+//============================================================================
+// --- Directory Iterator Class ---
+// Constructor / Destructor.
+VFS_DirIterator::VFS_DirIterator()
+{
+	m_pState = new VFS_DirIteratorState();
+	m_pState->bRecursive = VFS_FALSE;
+	m_pState->dwDepth = 0;
+	m_pState->bDescend = VFS_FALSE;
+	m_pState->dwDescendIndex = 0;
+	Close();
+}
+
+VFS_DirIterator::~VFS_DirIterator()
+{
+	Close();
+	delete m_pState;
+}
+
+// Start iterating a Directory.
+VFS_BOOL VFS_DirIterator::Open( const VFS_String& strDirName, VFS_BOOL bRecursive, const VFS_DirFilter* pFilter )
+{
+	Close();
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -415,6 +802,9 @@ VFS_BOOL VFS_Dir_Iterate( const VFS_String& strDirName, VFS_DirIterationProc pIt
 	if( !VFS_Dir_GetInfo( strDirName, Info ) )
 		return VFS_FALSE;
 
+	m_pState->bRecursive = bRecursive;
+	m_pState->Filter = pFilter != NULL ? *pFilter : VFS_DirFilter();
+
 	// If the Dir is in an Archive.
 	if( Info.bArchived )
 	{
@@ -437,10 +827,16 @@ VFS_BOOL VFS_Dir_Iterate( const VFS_String& strDirName, VFS_DirIterationProc pIt
 						return VFS_FALSE;
 
 					// Add it to the Open Archives Map.
-					GetOpenArchives()[ strArchive ] = pArchive;
+					AddOpenArchive( strArchive, pArchive );
 				}
 
-				return GetOpenArchives()[ strArchive ]->IterateDir( strTemp.substr( szPos + 1 ), pIterationProc, bRecursive, pParam );
+				CArchive* pArchive = GetOpenArchives()[ strArchive ];
+				VFS_DWORD dwDirIndex;
+				if( !pArchive->FindDir( WithoutTrailingSeparator( ToLower( strTemp.substr( szPos + 1 ) ), VFS_TRUE ), dwDirIndex ) )
+					return VFS_FALSE;
+
+				PushArchiveDir( *m_pState, pArchive, dwDirIndex );
+				return VFS_TRUE;
 			}
 		}
 
@@ -448,50 +844,161 @@ VFS_BOOL VFS_Dir_Iterate( const VFS_String& strDirName, VFS_DirIterationProc pIt
 		return VFS_FALSE;
 	}
 
-    // Get the Dir's Contents.
-	VFS_EntityInfoList Files, Dirs;
-	if( !GetAllEntities( Info.strPath, Files, Dirs ) )
+	PushStdDir( *m_pState, Info.strPath );
+	return VFS_TRUE;
+}
+
+// Stop the Iteration.
+void VFS_DirIterator::Close()
+{
+	while( m_pState->dwDepth > 0 )
+		PopLevel( *m_pState );
+	m_pState->bDescend = VFS_FALSE;
+
+	m_eType = VFS_FILE;
+	m_bArchived = VFS_FALSE;
+	m_strPath = VFS_StringView();
+	m_strName = VFS_StringView();
+	m_lSize = 0;
+}
+
+// Advance to the next Entry.
+VFS_BOOL VFS_DirIterator::Next()
+{
+	VFS_DirIteratorState& State = *m_pState;
+
+	// Enter the Dir returned last (the Dirs of a Dir are followed by their Contents).
+	if( State.bDescend )
 	{
-		SetLastError( VFS_ERROR_GENERIC );
-		return VFS_FALSE;
+		State.bDescend = VFS_FALSE;
+		const CArchive* pArchive = State.Levels[ State.dwDepth - 1 ].pArchive;
+		if( pArchive != NULL )
+			PushArchiveDir( State, pArchive, State.dwDescendIndex );
+		else
+			PushStdDir( State, State.strPath );
 	}
 
-	// Iterate through all Subdirs...
-	for( VFS_EntityInfoList::iterator iter = Dirs.begin(); iter != Dirs.end(); iter++ )
+	while( State.dwDepth > 0 )
 	{
-		// Iterate.
-        if( !pIterationProc( *iter, pParam ) )
-			return VFS_TRUE;
+		DirIterationLevel& Level = State.Levels[ State.dwDepth - 1 ];
 
-		// Recurse?
-		if( bRecursive )
-			VFS_Dir_Iterate( ( *iter ).strPath, pIterationProc, bRecursive, pParam );
-	}
+		// An Archive Dir?
+		if( Level.pArchive != NULL )
+		{
+			const ArchiveDirList& Dirs = Level.pArchive->GetHeader()->Dirs;
+			if( !Level.bFiles )
+			{
+				VFS_DWORD dwNumSubdirs;
+				const VFS_DWORD* pSubdirs = Level.pArchive->GetSubdirs( Level.dwDirIndex, dwNumSubdirs );
+				if( Level.dwPos < dwNumSubdirs )
+				{
+					VFS_DWORD dwIndex = pSubdirs[ Level.dwPos++ ];
+					State.strPath.assign( Level.strPrefix ).append( Dirs[ dwIndex ].strName );
+					State.dwDescendIndex = dwIndex;
+
+					if( !AcceptsType( State.Filter, VFS_DIR ) )
+					{
+						if( State.bRecursive )
+							PushArchiveDir( State, Level.pArchive, dwIndex );
+						continue;
+					}
+
+					VFS_StringView strName = Dirs[ dwIndex ].strName;
+					m_eType = VFS_DIR;
+					m_bArchived = VFS_TRUE;
+					m_strPath = State.strPath;
+					m_strName = strName.substr( strName.rfind( VFS_PATH_SEPARATOR ) + 1 );
+					m_lSize = 0;
+					State.bDescend = State.bRecursive;
+					return VFS_TRUE;
+				}
 
-	// Iterate through all Files...
-	for( VFS_EntityInfoList::iterator iter2 = Files.begin(); iter2 != Files.end(); iter2++ )
-	{
-		// Iterate.
-		if( !pIterationProc( *iter2, pParam ) )
-			return VFS_TRUE;
-	}
+				Level.bFiles = VFS_TRUE;
+				Level.dwPos = 0;
+			}
 
-	return VFS_TRUE;
-}
+			const ArchiveFileList* pFiles = Level.pArchive->GetDirFiles( Level.dwDirIndex );
+			if( pFiles == NULL )
+				return VFS_FALSE;
 
-// Get the Contents of a Directory.
-VFS_BOOL VFS_Dir_GetContents( const VFS_String& strDirName, VFS_EntityInfoList& EntityInfoList, VFS_BOOL bRecursive )
-{
-	// Not initialized yet?
-	if( !IsInit() )
-	{
-		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
-		return VFS_FALSE;
+			while( Level.dwPos < pFiles->size() )
+			{
+				const ArchiveFile& File = ( *pFiles )[ Level.dwPos++ ];
+				VFS_StringView strName = File.strName;
+				strName = strName.substr( strName.rfind( VFS_PATH_SEPARATOR ) + 1 );
+				if( !AcceptsFile( State.Filter, strName, File.dwUncompressedSize ) )
+					continue;
+
+				State.strPath.assign( Level.strPrefix ).append( File.strName );
+				m_eType = VFS_FILE;
+				m_bArchived = VFS_TRUE;
+				m_strPath = State.strPath;
+				m_strName = strName;
+				m_lSize = File.dwUncompressedSize;
+				return VFS_TRUE;
+			}
+		}
+		// A Standard Dir.
+		else
+		{
+			if( !Level.bFiles )
+			{
+				if( Level.dwPos < Level.Dirs.size() )
+				{
+					const DirIterationEntry& Entry = Level.Dirs[ Level.dwPos++ ];
+					VFS_StringView strName = VFS_StringView( Level.strNames ).substr( Entry.dwNameOffset, Entry.dwNameLength );
+					State.strPath.assign( Level.strPrefix ).append( strName.data(), strName.size() );
+
+					if( !AcceptsType( State.Filter, Entry.eType ) )
+					{
+						if( State.bRecursive )
+							PushStdDir( State, State.strPath );
+						continue;
+					}
+
+					m_eType = Entry.eType;
+					m_bArchived = VFS_FALSE;
+					m_strPath = State.strPath;
+					m_strName = strName;
+					m_lSize = Entry.lSize;
+					State.bDescend = State.bRecursive;
+					return VFS_TRUE;
+				}
+
+				Level.bFiles = VFS_TRUE;
+				Level.dwPos = 0;
+			}
+
+			if( Level.dwPos < Level.Files.size() )
+			{
+				const DirIterationEntry& Entry = Level.Files[ Level.dwPos++ ];
+				VFS_StringView strName = VFS_StringView( Level.strNames ).substr( Entry.dwNameOffset, Entry.dwNameLength );
+				State.strPath.assign( Level.strPrefix ).append( strName.data(), strName.size() );
+
+				m_eType = VFS_FILE;
+				m_bArchived = VFS_FALSE;
+				m_strPath = State.strPath;
+				m_strName = strName;
+				m_lSize = Entry.lSize;
+				return VFS_TRUE;
+			}
+		}
+
+		// The Dir is done.
+		PopLevel( State );
 	}
 
-	return VFS_Dir_Iterate( strDirName, ContentRetrievationCallback, bRecursive, ( void* ) &EntityInfoList );
+	// The End.
+	SetLastError( VFS_ERROR_NONE );
+	return VFS_FALSE;
 }
 
-//============================================================================
-//    INTERFACE CLASS BODIES
-//============================================================================
+// Copy the current Entry.
+void VFS_DirIterator::GetInfo( VFS_EntityInfo& Info ) const
+{
+	Info.eType = m_eType;
+	Info.bArchived = m_bArchived;
+	Info.strPath.assign( m_strPath.data(), m_strPath.size() );
+	Info.strName.assign( m_strName.data(), m_strName.size() );
+	Info.lSize = m_lSize;
+}
@@ -15,6 +15,7 @@
 //    IMPLEMENTATION HEADERS
 //============================================================================
 #include "VFS_Implementation.h"
+#include <cerrno>
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
@@ -38,69 +39,178 @@ static FileMap g_OpenFiles;
 //    INTERFACE DATA
 //============================================================================
 static VFS_Handle ToHandlePlusStuff( IFile* pFile, VFS_String strAbsoluteFileName, VFS_String strRelativeFileName );
-static VFS_Handle TryToOpen( const VFS_String&  strFileName, VFS_DWORD dwFlags );
+static VFS_Handle TryToOpen( const VFS_Path& FileName, VFS_DWORD dwFlags );
+static VFS_Handle AddReference( IFile* pFile, VFS_DWORD dwFlags );
+static VFS_String GetAbsoluteTargetName( const VFS_String& strFileName );
+static const VFS_String* FindStandardFile( const VFS_Path& AbsoluteFileName );
+static VFS_BOOL FindArchivedFile( const VFS_Path& FileName, VFS_Path& AbsoluteFileName, CArchive*& pArchive, const ArchiveFile*& pFile );
+static VFS_BOOL ReadArchivedFile( const VFS_Path& AbsoluteFileName, CArchive* pArchive, const ArchiveFile& File, VFS_BYTE* pBuffer, VFS_DWORD dwToRead,
+								  VFS_DWORD* pRead, vector< VFS_BYTE >* pData );
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
 //============================================================================
-static VFS_Handle AddAndConvert( IFile* pFile, VFS_String strAbsoluteFileName )
+static VFS_Handle AddAndConvert( IFile* pFile, const VFS_String& strAbsoluteFileName )
 {
 	if( pFile == NULL )
 		return VFS_INVALID_HANDLE_VALUE;
 
-	// Add the File Name to the open Files Map.
-	GetOpenFiles()[ ToLower( strAbsoluteFileName ) ] = pFile;
+	// Add the (lower-cased) File Name to the open Files Map.
+	GetOpenFiles()[ strAbsoluteFileName ] = pFile;
 
 	return ( VFS_Handle )( VFS_DWORD )pFile;
 }
 
-static VFS_Handle TryToOpen( const VFS_String& strFileName, VFS_DWORD dwFlags )
+// Standard Files are opened with the minimal Access Rights, so an already open File might have to be reopened for Writing.
+static VFS_Handle AddReference( IFile* pFile, VFS_DWORD dwFlags )
+{
+	if( ( dwFlags & VFS_WRITE ) == VFS_WRITE && !pFile->IsArchived() && !static_cast< CStdIOFile* >( pFile )->MakeWritable() )
+		return VFS_INVALID_HANDLE_VALUE;
+
+	pFile->Add();
+	return ( VFS_Handle )( VFS_DWORD )pFile;
+}
+
+// New Files are created in the first Root Path (the Name keeps its Case, the open Files Map needs it lower-cased).
+static VFS_String GetAbsoluteTargetName( const VFS_String& strFileName )
 {
-	// Absolute?
 	if( VFS_Util_IsAbsoluteFileName( strFileName ) )
+		return strFileName;
+
+	return WithoutTrailingSeparator( GetRootPaths()[ 0 ], VFS_TRUE ) + VFS_PATH_SEPARATOR + strFileName;
+}
+
+// Find the Name a Standard File exists under: the given one or the lower-cased one (the VFS creates its Files with lower-cased Names).
+static const VFS_String* FindStandardFile( const VFS_Path& AbsoluteFileName )
+{
+	if( CStdIOFile::Exists( AbsoluteFileName.Get() ) )
+		return &AbsoluteFileName.Get();
+	if( AbsoluteFileName.Get() != AbsoluteFileName.GetKey() && CStdIOFile::Exists( AbsoluteFileName.GetKey() ) )
+		return &AbsoluteFileName.GetKey();
+	return NULL;
+}
+
+// The File System is accessed with the File Name as it's given, the open Files Map with its Key.
+static VFS_Handle TryToOpen( const VFS_Path& FileName, VFS_DWORD dwFlags )
+{
+	// Absolute?
+	if( FileName.IsAbsolute() )
 	{
 		// Already open?
-		if( GetOpenFiles().find( ToLower( strFileName ) ) != GetOpenFiles().end() )
-		{
-			IFile* pFile = GetOpenFiles()[ ToLower( strFileName ) ];
-			pFile->Add();
-			return ( VFS_Handle )( VFS_DWORD )pFile;
-		}
+		FileMap::iterator iter = GetOpenFiles().find( FileName.GetKeyView(), FileName.GetHash() );
+		if( iter != GetOpenFiles().end() )
+			return AddReference( ( *iter ).second, dwFlags );
 
 		// Exists a Standard File?
-		if( CStdIOFile::Exists( strFileName ) )
-			return AddAndConvert( CStdIOFile::Open( strFileName, dwFlags ), strFileName );
+		const VFS_String* pStandardName = FindStandardFile( FileName );
+		if( pStandardName != NULL )
+			return AddAndConvert( CStdIOFile::Open( *pStandardName, dwFlags ), FileName.GetKey() );
 
 		// Try to open an Archive File.
-		return AddAndConvert( CArchiveFile::Open( strFileName, dwFlags ), strFileName );
+		return AddAndConvert( CArchiveFile::Open( FileName.Get(), dwFlags ), FileName.GetKey() );
 	}
 
-	// For each Root Path...
+	// For each Root Path (the Path Object is reused, so its Storage is only allocated once)...
+	VFS_Path AbsoluteFileName;
 	for( VFS_RootPathList::iterator iter = GetRootPaths().begin(); iter != GetRootPaths().end(); iter++ )
 	{
-		VFS_String strAbsoluteFileName = ToLower( WithoutTrailingSeparator( *iter, VFS_TRUE ) + VFS_PATH_SEPARATOR + strFileName );
+		AbsoluteFileName.Assign( *iter, FileName.GetView() );
+		AddStat( STAT_ROOT_PATH_PROBES );
 
 		// Already open?
-		if( GetOpenFiles().find( strAbsoluteFileName ) != GetOpenFiles().end() )
-		{
-			IFile* pFile = GetOpenFiles()[ strAbsoluteFileName ];
-			pFile->Add();
-			return ( VFS_Handle )( VFS_DWORD )pFile;
-		}
+		FileMap::iterator fileIter = GetOpenFiles().find( AbsoluteFileName.GetKeyView(), AbsoluteFileName.GetHash() );
+		if( fileIter != GetOpenFiles().end() )
+			return AddReference( ( *fileIter ).second, dwFlags );
 
 		// Exists a Standard File?
-		if( CStdIOFile::Exists( strAbsoluteFileName ) )
-			return AddAndConvert( CStdIOFile::Open( strAbsoluteFileName, dwFlags ), strAbsoluteFileName );
+		const VFS_String* pStandardName = FindStandardFile( AbsoluteFileName );
+		if( pStandardName != NULL )
+			return AddAndConvert( CStdIOFile::Open( *pStandardName, dwFlags ), AbsoluteFileName.GetKey() );
 
 		// Try to open an Archive File.
-		if( CArchiveFile::Exists( strAbsoluteFileName ) )
-			return AddAndConvert( CArchiveFile::Open( strAbsoluteFileName, dwFlags ), strAbsoluteFileName );
+		if( CArchiveFile::Exists( AbsoluteFileName.GetView() ) )
+			return AddAndConvert( CArchiveFile::Open( AbsoluteFileName.Get(), dwFlags ), AbsoluteFileName.GetKey() );
 	}
 
     SetLastError( VFS_ERROR_NOT_FOUND );
 	return VFS_INVALID_HANDLE_VALUE;
 }
 
+// Look up an archived File which isn't open, so its Data can be taken from its Archive without opening it (the Root Paths are
+// searched like by TryToOpen(), an open or Standard File found first is read through a Handle).
+static VFS_BOOL FindArchivedFile( const VFS_Path& FileName, VFS_Path& AbsoluteFileName, CArchive*& pArchive, const ArchiveFile*& pFile )
+{
+	VFS_DWORD dwNumPaths = FileName.IsAbsolute() ? 1 : ( VFS_DWORD )GetRootPaths().size();
+	for( VFS_DWORD dwPath = 0; dwPath < dwNumPaths; dwPath++ )
+	{
+		if( FileName.IsAbsolute() )
+			AbsoluteFileName = FileName;
+		else
+		{
+			AbsoluteFileName.Assign( GetRootPaths()[ dwPath ], FileName.GetView() );
+			AddStat( STAT_ROOT_PATH_PROBES );
+		}
+
+		if( GetOpenFiles().find( AbsoluteFileName.GetKeyView(), AbsoluteFileName.GetHash() ) != GetOpenFiles().end() ||
+			FindStandardFile( AbsoluteFileName ) != NULL )
+			return VFS_FALSE;
+
+		VFS_String strFileName;
+		if( CArchiveFile::Exists( AbsoluteFileName.GetView(), &pArchive, &strFileName ) )
+		{
+			pFile = pArchive->GetFile( strFileName );
+			return pFile != NULL;
+		}
+	}
+
+	return VFS_FALSE;
+}
+
+// Read an archived File found by FindArchivedFile() into the Caller's Buffer or, if pData isn't NULL, into the Data Vector.
+// Unfiltered Files which are neither inline nor in a Solid Block are read straight into a Buffer which is big enough.
+static VFS_BOOL ReadArchivedFile( const VFS_Path& AbsoluteFileName, CArchive* pArchive, const ArchiveFile& File, VFS_BYTE* pBuffer, VFS_DWORD dwToRead,
+								  VFS_DWORD* pRead, vector< VFS_BYTE >* pData )
+{
+	RecordAccess( AbsoluteFileName.Get() );
+
+	if( File.dwBlockIndex != BLOCK_INDEX_INLINE && !pArchive->Activate() )
+		return VFS_FALSE;
+
+	IFile* pSource = ( IFile* )( VFS_DWORD )pArchive->GetFile();
+	VFS_DWORD dwVerifyMode = GetVerifyMode( VFS_READ );
+	if( pData == NULL && pArchive->GetHeader()->Filters.empty() && File.dwBlockIndex == BLOCK_INDEX_NONE && dwToRead >= File.dwCompressedSize )
+	{
+		if( !pArchive->ReadStoredFile( pSource, File, dwVerifyMode, pBuffer ) )
+			return VFS_FALSE;
+		if( pRead != NULL )
+			*pRead = File.dwCompressedSize;
+		return VFS_TRUE;
+	}
+
+	// Otherwise the File is decoded into the Data Vector (or the From Buffer) and copied from there if needed.
+	const VFS_BYTE* pDecoded;
+	VFS_DWORD dwSize;
+	DecodedBlock pBlock;
+	vector< VFS_BYTE >& Buffer = pData != NULL ? *pData : g_FromBuffer;
+	if( !pArchive->DecodeFile( pSource, File, dwVerifyMode, Buffer, pDecoded, dwSize, pBlock ) )
+		return VFS_FALSE;
+
+	if( pData != NULL )
+	{
+		if( pDecoded != pData->data() )
+			pData->assign( pDecoded, pDecoded + dwSize );
+		return VFS_TRUE;
+	}
+
+	if( dwSize > dwToRead )
+		dwSize = dwToRead;
+	if( dwSize > 0 )
+		memcpy( pBuffer, pDecoded, dwSize );
+	if( pRead != NULL )
+		*pRead = dwSize;
+	return VFS_TRUE;
+}
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTIONS
 //============================================================================
@@ -112,6 +222,8 @@ static VFS_Handle TryToOpen( const VFS_String& strFileName, VFS_DWORD dwFlags )
 // Creates a File in the First Root Path.
 VFS_Handle VFS_File_Create( const VFS_String& strFileName, VFS_DWORD dwFlags )
 {
+	COperationTimer Timer( VFS_OP_FILE_CREATE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -126,16 +238,16 @@ VFS_Handle VFS_File_Create( const VFS_String& strFileName, VFS_DWORD dwFlags )
 		return VFS_INVALID_HANDLE_VALUE;
 	}
 
-	// Make it absolute...
-	VFS_String strAbsoluteFileName = ToLower( strFileName );
-	if( !VFS_Util_IsAbsoluteFileName( strAbsoluteFileName ) )
-		strAbsoluteFileName = ToLower( WithoutTrailingSeparator( GetRootPaths()[ 0 ], VFS_TRUE ) + VFS_PATH_SEPARATOR + strFileName );
+	// Make it absolute (the VFS creates its Files with lower-cased Names)...
+	VFS_String strAbsoluteFileName = ToLower( GetAbsoluteTargetName( strFileName ) );
 
 	// Is such a File already open? Then just resize it.
 	if( GetOpenFiles().find( strAbsoluteFileName ) != GetOpenFiles().end() )
 	{
 		IFile* pFile = GetOpenFiles()[ strAbsoluteFileName ];
-		if( !pFile->Resize( 0 ) )
+		if( !pFile->IsArchived() && !static_cast< CStdIOFile* >( pFile )->MakeWritable() )
+			return VFS_INVALID_HANDLE_VALUE;
+		if( !pFile->Resize( 0 ) || !pFile->Seek( 0, VFS_SET ) )
 			return VFS_INVALID_HANDLE_VALUE;
 		pFile->Add();
 		return ( VFS_Handle )( VFS_DWORD )pFile;
@@ -146,7 +258,28 @@ VFS_Handle VFS_File_Create( const VFS_String& strFileName, VFS_DWORD dwFlags )
 }
 
 // Try to open a File with the specified Path (this function is way to big, hmm).
-VFS_Handle VFS_File_Open( const VFS_String& strFileName, VFS_DWORD dwFlags )
+VFS_Handle VFS_File_Open( VFS_StringView strFileName, VFS_DWORD dwFlags )
+{
+	return VFS_File_Open( VFS_Path( strFileName ), dwFlags );
+}
+
+VFS_Handle VFS_File_Open( const VFS_Path& FileName, VFS_DWORD dwFlags )
+{
+	COperationTimer Timer( VFS_OP_FILE_OPEN );
+
+	// Try to open the File and add it to the Access Trace (Standard Files by the Path they were opened with, the File Name is lower-cased).
+	VFS_Handle hFile = OpenFile( FileName, dwFlags );
+	if( hFile != VFS_INVALID_HANDLE_VALUE )
+	{
+		IFile* pFile = ( IFile* )( VFS_DWORD )hFile;
+		RecordAccess( pFile->IsArchived() ? pFile->GetFileName() : static_cast< CStdIOFile* >( pFile )->GetPath() );
+	}
+
+	return hFile;
+}
+
+// Open a File without adding it to the Access Trace.
+VFS_Handle OpenFile( const VFS_Path& FileName, VFS_DWORD dwFlags )
 {
 	// Not initialized yet?
 	if( !IsInit() )
@@ -156,19 +289,20 @@ VFS_Handle VFS_File_Open( const VFS_String& strFileName, VFS_DWORD dwFlags )
 	}
 
 	// No Root Paths specified yet?
-	if( GetRootPaths().size() == 0 && !VFS_Util_IsAbsoluteFileName( strFileName ) )
+	if( GetRootPaths().size() == 0 && !FileName.IsAbsolute() )
 	{
 		SetLastError( VFS_ERROR_NO_ROOT_PATHS_DEFINED );
 		return VFS_INVALID_HANDLE_VALUE;
 	}
 
-	// Try to open the File.
-	return TryToOpen( strFileName, dwFlags );
+	return TryToOpen( FileName, dwFlags );
 }
 
 // Close the File.
 VFS_BOOL VFS_File_Close( VFS_Handle hFile )
 {
+	COperationTimer Timer( VFS_OP_FILE_CLOSE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -227,6 +361,8 @@ VFS_BOOL VFS_File_Close( VFS_Handle hFile )
 // Read from the File.
 VFS_BOOL VFS_File_Read( VFS_Handle hFile, VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_DWORD* pRead )
 {
+	COperationTimer Timer( VFS_OP_FILE_READ );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -249,6 +385,8 @@ VFS_BOOL VFS_File_Read( VFS_Handle hFile, VFS_BYTE* pBuffer, VFS_DWORD dwToRead,
 
 VFS_BOOL VFS_File_Write( VFS_Handle hFile, const VFS_BYTE* pBuffer, VFS_DWORD dwToWrite, VFS_DWORD* pWritten )
 {
+	COperationTimer Timer( VFS_OP_FILE_WRITE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -272,8 +410,15 @@ VFS_BOOL VFS_File_Write( VFS_Handle hFile, const VFS_BYTE* pBuffer, VFS_DWORD dw
 // Direct File Reading / Writing (it seems that it's less an optimized version than a version to simplify reading fixed-sized files).
 
 // Read in the entire File at once.
-VFS_BOOL VFS_File_ReadEntireFile( const VFS_String& strFileName, VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_DWORD* pRead )
+VFS_BOOL VFS_File_ReadEntireFile( VFS_StringView strFileName, VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_DWORD* pRead )
+{
+	return VFS_File_ReadEntireFile( VFS_Path( strFileName ), pBuffer, dwToRead, pRead );
+}
+
+VFS_BOOL VFS_File_ReadEntireFile( const VFS_Path& FileName, VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_DWORD* pRead )
 {
+	COperationTimer Timer( VFS_OP_FILE_READ_ENTIRE_FILE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -281,8 +426,15 @@ VFS_BOOL VFS_File_ReadEntireFile( const VFS_String& strFileName, VFS_BYTE* pBuff
 		return VFS_FALSE;
 	}
 
+	// An archived File which isn't open is read without opening it.
+	VFS_Path AbsoluteFileName;
+	CArchive* pArchive;
+	const ArchiveFile* pFile;
+	if( pBuffer != NULL && FindArchivedFile( FileName, AbsoluteFileName, pArchive, pFile ) )
+		return ReadArchivedFile( AbsoluteFileName, pArchive, *pFile, pBuffer, dwToRead, pRead, NULL );
+
 	// Open the File.
-	VFS_Handle hFile = VFS_File_Open( strFileName, VFS_READ );
+	VFS_Handle hFile = VFS_File_Open( FileName, VFS_READ );
 	if( hFile == VFS_INVALID_HANDLE_VALUE )
 		return VFS_FALSE;
 
@@ -299,9 +451,86 @@ VFS_BOOL VFS_File_ReadEntireFile( const VFS_String& strFileName, VFS_BYTE* pBuff
 	return VFS_File_Close( hFile );
 }
 
+VFS_BOOL VFS_File_ReadEntireFile( VFS_StringView strFileName, vector< VFS_BYTE >& Data )
+{
+	return VFS_File_ReadEntireFile( VFS_Path( strFileName ), Data );
+}
+
+VFS_BOOL VFS_File_ReadEntireFile( const VFS_Path& FileName, vector< VFS_BYTE >& Data )
+{
+	COperationTimer Timer( VFS_OP_FILE_READ_ENTIRE_FILE );
+
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	// An archived File which isn't open is decoded right into the Vector.
+	VFS_Path AbsoluteFileName;
+	CArchive* pArchive;
+	const ArchiveFile* pFile;
+	if( FindArchivedFile( FileName, AbsoluteFileName, pArchive, pFile ) )
+		return ReadArchivedFile( AbsoluteFileName, pArchive, *pFile, NULL, 0, NULL, &Data );
+
+	// Open the File.
+	VFS_Handle hFile = VFS_File_Open( FileName, VFS_READ );
+	if( hFile == VFS_INVALID_HANDLE_VALUE )
+		return VFS_FALSE;
+
+	// Read in the Rest of the File.
+	VFS_LONG lSize = VFS_File_GetSize( hFile ) - VFS_File_Tell( hFile );
+	Data.resize( lSize > 0 ? ( VFS_DWORD )lSize : 0 );
+	VFS_DWORD dwRead = 0;
+	if( !Data.empty() && !VFS_File_Read( hFile, Data.data(), ( VFS_DWORD )Data.size(), &dwRead ) )
+	{
+		Data.clear();
+		VFS_File_Close( hFile );
+		return VFS_FALSE;
+	}
+	Data.resize( dwRead );
+
+	return VFS_File_Close( hFile );
+}
+
+// Get the Size of a File as it's read.
+VFS_BOOL VFS_File_GetDecodedSize( VFS_StringView strFileName, VFS_LONG& lSize )
+{
+	return VFS_File_GetDecodedSize( VFS_Path( strFileName ), lSize );
+}
+
+VFS_BOOL VFS_File_GetDecodedSize( const VFS_Path& FileName, VFS_LONG& lSize )
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	// Archived Files are looked up in their Index.
+	VFS_Path AbsoluteFileName;
+	CArchive* pArchive;
+	const ArchiveFile* pFile;
+	if( FindArchivedFile( FileName, AbsoluteFileName, pArchive, pFile ) )
+	{
+		lSize = pFile->dwUncompressedSize;
+		return VFS_TRUE;
+	}
+
+	VFS_EntityInfo Info;
+	if( !VFS_File_GetInfo( FileName, Info ) )
+		return VFS_FALSE;
+	lSize = Info.lSize;
+	return VFS_TRUE;
+}
+
 // Write the entire File at once.
 VFS_BOOL VFS_File_WriteEntireFile( const VFS_String& strFileName, const VFS_BYTE* pBuffer, VFS_DWORD dwToWrite, VFS_DWORD* pWritten )
 {
+	COperationTimer Timer( VFS_OP_FILE_WRITE_ENTIRE_FILE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -332,6 +561,8 @@ VFS_BOOL VFS_File_WriteEntireFile( const VFS_String& strFileName, const VFS_BYTE
 // Seek in the File.
 VFS_BOOL VFS_File_Seek( VFS_Handle hFile, VFS_LONG lPosition, VFS_SeekOrigin eOrigin )
 {
+	COperationTimer Timer( VFS_OP_FILE_SEEK );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -380,6 +611,8 @@ VFS_LONG VFS_File_Tell( VFS_Handle hFile )
 // Resize the File.
 VFS_BOOL VFS_File_Resize( VFS_Handle hFile, VFS_LONG lSize )
 {
+	COperationTimer Timer( VFS_OP_FILE_RESIZE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -400,6 +633,29 @@ VFS_BOOL VFS_File_Resize( VFS_Handle hFile, VFS_LONG lSize )
 	return pFile->Resize( lSize );
 }
 
+// Reserve Space for the File.
+VFS_BOOL VFS_File_Preallocate( VFS_Handle hFile, VFS_LONG lSize )
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	// Invalid Handle Value?
+	if( hFile == VFS_INVALID_HANDLE_VALUE )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	// Get the File Pointer.
+	IFile* pFile = ( IFile* )( VFS_DWORD )hFile;
+
+	return pFile->Preallocate( lSize );
+}
+
 VFS_LONG VFS_File_GetSize( VFS_Handle hFile )
 {
 	// Not initialized yet?
@@ -425,8 +681,15 @@ VFS_LONG VFS_File_GetSize( VFS_Handle hFile )
 // Information.
 
 // Determines whether a File with the specified File Name exists.
-VFS_BOOL VFS_File_Exists( const VFS_String& strFileName )
+VFS_BOOL VFS_File_Exists( VFS_StringView strFileName )
+{
+	return VFS_File_Exists( VFS_Path( strFileName ) );
+}
+
+VFS_BOOL VFS_File_Exists( const VFS_Path& FileName )
 {
+	COperationTimer Timer( VFS_OP_FILE_EXISTS );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -435,7 +698,7 @@ VFS_BOOL VFS_File_Exists( const VFS_String& strFileName )
 	}
 
 	// Just try to open the File.
-	VFS_Handle hFile = VFS_File_Open( strFileName, VFS_READ );
+	VFS_Handle hFile = VFS_File_Open( FileName, VFS_READ );
 
     // Not found?
 	if( hFile == VFS_INVALID_HANDLE_VALUE )
@@ -449,8 +712,15 @@ VFS_BOOL VFS_File_Exists( const VFS_String& strFileName )
 }
 
 // Returns Information about the specified File.
-VFS_BOOL VFS_File_GetInfo( const VFS_String& strFileName, VFS_EntityInfo& Info )
+VFS_BOOL VFS_File_GetInfo( VFS_StringView strFileName, VFS_EntityInfo& Info )
+{
+	return VFS_File_GetInfo( VFS_Path( strFileName ), Info );
+}
+
+VFS_BOOL VFS_File_GetInfo( const VFS_Path& FileName, VFS_EntityInfo& Info )
 {
+	COperationTimer Timer( VFS_OP_FILE_GET_INFO );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -459,7 +729,7 @@ VFS_BOOL VFS_File_GetInfo( const VFS_String& strFileName, VFS_EntityInfo& Info )
 	}
 
 	// Try to open the File.
-	VFS_Handle hFile = VFS_File_Open( strFileName, VFS_READ );
+	VFS_Handle hFile = VFS_File_Open( FileName, VFS_READ );
 	if( hFile == VFS_INVALID_HANDLE_VALUE )
 		return VFS_FALSE;
 
@@ -498,7 +768,7 @@ VFS_BOOL VFS_File_GetInfo( VFS_Handle hFile, VFS_EntityInfo& Info )
 	Info.bArchived = pFile->IsArchived();
 	Info.eType = VFS_FILE;
 	Info.lSize = pFile->GetSize();
-	Info.strPath = pFile->GetFileName();
+	Info.strPath = pFile->IsArchived() ? pFile->GetFileName() : static_cast< CStdIOFile* >( pFile )->GetPath();
 	return VFS_Util_GetName( Info.strPath, Info.strName );
 }
 
@@ -507,6 +777,8 @@ VFS_BOOL VFS_File_GetInfo( VFS_Handle hFile, VFS_EntityInfo& Info )
 // Delete the File with the specified File Name.
 VFS_BOOL VFS_File_Delete( const VFS_String& strFileName )
 {
+	COperationTimer Timer( VFS_OP_FILE_DELETE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -533,13 +805,14 @@ VFS_BOOL VFS_File_Delete( const VFS_String& strFileName )
 		return VFS_FALSE;
 	}
 
-	// Get the absolute File Name.
-	VFS_String strAbsoluteFileName = pFile->GetFileName();
+	// Get the absolute File Name (the Path the File System knows it by).
+	VFS_String strAbsoluteFileName = static_cast< CStdIOFile* >( pFile )->GetPath();
 
 	// Close the File.
 	VFS_File_Close( hFile );
 
 	// Try to delete the File.
+	AddStat( STAT_SYSCALLS );
 	if( !VFS_UNLINK( strAbsoluteFileName ) )
 	{
 		SetLastError( VFS_ERROR_PERMISSION_DENIED );
@@ -552,7 +825,7 @@ VFS_BOOL VFS_File_Delete( const VFS_String& strFileName )
 // Copy the specified File.
 VFS_BOOL VFS_File_Copy( const VFS_String& strFrom, const VFS_String& strTo )
 {
-	static VFS_BYTE Chunk[ FILE_COPY_CHUNK_SIZE ];
+	COperationTimer Timer( VFS_OP_FILE_COPY );
 
 	// Not initialized yet?
 	if( !IsInit() )
@@ -567,7 +840,7 @@ VFS_BOOL VFS_File_Copy( const VFS_String& strFrom, const VFS_String& strTo )
 		return VFS_FALSE;
 
 	VFS_Handle hOut = VFS_File_Create( strTo, VFS_WRITE );
-	if( hIn == VFS_INVALID_HANDLE_VALUE )
+	if( hOut == VFS_INVALID_HANDLE_VALUE )
 	{
 		// Close the Input File.
 		VFS_File_Close( hIn );
@@ -575,57 +848,47 @@ VFS_BOOL VFS_File_Copy( const VFS_String& strFrom, const VFS_String& strTo )
 		return VFS_FALSE;
 	}
 
-	// Until EOF...
-	VFS_DWORD dwRead, dwWritten;
-	do
-	{
-		// Read in a Chunk.
-		if( !VFS_File_Read( hIn, Chunk, FILE_COPY_CHUNK_SIZE, &dwRead ) )
-		{
-			// Close the Files.
-			VFS_File_Close( hOut );
-			VFS_File_Close( hIn );
-
-			return VFS_FALSE;
-		}
-
-		// Write the Chunk.
-		if( !VFS_File_Write( hOut, Chunk, dwRead, &dwWritten ) )
-		{
-			// Close the Files.
-			VFS_File_Close( hOut );
-			VFS_File_Close( hIn );
+	IFile* pIn = ( IFile* )( VFS_DWORD )hIn;
+	IFile* pOut = ( IFile* )( VFS_DWORD )hOut;
+	VFS_LONG lSize = pIn->GetSize();
 
-			return VFS_FALSE;
-		}
+	// Two Standard Files? Then let the Kernel copy the Data.
+	VFS_BOOL bResult;
+	if( !pIn->IsArchived() && !pOut->IsArchived() )
+		bResult = static_cast< CStdIOFile* >( pIn )->CopyTo( static_cast< CStdIOFile* >( pOut ) );
+	else
+	{
+		// We know the final Size.
+		bResult = pOut->Preallocate( lSize );
 
-        // Unknown Error?
-		if( dwWritten < dwRead )
+		// Copy the Data Chunk by Chunk (Archive Files don't allow reading behind their End, so we read exactly lSize Bytes).
+		vector< VFS_BYTE > Buffer( lSize > 0 ? ( VFS_DWORD )min< VFS_LONG >( lSize, FILE_COPY_BUFFER_SIZE ) : 0 );
+		for( VFS_LONG lCopied = 0; bResult && lCopied < lSize; )
 		{
-			// Close the Files.
-			VFS_File_Close( hOut );
-			VFS_File_Close( hIn );
+			VFS_DWORD dwChunk = lSize - lCopied < ( VFS_LONG )Buffer.size() ? ( VFS_DWORD )( lSize - lCopied ) : ( VFS_DWORD )Buffer.size();
+			VFS_DWORD dwRead, dwWritten;
 
-			return VFS_FALSE;
+			// Read in a Chunk and write it.
+			bResult = pIn->Read( &*Buffer.begin(), dwChunk, &dwRead ) && dwRead > 0 &&
+				pOut->Write( &*Buffer.begin(), dwRead, &dwWritten ) && dwWritten == dwRead;
+			lCopied += dwRead;
 		}
 	}
-	while( dwRead > 0 );
 
 	// Close the Files.
 	if( !VFS_File_Close( hOut ) )
-	{
-		// Close the Input File.
-		VFS_File_Close( hIn );
-
-		return VFS_FALSE;
-	}
+		bResult = VFS_FALSE;
+	if( !VFS_File_Close( hIn ) )
+		bResult = VFS_FALSE;
 
-	return VFS_File_Close( hIn );
+	return bResult;
 }
 
 // Move the specified File.
 VFS_BOOL VFS_File_Move( const VFS_String& strFrom, const VFS_String& strTo )
 {
+	COperationTimer Timer( VFS_OP_FILE_MOVE );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -633,17 +896,55 @@ VFS_BOOL VFS_File_Move( const VFS_String& strFrom, const VFS_String& strTo )
 		return VFS_FALSE;
 	}
 
-	// Try to copy the file.
-	if( !VFS_File_Copy( strFrom, strTo ) )
+	// No Root Paths specified yet?
+	if( GetRootPaths().size() == 0 && !VFS_Util_IsAbsoluteFileName( strTo ) )
+	{
+		SetLastError( VFS_ERROR_NO_ROOT_PATHS_DEFINED );
+		return VFS_FALSE;
+	}
+
+	// Try to open the file to get the absolute file name and to see if the file is still open
+	// and if it's not in an Archive (VFS_WRITE would fail otherwise).
+	VFS_Handle hFile = VFS_File_Open( strFrom, VFS_READ | VFS_WRITE );
+	if( hFile == VFS_INVALID_HANDLE_VALUE )
+		return VFS_FALSE;
+
+	// Get the File Pointer.
+	IFile* pFile = ( IFile* )( VFS_DWORD )hFile;
+
+	// Check if there are still references to the File (but count ourself).
+	if( pFile->GetRefCount() > 1 )
+	{
+		// Close the File.
+		VFS_File_Close( hFile );
+
+		SetLastError( VFS_ERROR_IN_USE );
+		return VFS_FALSE;
+	}
+
+	// Get the absolute File Name (the Path the File System knows it by).
+	VFS_String strAbsoluteFileName = static_cast< CStdIOFile* >( pFile )->GetPath();
+
+	// Close the File.
+	VFS_File_Close( hFile );
+
+	// The Target mustn't be open either.
+	VFS_String strAbsoluteTo = GetAbsoluteTargetName( strTo );
+	if( GetOpenFiles().find( ToLower( strAbsoluteTo ) ) != GetOpenFiles().end() )
+	{
+		SetLastError( VFS_ERROR_IN_USE );
 		return VFS_FALSE;
+	}
 
-	// Try to delete the Source File.
-	return VFS_File_Delete( strFrom );
+	// Try to rename the File (or copy it to another Device).
+	return CStdIOFile::Move( strAbsoluteFileName, strAbsoluteTo );
 }
 
 // Rename the specified File.
 VFS_BOOL VFS_File_Rename( const VFS_String& strFrom, const VFS_String& strTo )				// pszTo has to be a single File Name without a Path.
 {
+	COperationTimer Timer( VFS_OP_FILE_RENAME );
+
 	// Not initialized yet?
 	if( !IsInit() )
 	{
@@ -670,8 +971,8 @@ VFS_BOOL VFS_File_Rename( const VFS_String& strFrom, const VFS_String& strTo )
 		return VFS_FALSE;
 	}
 
-	// Get the absolute File Name.
-	VFS_String strAbsoluteFileName = pFile->GetFileName();
+	// Get the absolute File Name (the Path the File System knows it by).
+	VFS_String strAbsoluteFileName = static_cast< CStdIOFile* >( pFile )->GetPath();
 
 	// Close the File.
 	VFS_File_Close( hFile );
@@ -682,6 +983,7 @@ VFS_BOOL VFS_File_Rename( const VFS_String& strFrom, const VFS_String& strTo )
 	strAbsoluteTo = WithoutTrailingSeparator( strAbsoluteTo, VFS_TRUE ) + VFS_PATH_SEPARATOR + strTo;
 
 	// Try to rename the File.
+	AddStat( STAT_SYSCALLS );
 	if( !VFS_RENAME( strAbsoluteFileName, strAbsoluteTo ) )
 	{
 		SetLastError( VFS_ERROR_PERMISSION_DENIED );
@@ -0,0 +1,510 @@
+//****************************************************************************
+//**
+//**    VFS_STATS.CPP
+//**    Runtime Statistics
+//**
+//**	Project:	VFS
+//**	Component:	Stats
+//**
+//**	History:
+//**		19.10.2026		Created
+//****************************************************************************
+
+//============================================================================
+//    IMPLEMENTATION HEADERS
+//============================================================================
+#include "VFS_Implementation.h"
+#include <mutex>
+#include <chrono>
+#include <cstdarg>
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
+//============================================================================
+// All Counters and Latency Slots in a flat Array (Counters first).
+static const VFS_DWORD NUM_STAT_SLOTS = NUM_STAT_COUNTERS + NUM_LATENCY_SLOTS;
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE CLASS PROTOTYPES / EXTERNAL CLASS REFERENCES
+//============================================================================
+//============================================================================
+//    IMPLEMENTATION PRIVATE STRUCTURES / UTILITY CLASSES
+//============================================================================
+// The Registry of all Threads which have touched a Counter.
+struct StatRegistry {
+	mutex Mutex;
+	vector< StatBlock* > Blocks;
+
+	// The Slots of Threads which have already terminated.
+	vector< VFS_QWORD > Retired;
+
+	// The Slot Values at the Time of the last VFS_ResetStats() Call.
+	vector< VFS_QWORD > Base;
+
+	StatRegistry()
+	: Retired( NUM_STAT_SLOTS, 0 ), Base( NUM_STAT_SLOTS, 0 )
+	{
+	}
+};
+
+// Registers itself on Construction and retires its Counters on Thread Exit.
+class CThreadStats : public StatBlock {
+public:
+	CThreadStats();
+	~CThreadStats();
+};
+
+//============================================================================
+//    IMPLEMENTATION REQUIRED EXTERNAL REFERENCES (AVOID)
+//============================================================================
+//============================================================================
+//    IMPLEMENTATION PRIVATE DATA
+//============================================================================
+// The Operation Names (in the Order of the VFS_Operation Enumeration).
+static VFS_PCSTR g_OperationNames[] =
+{
+	VFS_TEXT( "file_create" ),
+	VFS_TEXT( "file_open" ),
+	VFS_TEXT( "file_close" ),
+	VFS_TEXT( "file_read" ),
+	VFS_TEXT( "file_write" ),
+	VFS_TEXT( "file_read_entire_file" ),
+	VFS_TEXT( "file_write_entire_file" ),
+	VFS_TEXT( "file_seek" ),
+	VFS_TEXT( "file_resize" ),
+	VFS_TEXT( "file_exists" ),
+	VFS_TEXT( "file_get_info" ),
+	VFS_TEXT( "file_delete" ),
+	VFS_TEXT( "file_copy" ),
+	VFS_TEXT( "file_move" ),
+	VFS_TEXT( "file_rename" ),
+	VFS_TEXT( "archive_create_from_directory" ),
+	VFS_TEXT( "archive_create_from_file_list" ),
+	VFS_TEXT( "archive_extract" ),
+	VFS_TEXT( "archive_extract_file" ),
+	VFS_TEXT( "archive_get_info" ),
+	VFS_TEXT( "archive_flush" ),
+	VFS_TEXT( "dir_create" ),
+	VFS_TEXT( "dir_delete" ),
+	VFS_TEXT( "dir_move" ),
+	VFS_TEXT( "dir_exists" ),
+	VFS_TEXT( "dir_get_info" ),
+	VFS_TEXT( "dir_iterate" ),
+	VFS_TEXT( "dir_get_contents" ),
+	VFS_TEXT( "exists_entity" ),
+	VFS_TEXT( "get_entity_info" ),
+	VFS_TEXT( "flush" ),
+	VFS_TEXT( "archive_lookup" ),
+	VFS_TEXT( "archive_parse" ),
+	VFS_TEXT( "archive_read" ),
+	VFS_TEXT( "decode" )
+};
+
+// The Counter Names for the Export (in the Order of the StatCounter Enumeration).
+static const char* g_CounterNames[] =
+{
+	"vfs_stdio_file_opens_total",
+	"vfs_archive_file_opens_total",
+	"vfs_bytes_read_total",
+	"vfs_bytes_written_total",
+	"vfs_bytes_decoded_total",
+	"vfs_decode_nanoseconds_total",
+	"vfs_archive_parses_total",
+	"vfs_root_path_probes_total",
+	"vfs_syscalls_total",
+	"vfs_bytes_verified_total",
+	"vfs_checksum_mismatches_total",
+	"vfs_bytes_prefetched_total",
+	"vfs_block_cache_hits_total",
+	"vfs_block_cache_misses_total",
+	"vfs_archive_dir_loads_total",
+	"vfs_archive_evictions_total"
+};
+
+//============================================================================
+//    INTERFACE DATA
+//============================================================================
+//============================================================================
+//    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
+//============================================================================
+static StatRegistry& GetRegistry();
+static VFS_QWORD GetSlot( const StatBlock* pBlock, VFS_DWORD dwSlot );
+static void SumSlots( vector< VFS_QWORD >& Sum );
+static void GetCurrentSlots( vector< VFS_QWORD >& Slots );
+static VFS_DWORD GetLatencyBucket( VFS_QWORD qwNanoseconds );
+static VFS_QWORD GetLatencyBucketLimit( VFS_DWORD dwBucket );
+static VFS_BOOL FillHistogram( const vector< VFS_QWORD >& Slots, VFS_Operation eOperation, VFS_Histogram& Histogram );
+static VFS_BOOL ExportLine( VFS_StatsExportProc pExportProc, void* pParam, const char* pszFormat, ... );
+static VFS_BOOL FileExportProc( const char* pszLine, void* pParam );
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE FUNCTIONS
+//============================================================================
+static StatRegistry& GetRegistry()
+{
+	static StatRegistry Registry;
+	return Registry;
+}
+
+// Returns a Slot (Counter or Latency Slot) of a Statistics Block.
+static VFS_QWORD GetSlot( const StatBlock* pBlock, VFS_DWORD dwSlot )
+{
+	if( dwSlot < NUM_STAT_COUNTERS )
+		return pBlock->Counters[ dwSlot ].load( memory_order_relaxed );
+	return pBlock->pLatencies[ dwSlot - NUM_STAT_COUNTERS ].load( memory_order_relaxed );
+}
+
+// Sums up the Slots of all (living and terminated) Threads (the Registry must be locked).
+static void SumSlots( vector< VFS_QWORD >& Sum )
+{
+	StatRegistry& Registry = GetRegistry();
+	Sum = Registry.Retired;
+
+	for( vector< StatBlock* >::iterator iter = Registry.Blocks.begin(); iter != Registry.Blocks.end(); iter++ )
+	{
+		for( VFS_DWORD dwSlot = 0; dwSlot < NUM_STAT_SLOTS; dwSlot++ )
+			Sum[ dwSlot ] += GetSlot( *iter, dwSlot );
+	}
+}
+
+// Returns the Slots since the last VFS_ResetStats() Call.
+static void GetCurrentSlots( vector< VFS_QWORD >& Slots )
+{
+	StatRegistry& Registry = GetRegistry();
+	lock_guard< mutex > Lock( Registry.Mutex );
+	SumSlots( Slots );
+	for( VFS_DWORD dwSlot = 0; dwSlot < NUM_STAT_SLOTS; dwSlot++ )
+		Slots[ dwSlot ] -= Registry.Base[ dwSlot ];
+}
+
+// Returns the Histogram Bucket for a Latency.
+static VFS_DWORD GetLatencyBucket( VFS_QWORD qwNanoseconds )
+{
+	if( qwNanoseconds < LATENCY_SUB_BUCKETS )
+		return ( VFS_DWORD )qwNanoseconds;
+
+	// Get the Exponent (i.e. the Index of the highest Bit set).
+	VFS_DWORD dwExponent;
+#if defined( __GNUC__ )
+	dwExponent = 63 - __builtin_clzll( qwNanoseconds );
+#else
+	dwExponent = 0;
+	while( ( qwNanoseconds >> ( dwExponent + 1 ) ) != 0 )
+		dwExponent++;
+#endif
+	if( dwExponent > LATENCY_MAX_EXPONENT )
+		return NUM_LATENCY_BUCKETS - 1;
+
+	// The Bits below the highest one select the Sub Bucket.
+	VFS_DWORD dwShift = dwExponent - LATENCY_SUB_BUCKET_BITS;
+	return LATENCY_SUB_BUCKETS + dwShift * LATENCY_SUB_BUCKETS + ( VFS_DWORD )( ( qwNanoseconds >> dwShift ) & ( LATENCY_SUB_BUCKETS - 1 ) );
+}
+
+// Returns the (exclusive) upper Limit of a Histogram Bucket.
+static VFS_QWORD GetLatencyBucketLimit( VFS_DWORD dwBucket )
+{
+	if( dwBucket < LATENCY_SUB_BUCKETS )
+		return dwBucket + 1;
+
+	VFS_DWORD dwShift = ( dwBucket - LATENCY_SUB_BUCKETS ) / LATENCY_SUB_BUCKETS;
+	VFS_DWORD dwSub = ( dwBucket - LATENCY_SUB_BUCKETS ) % LATENCY_SUB_BUCKETS;
+	return ( VFS_QWORD )( LATENCY_SUB_BUCKETS + dwSub + 1 ) << dwShift;
+}
+
+// Fills a Histogram from the summed up Slots.
+static VFS_BOOL FillHistogram( const vector< VFS_QWORD >& Slots, VFS_Operation eOperation, VFS_Histogram& Histogram )
+{
+	if( eOperation < 0 || eOperation >= VFS_NUM_OPERATIONS )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	VFS_DWORD dwFirst = NUM_STAT_COUNTERS + eOperation * LATENCY_SLOTS_PER_OPERATION;
+	Histogram.Counts.resize( NUM_LATENCY_BUCKETS );
+	Histogram.Limits.resize( NUM_LATENCY_BUCKETS );
+	Histogram.qwCount = 0;
+	for( VFS_DWORD dwBucket = 0; dwBucket < NUM_LATENCY_BUCKETS; dwBucket++ )
+	{
+		Histogram.Counts[ dwBucket ] = Slots[ dwFirst + dwBucket ];
+		Histogram.Limits[ dwBucket ] = GetLatencyBucketLimit( dwBucket );
+		Histogram.qwCount += Histogram.Counts[ dwBucket ];
+	}
+	Histogram.qwSumNanoseconds = Slots[ dwFirst + NUM_LATENCY_BUCKETS ];
+
+	return VFS_TRUE;
+}
+
+// Formats a Line and passes it to the Export Procedure (sets the Error if the Procedure cancels the Export).
+static VFS_BOOL ExportLine( VFS_StatsExportProc pExportProc, void* pParam, const char* pszFormat, ... )
+{
+	char szLine[ 256 ];
+	va_list Args;
+	va_start( Args, pszFormat );
+	vsnprintf( szLine, sizeof( szLine ), pszFormat, Args );
+	va_end( Args );
+
+	if( !pExportProc( szLine, pParam ) )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// Writes an exported Line to a File.
+static VFS_BOOL FileExportProc( const char* pszLine, void* pParam )
+{
+	FILE* pFile = ( FILE* ) pParam;
+	return fputs( pszLine, pFile ) >= 0 && fputc( '\n', pFile ) != EOF;
+}
+
+//============================================================================
+//    INTERFACE FUNCTIONS
+//============================================================================
+// Returns the Statistics (summed up over all Threads since the last VFS_ResetStats() Call).
+VFS_BOOL VFS_GetStats( VFS_Stats& Stats )
+{
+	vector< VFS_QWORD > Sum;
+	GetCurrentSlots( Sum );
+
+	Stats.qwStdIOFileOpens = Sum[ STAT_STDIO_FILE_OPENS ];
+	Stats.qwArchiveFileOpens = Sum[ STAT_ARCHIVE_FILE_OPENS ];
+	Stats.qwBytesRead = Sum[ STAT_BYTES_READ ];
+	Stats.qwBytesWritten = Sum[ STAT_BYTES_WRITTEN ];
+	Stats.qwBytesDecoded = Sum[ STAT_BYTES_DECODED ];
+	Stats.qwDecodeNanoseconds = Sum[ STAT_DECODE_NANOSECONDS ];
+	Stats.qwBytesVerified = Sum[ STAT_BYTES_VERIFIED ];
+	Stats.qwChecksumMismatches = Sum[ STAT_CHECKSUM_MISMATCHES ];
+	Stats.qwBytesPrefetched = Sum[ STAT_BYTES_PREFETCHED ];
+	Stats.qwBlockCacheHits = Sum[ STAT_BLOCK_CACHE_HITS ];
+	Stats.qwBlockCacheMisses = Sum[ STAT_BLOCK_CACHE_MISSES ];
+	Stats.qwArchiveParses = Sum[ STAT_ARCHIVE_PARSES ];
+	Stats.qwArchiveDirLoads = Sum[ STAT_ARCHIVE_DIR_LOADS ];
+	Stats.qwArchiveEvictions = Sum[ STAT_ARCHIVE_EVICTIONS ];
+	Stats.qwRootPathProbes = Sum[ STAT_ROOT_PATH_PROBES ];
+	Stats.qwSyscalls = Sum[ STAT_SYSCALLS ];
+
+	// The Gauges aren't counted but taken from the Open Files and Archives Maps.
+	Stats.dwOpenFiles = ( VFS_DWORD )GetOpenFiles().size();
+	Stats.dwOpenArchives = ( VFS_DWORD )GetOpenArchives().size();
+
+	return VFS_TRUE;
+}
+
+// Resets the Statistics (the Counters of the other Threads aren't touched, the current Sums are remembered instead).
+VFS_BOOL VFS_ResetStats()
+{
+	StatRegistry& Registry = GetRegistry();
+	lock_guard< mutex > Lock( Registry.Mutex );
+	SumSlots( Registry.Base );
+
+	return VFS_TRUE;
+}
+
+// Returns the Latency Histogram of an Operation.
+VFS_BOOL VFS_GetLatencyHistogram( VFS_Operation eOperation, VFS_Histogram& Histogram )
+{
+	vector< VFS_QWORD > Slots;
+	GetCurrentSlots( Slots );
+
+	return FillHistogram( Slots, eOperation, Histogram );
+}
+
+// Returns the upper Limit of the Bucket containing the specified Percentile (0 if there were no Calls).
+VFS_QWORD VFS_GetLatencyPercentile( VFS_Operation eOperation, double dPercentile )
+{
+	VFS_Histogram Histogram;
+	if( !VFS_GetLatencyHistogram( eOperation, Histogram ) )
+		return 0;
+	if( Histogram.qwCount == 0 )
+		return 0;
+
+	// Get the Rank of the Percentile (at least the first Call).
+	double dRank = dPercentile / 100.0 * Histogram.qwCount;
+	VFS_QWORD qwRank = ( VFS_QWORD )dRank;
+	if( qwRank < dRank || qwRank == 0 )
+		qwRank++;
+
+	VFS_QWORD qwSeen = 0;
+	for( VFS_DWORD dwBucket = 0; dwBucket < NUM_LATENCY_BUCKETS; dwBucket++ )
+	{
+		qwSeen += Histogram.Counts[ dwBucket ];
+		if( qwSeen >= qwRank )
+			return Histogram.Limits[ dwBucket ];
+	}
+
+	return Histogram.Limits[ NUM_LATENCY_BUCKETS - 1 ];
+}
+
+// Returns the Name of an Operation (as used by the Export).
+VFS_PCSTR VFS_GetOperationName( VFS_Operation eOperation )
+{
+	if( eOperation < 0 || eOperation >= VFS_NUM_OPERATIONS )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_INVALID_POINTER_VALUE;
+	}
+
+	return g_OperationNames[ eOperation ];
+}
+
+// Exports the Counters and Histograms in the Prometheus Text Format.
+// The Histogram Buckets are exported at each Power of Two (the fine Buckets are aligned to them, so the cumulative Counts
+// are exact); Operations which haven't been called yet are omitted.
+VFS_BOOL VFS_ExportStats( VFS_StatsExportProc pExportProc, void* pParam )
+{
+	// Invalid Parameter?
+	if( pExportProc == NULL )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	vector< VFS_QWORD > Slots;
+	GetCurrentSlots( Slots );
+
+	// The Counters.
+	for( VFS_DWORD dwCounter = 0; dwCounter < NUM_STAT_COUNTERS; dwCounter++ )
+	{
+		if( !ExportLine( pExportProc, pParam, "# TYPE %s counter", g_CounterNames[ dwCounter ] ) ||
+			!ExportLine( pExportProc, pParam, "%s %llu", g_CounterNames[ dwCounter ], Slots[ dwCounter ] ) )
+			return VFS_FALSE;
+	}
+
+	// The Gauges.
+	if( !ExportLine( pExportProc, pParam, "# TYPE vfs_open_files gauge" ) ||
+		!ExportLine( pExportProc, pParam, "vfs_open_files %lu", ( unsigned long )GetOpenFiles().size() ) ||
+		!ExportLine( pExportProc, pParam, "# TYPE vfs_open_archives gauge" ) ||
+		!ExportLine( pExportProc, pParam, "vfs_open_archives %lu", ( unsigned long )GetOpenArchives().size() ) )
+		return VFS_FALSE;
+
+	// The Histograms.
+	if( !ExportLine( pExportProc, pParam, "# TYPE vfs_operation_latency_seconds histogram" ) )
+		return VFS_FALSE;
+	for( VFS_DWORD dwOperation = 0; dwOperation < VFS_NUM_OPERATIONS; dwOperation++ )
+	{
+		VFS_Histogram Histogram;
+		FillHistogram( Slots, ( VFS_Operation ) dwOperation, Histogram );
+		if( Histogram.qwCount == 0 )
+			continue;
+
+		// The Operation Names are plain ASCII.
+		char szOperation[ 64 ];
+		VFS_DWORD dwChar;
+		for( dwChar = 0; g_OperationNames[ dwOperation ][ dwChar ] != 0 && dwChar < sizeof( szOperation ) - 1; dwChar++ )
+			szOperation[ dwChar ] = ( char ) g_OperationNames[ dwOperation ][ dwChar ];
+		szOperation[ dwChar ] = 0;
+
+		VFS_QWORD qwCumulative = 0;
+		VFS_DWORD dwBucket = 0;
+		for( VFS_DWORD dwExponent = 0; dwExponent <= LATENCY_MAX_EXPONENT; dwExponent++ )
+		{
+			VFS_QWORD qwLimit = ( VFS_QWORD )1 << dwExponent;
+			while( dwBucket < NUM_LATENCY_BUCKETS - 1 && Histogram.Limits[ dwBucket ] <= qwLimit )
+				qwCumulative += Histogram.Counts[ dwBucket++ ];
+
+			if( !ExportLine( pExportProc, pParam, "vfs_operation_latency_seconds_bucket{operation=\"%s\",le=\"%.9g\"} %llu",
+							 szOperation, qwLimit / 1e9, qwCumulative ) )
+				return VFS_FALSE;
+		}
+
+		if( !ExportLine( pExportProc, pParam, "vfs_operation_latency_seconds_bucket{operation=\"%s\",le=\"+Inf\"} %llu", szOperation, Histogram.qwCount ) ||
+			!ExportLine( pExportProc, pParam, "vfs_operation_latency_seconds_sum{operation=\"%s\"} %.9f", szOperation, Histogram.qwSumNanoseconds / 1e9 ) ||
+			!ExportLine( pExportProc, pParam, "vfs_operation_latency_seconds_count{operation=\"%s\"} %llu", szOperation, Histogram.qwCount ) )
+			return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// Exports the Counters and Histograms to a File (see VFS_ExportStats()).
+VFS_BOOL VFS_ExportStatsToFile( const VFS_String& strFileName )
+{
+	VFS_String strTempFileName = strFileName + VFS_TEXT( ".tmp" );
+
+	AddStat( STAT_SYSCALLS );
+	FILE* pFile = VFS_FOPEN( strTempFileName, VFS_String( VFS_TEXT( "wb" ) ) );
+	if( pFile == NULL )
+	{
+		SetLastError( VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	VFS_BOOL bResult = VFS_ExportStats( FileExportProc, ( void* ) pFile ) && !ferror( pFile );
+	AddStat( STAT_SYSCALLS );
+	if( fclose( pFile ) != 0 )
+		bResult = VFS_FALSE;
+
+	// Replace the old File.
+	AddStat( STAT_SYSCALLS );
+	if( !bResult || !VFS_RENAME( strTempFileName, strFileName ) )
+	{
+		// Remove the temporary File (the Export failed either way).
+		( void )VFS_UNLINK( strTempFileName );
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// Internal Stuff.
+
+// Get the Statistics Counters of the calling Thread.
+StatBlock& GetThreadStats()
+{
+	static thread_local CThreadStats Stats;
+	return Stats;
+}
+
+// Returns a monotonic Time Stamp (in Nanoseconds).
+VFS_QWORD GetTimeStamp()
+{
+	return ( VFS_QWORD )chrono::duration_cast< chrono::nanoseconds >( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+// Adds a Latency to the Histogram of an Operation of the calling Thread.
+void AddLatency( VFS_Operation eOperation, VFS_QWORD qwNanoseconds )
+{
+	atomic< VFS_QWORD >* pSlots = GetThreadStats().pLatencies + eOperation * LATENCY_SLOTS_PER_OPERATION;
+	atomic< VFS_QWORD >& Bucket = pSlots[ GetLatencyBucket( qwNanoseconds ) ];
+	atomic< VFS_QWORD >& Sum = pSlots[ NUM_LATENCY_BUCKETS ];
+	Bucket.store( Bucket.load( memory_order_relaxed ) + 1, memory_order_relaxed );
+	Sum.store( Sum.load( memory_order_relaxed ) + qwNanoseconds, memory_order_relaxed );
+}
+
+//============================================================================
+//    INTERFACE CLASS BODIES
+//============================================================================
+// --- Thread Statistics Class ---
+// Constructor / Destructor.
+CThreadStats::CThreadStats()
+{
+	for( VFS_DWORD dwIndex = 0; dwIndex < NUM_STAT_COUNTERS; dwIndex++ )
+		Counters[ dwIndex ].store( 0, memory_order_relaxed );
+	pLatencies = new atomic< VFS_QWORD >[ NUM_LATENCY_SLOTS ];
+	for( VFS_DWORD dwSlot = 0; dwSlot < NUM_LATENCY_SLOTS; dwSlot++ )
+		pLatencies[ dwSlot ].store( 0, memory_order_relaxed );
+
+	StatRegistry& Registry = GetRegistry();
+	lock_guard< mutex > Lock( Registry.Mutex );
+	Registry.Blocks.push_back( this );
+}
+
+CThreadStats::~CThreadStats()
+{
+	{
+		StatRegistry& Registry = GetRegistry();
+		lock_guard< mutex > Lock( Registry.Mutex );
+
+		// Keep the Counters of this Thread.
+		for( VFS_DWORD dwSlot = 0; dwSlot < NUM_STAT_SLOTS; dwSlot++ )
+			Registry.Retired[ dwSlot ] += GetSlot( this, dwSlot );
+
+		Registry.Blocks.erase( find( Registry.Blocks.begin(), Registry.Blocks.end(), this ) );
+	}
+
+	delete [] pLatencies;
+}
@@ -15,6 +15,7 @@
 //    IMPLEMENTATION HEADERS
 //============================================================================
 #include "VFS_Implementation.h"
+#include <cerrno>
 
 //============================================================================
 //    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
@@ -31,6 +32,9 @@
 //============================================================================
 //    IMPLEMENTATION PRIVATE DATA
 //============================================================================
+// The Size of the user-space Buffer of newly opened Files.
+static VFS_DWORD g_dwBufferSize = 64 * 1024;
+
 //============================================================================
 //    INTERFACE DATA
 //============================================================================
@@ -43,55 +47,152 @@
 //============================================================================
 //    INTERFACE FUNCTIONS
 //============================================================================
+// Set / Get the Size of the user-space Buffer of newly opened Files (0 disables Buffering).
+VFS_BOOL VFS_File_SetBufferSize( VFS_DWORD dwBufferSize )
+{
+	g_dwBufferSize = dwBufferSize;
+	return VFS_TRUE;
+}
+
+VFS_DWORD VFS_File_GetBufferSize()
+{
+	return g_dwBufferSize;
+}
+
 //============================================================================
 //    INTERFACE CLASS BODIES
 //============================================================================
 // --- StdIO File Class ---
 
 // Constructor / Destructor.
-CStdIOFile::CStdIOFile( const VFS_String& strAbsoluteFileName, VFS_BOOL bOpen )
-: IFile( strAbsoluteFileName )
+CStdIOFile::CStdIOFile( const VFS_String& strAbsoluteFileName, VFS_BOOL bOpen, VFS_DWORD dwFlags )
+: IFile( strAbsoluteFileName ), m_strPath( strAbsoluteFileName )
 {
-	m_bReadOnly = VFS_FALSE;
+	// Open the File with the minimal Access Rights only.
+	m_bReadOnly = bOpen && ( dwFlags & VFS_WRITE ) != VFS_WRITE;
+	m_lPosition = 0;
+	m_lSize = 0;
+	m_dwBufferSize = g_dwBufferSize;
+	m_lBufferOffset = 0;
+	m_dwBufferFill = 0;
+	m_bBufferDirty = VFS_FALSE;
 
 	// Create?
+	AddStat( STAT_SYSCALLS );
 	if( !bOpen )
-		m_pFile = VFS_FOPEN( strAbsoluteFileName, VFS_String( VFS_TEXT( "w+b" ) ) );
+		m_nFile = VFS_OPEN( strAbsoluteFileName, VFS_OPEN_CREATE );
+	else if( !m_bReadOnly )
+		m_nFile = VFS_OPEN( strAbsoluteFileName, VFS_OPEN_READ_WRITE );
 	else
 	{
-		// Try to open for r/w access.
-		m_pFile = VFS_FOPEN( strAbsoluteFileName, VFS_String( VFS_TEXT( "r+b" ) ) );
+		m_nFile = VFS_OPEN( strAbsoluteFileName, VFS_OPEN_READ | VFS_OPEN_NOATIME );
 
-		// If this fails, try to open for read-only access.
-		if( m_pFile == NULL )
+		// We may only suppress the Access Time Update on our own Files (other Errors are reported right away).
+		if( m_nFile == VFS_INVALID_FD && VFS_OPEN_NOATIME != 0 && errno == EPERM )
 		{
-			m_pFile = VFS_FOPEN( strAbsoluteFileName, VFS_String( VFS_TEXT( "rb" ) ) );
-			m_bReadOnly = VFS_TRUE;
+			AddStat( STAT_SYSCALLS );
+			m_nFile = VFS_OPEN( strAbsoluteFileName, VFS_OPEN_READ );
 		}
 	}
 
 	// Error occured?
-	if( !m_pFile )
-		SetLastError( VFS_ERROR_NOT_FOUND );
+	if( m_nFile == VFS_INVALID_FD )
+	{
+		SetLastError( errno == EACCES ? VFS_ERROR_PERMISSION_DENIED : VFS_ERROR_NOT_FOUND );
+		return;
+	}
+
+	// Cache the Size.
+	if( bOpen )
+	{
+		AddStat( STAT_SYSCALLS );
+		m_lSize = ( VFS_LONG )VFS_GETSIZE( m_nFile );
+		if( m_lSize < 0 )
+			m_lSize = 0;
+	}
 }
 
 CStdIOFile::~CStdIOFile()
 {
-	if( m_pFile )
-		fclose( m_pFile );
+	if( m_nFile != VFS_INVALID_FD )
+	{
+		FlushBuffer();
+		AddStat( STAT_SYSCALLS );
+		VFS_CLOSE( m_nFile );
+	}
 }
 
 // Is the File valid?
 VFS_BOOL CStdIOFile::IsValid() const
 {
-	return m_pFile != NULL;
+	return m_nFile != VFS_INVALID_FD;
+}
+
+// Raw positional Access.
+VFS_BOOL CStdIOFile::ReadAt( VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_LONG lOffset, VFS_DWORD* pRead )
+{
+	VFS_DWORD dwRead = 0;
+	while( dwRead < dwToRead )
+	{
+		AddStat( STAT_SYSCALLS );
+		long lResult = ( long )VFS_PREAD( m_nFile, pBuffer + dwRead, dwToRead - dwRead, lOffset + dwRead );
+		if( lResult < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			SetLastError( VFS_ERROR_GENERIC );
+			return VFS_FALSE;
+		}
+
+		// End of File?
+		if( lResult == 0 )
+			break;
+		dwRead += ( VFS_DWORD )lResult;
+	}
+	AddStat( STAT_BYTES_READ, dwRead );
+
+	*pRead = dwRead;
+	return VFS_TRUE;
+}
+
+VFS_BOOL CStdIOFile::WriteAt( const VFS_BYTE* pBuffer, VFS_DWORD dwToWrite, VFS_LONG lOffset )
+{
+	VFS_DWORD dwWritten = 0;
+	while( dwWritten < dwToWrite )
+	{
+		AddStat( STAT_SYSCALLS );
+		long lResult = ( long )VFS_PWRITE( m_nFile, pBuffer + dwWritten, dwToWrite - dwWritten, lOffset + dwWritten );
+		if( lResult < 0 )
+		{
+			if( errno == EINTR )
+				continue;
+			SetLastError( VFS_ERROR_GENERIC );
+			return VFS_FALSE;
+		}
+		dwWritten += ( VFS_DWORD )lResult;
+	}
+	AddStat( STAT_BYTES_WRITTEN, dwWritten );
+
+	return VFS_TRUE;
+}
+
+// Write the Buffer if it's dirty and drop it.
+VFS_BOOL CStdIOFile::FlushBuffer()
+{
+	VFS_BOOL bResult = VFS_TRUE;
+	if( m_bBufferDirty )
+		bResult = WriteAt( &*m_Buffer.begin(), m_dwBufferFill, m_lBufferOffset );
+
+	m_dwBufferFill = 0;
+	m_bBufferDirty = VFS_FALSE;
+	return bResult;
 }
 
 // Read / Write.
 VFS_BOOL CStdIOFile::Read( VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_DWORD* pRead )
 {
 	// Invalid File?
-	if( m_pFile == NULL )
+	if( m_nFile == VFS_INVALID_FD )
 	{
 		SetLastError( VFS_ERROR_GENERIC );
 		return VFS_FALSE;
@@ -104,16 +205,52 @@ VFS_BOOL CStdIOFile::Read( VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_DWORD* pRe
 		return VFS_FALSE;
 	}
 
-	// Read.
-	size_t szRead;
-	if( dwToRead > 0 )
-		szRead = fread( pBuffer, sizeof( VFS_BYTE ), dwToRead, m_pFile );
-	else
-		szRead = 0;
+	// Write pending Data first.
+	if( m_bBufferDirty && !FlushBuffer() )
+		return VFS_FALSE;
+
+	// Take as much as possible from the Buffer.
+	VFS_DWORD dwRead = 0;
+	if( m_lPosition >= m_lBufferOffset && m_lPosition < m_lBufferOffset + ( VFS_LONG )m_dwBufferFill )
+	{
+		dwRead = ( VFS_DWORD )( m_lBufferOffset + m_dwBufferFill - m_lPosition );
+		if( dwRead > dwToRead )
+			dwRead = dwToRead;
+		memcpy( pBuffer, &m_Buffer[ m_lPosition - m_lBufferOffset ], dwRead );
+	}
+
+	// Read the Rest.
+	if( dwRead < dwToRead )
+	{
+		VFS_DWORD dwRemaining = dwToRead - dwRead;
+		VFS_DWORD dwReadNow;
+
+		// Big Reads go directly into the Caller's Buffer, small ones refill our Buffer.
+		if( dwRemaining >= m_dwBufferSize )
+		{
+			if( !ReadAt( pBuffer + dwRead, dwRemaining, m_lPosition + dwRead, &dwReadNow ) )
+				return VFS_FALSE;
+		}
+		else
+		{
+			if( m_Buffer.size() < m_dwBufferSize )
+				m_Buffer.resize( m_dwBufferSize );
+
+			m_lBufferOffset = m_lPosition + dwRead;
+			m_dwBufferFill = 0;
+			if( !ReadAt( &*m_Buffer.begin(), m_dwBufferSize, m_lBufferOffset, &m_dwBufferFill ) )
+				return VFS_FALSE;
+
+			dwReadNow = dwRemaining < m_dwBufferFill ? dwRemaining : m_dwBufferFill;
+			memcpy( pBuffer + dwRead, &*m_Buffer.begin(), dwReadNow );
+		}
+		dwRead += dwReadNow;
+	}
+	m_lPosition += dwRead;
 
 	// Calculate the Amount of Data read.
 	if( pRead != NULL )
-		*pRead = ( VFS_DWORD )szRead;
+		*pRead = dwRead;
 
 	return VFS_TRUE;
 }
@@ -121,7 +258,7 @@ VFS_BOOL CStdIOFile::Read( VFS_BYTE* pBuffer, VFS_DWORD dwToRead, VFS_DWORD* pRe
 VFS_BOOL CStdIOFile::Write( const VFS_BYTE* pBuffer, VFS_DWORD dwToWrite, VFS_DWORD* pWritten )
 {
 	// Invalid File?
-	if( m_pFile == NULL )
+	if( m_nFile == VFS_INVALID_FD )
 	{
 		SetLastError( VFS_ERROR_GENERIC );
 		return VFS_FALSE;
@@ -141,85 +278,187 @@ VFS_BOOL CStdIOFile::Write( const VFS_BYTE* pBuffer, VFS_DWORD dwToWrite, VFS_DW
 		return VFS_FALSE;
 	}
 
-	// Read.
-	size_t szWritten;
 	if( dwToWrite > 0 )
-		szWritten = fwrite( pBuffer, 1, dwToWrite, m_pFile );
-	else
-		szWritten = 0;
+	{
+		// Drop Data read ahead and write pending Data if this Write doesn't simply append to it.
+		if( !m_bBufferDirty )
+			m_dwBufferFill = 0;
+		else if( m_lPosition != m_lBufferOffset + ( VFS_LONG )m_dwBufferFill || m_dwBufferFill + dwToWrite > m_dwBufferSize )
+		{
+			if( !FlushBuffer() )
+				return VFS_FALSE;
+		}
 
-	// Calculate the Amount of Data read.
+		// Big Writes go directly to the File, small ones are collected.
+		if( dwToWrite >= m_dwBufferSize )
+		{
+			if( !WriteAt( pBuffer, dwToWrite, m_lPosition ) )
+				return VFS_FALSE;
+		}
+		else
+		{
+			if( m_Buffer.size() < m_dwBufferSize )
+				m_Buffer.resize( m_dwBufferSize );
+
+			if( m_dwBufferFill == 0 )
+				m_lBufferOffset = m_lPosition;
+			memcpy( &m_Buffer[ m_dwBufferFill ], pBuffer, dwToWrite );
+			m_dwBufferFill += dwToWrite;
+			m_bBufferDirty = VFS_TRUE;
+		}
+
+		m_lPosition += dwToWrite;
+		if( m_lPosition > m_lSize )
+			m_lSize = m_lPosition;
+	}
+
+	// Calculate the Amount of Data written.
 	if( pWritten != NULL )
-		*pWritten = ( VFS_DWORD )szWritten;
+		*pWritten = dwToWrite;
 
 	return VFS_TRUE;
 }
 
-// Seek / Tell.
+// Seek / Tell (the Position is kept by ourself, so these don't need any Syscall).
 VFS_BOOL CStdIOFile::Seek( VFS_LONG lPosition, VFS_SeekOrigin eOrigin )
 {
 	// Invalid File?
-	if( m_pFile == NULL )
+	if( m_nFile == VFS_INVALID_FD )
 	{
 		SetLastError( VFS_ERROR_GENERIC );
 		return VFS_FALSE;
 	}
 
-	return fseek( m_pFile, lPosition, eOrigin == VFS_SET ? SEEK_SET : ( eOrigin == VFS_CURRENT ? SEEK_CUR : SEEK_END ) ) == 0;
+	VFS_LONG lNewPosition = lPosition + ( eOrigin == VFS_SET ? 0 : ( eOrigin == VFS_CURRENT ? m_lPosition : m_lSize ) );
+	if( lNewPosition < 0 )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	m_lPosition = lNewPosition;
+	return VFS_TRUE;
 }
 
 VFS_LONG CStdIOFile::Tell() const
 {
 	// Invalid File?
-	if( m_pFile == NULL )
+	if( m_nFile == VFS_INVALID_FD )
 	{
 		SetLastError( VFS_ERROR_GENERIC );
 		return VFS_INVALID_LONG_VALUE;
 	}
 
-	return ftell( m_pFile );
+	return m_lPosition;
 }
 
 // Sizing.
 VFS_BOOL CStdIOFile::Resize( VFS_LONG lSize )
 {
-	return 0;//
+	// Invalid File?
+	if( m_nFile == VFS_INVALID_FD )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	// Invalid Size?
+	if( lSize < 0 )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	// Read-only?
+	if( m_bReadOnly )
+	{
+		SetLastError( VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	// The Buffer might contain Data behind the new End of the File.
+	if( !FlushBuffer() )
+		return VFS_FALSE;
+
+	AddStat( STAT_SYSCALLS );
+	if( !VFS_RESIZE( m_nFile, lSize ) )
+	{
+		SetLastError( errno == EACCES || errno == EPERM ? VFS_ERROR_PERMISSION_DENIED : VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	m_lSize = lSize;
+	return VFS_TRUE;
+}
+
+VFS_BOOL CStdIOFile::Preallocate( VFS_LONG lSize )
+{
+	// Invalid File?
+	if( m_nFile == VFS_INVALID_FD )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	// Invalid Size?
+	if( lSize < 0 )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	// Read-only?
+	if( m_bReadOnly )
+	{
+		SetLastError( VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	// Nothing to do?
+	if( lSize <= m_lSize )
+		return VFS_TRUE;
+
+	AddStat( STAT_SYSCALLS );
+	if( !VFS_PREALLOCATE( m_nFile, lSize ) )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
 }
 
 VFS_LONG CStdIOFile::GetSize() const
 {
-	return VFS_GETSIZE( m_pFile );
+	// Invalid File?
+	if( m_nFile == VFS_INVALID_FD )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_INVALID_LONG_VALUE;
+	}
+
+	return m_lSize;
 }
 
 // Open / Create a StdIOFile.
 IFile* CStdIOFile::Open( const VFS_String& strAbsoluteFileName, VFS_DWORD dwFlags )
 {
-	// Try to open the File.
-	CStdIOFile* pFile = new CStdIOFile( strAbsoluteFileName, VFS_TRUE );
-
-	// File not found?
+	// Try to open the File (the Constructor sets the Error).
+	CStdIOFile* pFile = new CStdIOFile( strAbsoluteFileName, VFS_TRUE, dwFlags );
 	if( !pFile->IsValid() )
 	{
 		delete pFile;
-		SetLastError( VFS_ERROR_NOT_FOUND );
-		return NULL;
-	}
-
-	// Read-only but write permission needed?
-	if( pFile->m_bReadOnly && ( dwFlags & VFS_WRITE ) == VFS_WRITE )
-	{
-		delete pFile;
-		SetLastError( VFS_ERROR_PERMISSION_DENIED );
 		return NULL;
 	}
 
+	AddStat( STAT_STDIO_FILE_OPENS );
 	return pFile;
 }
 
 IFile* CStdIOFile::Create( const VFS_String& strAbsoluteFileName, VFS_DWORD dwFlags )
 {
-	// Try to open the File.
-	CStdIOFile* pFile = new CStdIOFile( strAbsoluteFileName, VFS_FALSE );
+	// Try to create the File (always for r/w Access).
+	CStdIOFile* pFile = new CStdIOFile( strAbsoluteFileName, VFS_FALSE, dwFlags );
 
 	// File couldn't be created?
 	if( !pFile->IsValid() )
@@ -228,20 +467,286 @@ IFile* CStdIOFile::Create( const VFS_String& strAbsoluteFileName, VFS_DWORD dwFl
 		return NULL;
 	}
 
-	// Read-only but write permission needed?
-	// Usually, you'll have write permission whenever you create a File, so
-	// probably we'd omit this one!?!
-	if( pFile->m_bReadOnly && ( dwFlags & VFS_WRITE ) == VFS_WRITE )
+	AddStat( STAT_STDIO_FILE_OPENS );
+	return pFile;
+}
+
+VFS_BOOL CStdIOFile::Exists( const VFS_String& strAbsoluteFileName )
+{
+	AddStat( STAT_SYSCALLS );
+	return VFS_EXISTS( strAbsoluteFileName );
+}
+
+// Copy / Move a File by its Path (a partial Target is removed again).
+VFS_BOOL CStdIOFile::Copy( const VFS_String& strAbsoluteFrom, const VFS_String& strAbsoluteTo )
+{
+	// Open the Files.
+	IFile* pIn = Open( strAbsoluteFrom, VFS_READ );
+	if( pIn == NULL )
+		return VFS_FALSE;
+
+	IFile* pOut = Create( strAbsoluteTo, VFS_WRITE );
+	if( pOut == NULL )
 	{
-		delete pFile;
+		delete pIn;
+		return VFS_FALSE;
+	}
+
+	// Copy the Data and close the Files.
+	VFS_BOOL bResult = static_cast< CStdIOFile* >( pIn )->CopyTo( static_cast< CStdIOFile* >( pOut ) );
+	delete pOut;
+	delete pIn;
+
+	if( !bResult )
+	{
+		AddStat( STAT_SYSCALLS );
+		( void )VFS_UNLINK( strAbsoluteTo );
+	}
+
+	return bResult;
+}
+
+VFS_BOOL CStdIOFile::Move( const VFS_String& strAbsoluteFrom, const VFS_String& strAbsoluteTo )
+{
+	// Try to rename the File.
+	AddStat( STAT_SYSCALLS );
+	if( VFS_RENAME( strAbsoluteFrom, strAbsoluteTo ) )
+		return VFS_TRUE;
+
+	// Other Device? Then copy the File and delete the Source File.
+	if( errno != EXDEV )
+	{
+		SetLastError( errno == ENOENT ? VFS_ERROR_NOT_FOUND : VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	if( !Copy( strAbsoluteFrom, strAbsoluteTo ) )
+		return VFS_FALSE;
+
+	AddStat( STAT_SYSCALLS );
+	if( !VFS_UNLINK( strAbsoluteFrom ) )
+	{
+		// Don't leave two Copies behind.
+		AddStat( STAT_SYSCALLS );
+		( void )VFS_UNLINK( strAbsoluteTo );
+
 		SetLastError( VFS_ERROR_PERMISSION_DENIED );
-		return NULL;
+		return VFS_FALSE;
 	}
 
-	return pFile;
+	return VFS_TRUE;
 }
 
-VFS_BOOL CStdIOFile::Exists( const VFS_String& strAbsoluteFileName )
+// Reopen a File which was opened for reading only for r/w Access.
+VFS_BOOL CStdIOFile::MakeWritable()
 {
-	return VFS_EXISTS( strAbsoluteFileName );
+	if( !m_bReadOnly )
+		return VFS_TRUE;
+
+	AddStat( STAT_SYSCALLS );
+	int nFile = VFS_OPEN( m_strPath, VFS_OPEN_READ_WRITE );
+	if( nFile == VFS_INVALID_FD )
+	{
+		SetLastError( VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	// Replace the read-only Descriptor (the Buffer stays valid, since the Position is kept by ourself).
+	AddStat( STAT_SYSCALLS );
+	VFS_CLOSE( m_nFile );
+	m_nFile = nFile;
+	m_bReadOnly = VFS_FALSE;
+
+	return VFS_TRUE;
+}
+
+// Copy a Range of this File into another one (the Positions of both Files aren't changed).
+VFS_BOOL CStdIOFile::CopyRange( CStdIOFile* pTarget, VFS_LONG lOffset, VFS_LONG lSize, VFS_LONG lTargetOffset )
+{
+	// Invalid Files?
+	if( m_nFile == VFS_INVALID_FD || pTarget == NULL || pTarget->m_nFile == VFS_INVALID_FD )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	// Read-only?
+	if( pTarget->m_bReadOnly )
+	{
+		SetLastError( VFS_ERROR_PERMISSION_DENIED );
+		return VFS_FALSE;
+	}
+
+	// The Kernel only sees the Data which was written already.
+	if( !FlushBuffer() || !pTarget->FlushBuffer() )
+		return VFS_FALSE;
+
+	// First try copy_file_range() (might even share the Blocks), ...
+	VFS_LONG lCopied = 0;
+	VFS_BOOL bKernel = VFS_TRUE;
+	while( lCopied < lSize )
+	{
+		VFS_FileOffset lFrom = lOffset + lCopied;
+		VFS_FileOffset lTo = lTargetOffset + lCopied;
+		VFS_LONG lChunk = min< VFS_LONG >( lSize - lCopied, FILE_COPY_KERNEL_CHUNK_SIZE );
+
+		AddStat( STAT_SYSCALLS );
+		long lResult = ( long )VFS_COPY_FILE_RANGE( m_nFile, &lFrom, pTarget->m_nFile, &lTo, ( size_t )lChunk );
+		if( lResult < 0 && errno == EINTR )
+			continue;
+		if( lResult <= 0 )
+		{
+			bKernel = lResult == 0 || ( errno != EXDEV && errno != ENOSYS && errno != EOPNOTSUPP && errno != EINVAL );
+			break;
+		}
+		lCopied += lResult;
+	}
+
+	// ... then sendfile(), ...
+	if( !bKernel )
+	{
+		bKernel = VFS_TRUE;
+		AddStat( STAT_SYSCALLS );
+		if( VFS_SEEK( pTarget->m_nFile, lTargetOffset + lCopied ) < 0 )
+			bKernel = VFS_FALSE;
+		while( bKernel && lCopied < lSize )
+		{
+			VFS_FileOffset lFrom = lOffset + lCopied;
+			VFS_LONG lChunk = min< VFS_LONG >( lSize - lCopied, FILE_COPY_KERNEL_CHUNK_SIZE );
+
+			AddStat( STAT_SYSCALLS );
+			long lResult = ( long )VFS_SENDFILE( m_nFile, &lFrom, pTarget->m_nFile, ( size_t )lChunk );
+			if( lResult < 0 && errno == EINTR )
+				continue;
+			if( lResult <= 0 )
+			{
+				bKernel = lResult == 0 || ( errno != ENOSYS && errno != EINVAL );
+				break;
+			}
+			lCopied += lResult;
+		}
+	}
+
+	// ... and if the Kernel can't do it, use a (temporary) Buffer (the Kernel stopped before the End, so there's Data left).
+	if( !bKernel )
+	{
+		vector< VFS_BYTE > Buffer( ( VFS_DWORD )min< VFS_LONG >( lSize - lCopied, FILE_COPY_BUFFER_SIZE ) );
+		while( lCopied < lSize )
+		{
+			VFS_DWORD dwChunk = lSize - lCopied < ( VFS_LONG )Buffer.size() ? ( VFS_DWORD )( lSize - lCopied ) : ( VFS_DWORD )Buffer.size();
+			VFS_DWORD dwRead;
+			if( !ReadAt( &*Buffer.begin(), dwChunk, lOffset + lCopied, &dwRead ) )
+				return VFS_FALSE;
+			if( dwRead == 0 )
+				break;
+			if( !pTarget->WriteAt( &*Buffer.begin(), dwRead, lTargetOffset + lCopied ) )
+				return VFS_FALSE;
+			lCopied += dwRead;
+		}
+	}
+	else
+	{
+		AddStat( STAT_BYTES_READ, lCopied );
+		AddStat( STAT_BYTES_WRITTEN, lCopied );
+	}
+
+	if( lTargetOffset + lCopied > pTarget->m_lSize )
+		pTarget->m_lSize = lTargetOffset + lCopied;
+
+	// The Source was shorter than expected?
+	if( lCopied < lSize )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	return VFS_TRUE;
+}
+
+// Copy the whole File (only the Data Regions are copied, so Holes stay Holes).
+VFS_BOOL CStdIOFile::CopyTo( CStdIOFile* pTarget )
+{
+	// Invalid Files?
+	if( m_nFile == VFS_INVALID_FD || pTarget == NULL || pTarget->m_nFile == VFS_INVALID_FD )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	// The Kernel only sees the Data which was written already.
+	if( !FlushBuffer() )
+		return VFS_FALSE;
+
+	VFS_LONG lOffset = 0;
+	while( lOffset < m_lSize )
+	{
+		// Find the next Data Region (no more Data means the Rest is a Hole).
+		AddStat( STAT_SYSCALLS );
+		VFS_LONG lData = ( VFS_LONG )VFS_SEEK_DATA( m_nFile, lOffset );
+		if( lData < 0 && errno == ENXIO )
+			break;
+		if( lData < 0 )
+			lData = lOffset;
+		if( lData >= m_lSize )
+			break;
+
+		AddStat( STAT_SYSCALLS );
+		VFS_LONG lHole = ( VFS_LONG )VFS_SEEK_HOLE( m_nFile, lData );
+		if( lHole < 0 || lHole > m_lSize )
+			lHole = m_lSize;
+
+		if( !CopyRange( pTarget, lData, lHole - lData, lData ) )
+			return VFS_FALSE;
+		lOffset = lHole;
+	}
+
+	// Trailing Holes.
+	if( pTarget->m_lSize != m_lSize )
+		return pTarget->Resize( m_lSize );
+
+	return VFS_TRUE;
+}
+
+// Have a Range read ahead (the Range is clipped to the File).
+VFS_BOOL CStdIOFile::Prefetch( VFS_LONG lOffset, VFS_LONG lSize )
+{
+	// Invalid File?
+	if( m_nFile == VFS_INVALID_FD )
+	{
+		SetLastError( VFS_ERROR_GENERIC );
+		return VFS_FALSE;
+	}
+
+	// Invalid Range?
+	if( lOffset < 0 || lSize < 0 )
+	{
+		SetLastError( VFS_ERROR_INVALID_PARAMETER );
+		return VFS_FALSE;
+	}
+
+	if( lOffset >= m_lSize )
+		return VFS_TRUE;
+	if( lSize > m_lSize - lOffset )
+		lSize = m_lSize - lOffset;
+
+	// Let the Kernel read the Range in the Background if it can, ...
+	AddStat( STAT_BYTES_PREFETCHED, lSize );
+	AddStat( STAT_SYSCALLS );
+	if( VFS_PREFETCH( m_nFile, lOffset, lSize ) )
+		return VFS_TRUE;
+
+	// ... otherwise read it ourselves (which fills the Cache of the Operating System as well).
+	vector< VFS_BYTE > Buffer( ( VFS_DWORD )min< VFS_LONG >( lSize, FILE_COPY_BUFFER_SIZE ) );
+	while( lSize > 0 )
+	{
+		VFS_DWORD dwRead;
+		if( !ReadAt( &*Buffer.begin(), ( VFS_DWORD )min< VFS_LONG >( lSize, Buffer.size() ), lOffset, &dwRead ) )
+			return VFS_FALSE;
+		if( dwRead == 0 )
+			break;
+		lOffset += dwRead;
+		lSize -= dwRead;
+	}
+
+	return VFS_TRUE;
 }
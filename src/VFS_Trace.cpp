@@ -0,0 +1,335 @@
+//****************************************************************************
+//**
+//**    VFS_TRACE.CPP
+//**    Access Trace Recording and Prefetching
+//**
+//**	Project:	VFS
+//**	Component:	Trace
+//**
+//**	History:
+//**		19.10.2026		Created
+//****************************************************************************
+
+//============================================================================
+//    IMPLEMENTATION HEADERS
+//============================================================================
+#include "VFS_Implementation.h"
+#include <thread>
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
+//============================================================================
+//============================================================================
+//    IMPLEMENTATION PRIVATE CLASS PROTOTYPES / EXTERNAL CLASS REFERENCES
+//============================================================================
+//============================================================================
+//    IMPLEMENTATION PRIVATE STRUCTURES / UTILITY CLASSES
+//============================================================================
+// A Range of a Standard File to prefetch (Archived Files are prefetched as the Range of their Data in the Archive File).
+struct PrefetchRange {
+	VFS_String strFileName;
+	VFS_LONG lOffset;
+	VFS_LONG lSize;
+};
+typedef vector< PrefetchRange > PrefetchRangeList;
+
+//============================================================================
+//    IMPLEMENTATION REQUIRED EXTERNAL REFERENCES (AVOID)
+//============================================================================
+//============================================================================
+//    IMPLEMENTATION PRIVATE DATA
+//============================================================================
+// The recorded Trace (the Map tells which Files are in it already).
+static VFS_BOOL g_bRecording = VFS_FALSE;
+static VFS_FileNameList g_Trace;
+static CHashMap< VFS_BYTE > g_TracedFiles;
+
+// The Prefetch Thread (it stops as soon as possible once the Flag is set).
+static thread g_PrefetchThread;
+static atomic< bool > g_bStopPrefetching( false );
+
+//============================================================================
+//    INTERFACE DATA
+//============================================================================
+//============================================================================
+//    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
+//============================================================================
+static VFS_BOOL GetPrefetchRange( const VFS_String& strAbsoluteFileName, PrefetchRange& Range );
+static void PrefetchThread( PrefetchRangeList Ranges );
+static void StopPrefetching();
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE FUNCTIONS
+//============================================================================
+// Get the Range to prefetch for a File (looking the File up in its Archive if it's archived).
+static VFS_BOOL GetPrefetchRange( const VFS_String& strAbsoluteFileName, PrefetchRange& Range )
+{
+	// A Standard File?
+	if( CStdIOFile::Exists( strAbsoluteFileName ) )
+	{
+		Range.strFileName = strAbsoluteFileName;
+		Range.lOffset = 0;
+		Range.lSize = VFS_INVALID_LONG_VALUE;
+		return VFS_TRUE;
+	}
+
+	// An archived File?
+	CArchive* pArchive;
+	VFS_String strFileName;
+	if( !CArchiveFile::Exists( strAbsoluteFileName, &pArchive, &strFileName ) )
+		return VFS_FALSE;
+
+	const ArchiveFile* pFile = pArchive->GetFile( strFileName );
+	if( pFile == NULL )
+		return VFS_FALSE;
+
+	// Inline Files are in Memory already, Members of Solid Blocks are prefetched as their Block (by the Path the Archive File was
+	// opened with; an Archive inside another Archive isn't a Standard File, so it's left out).
+	IFile* pArchiveFile = ( IFile* )( VFS_DWORD )pArchive->GetFile();
+	if( pFile->dwBlockIndex == BLOCK_INDEX_INLINE || pArchiveFile->IsArchived() )
+		return VFS_FALSE;
+	Range.strFileName = static_cast< CStdIOFile* >( pArchiveFile )->GetPath();
+	if( pFile->dwBlockIndex != BLOCK_INDEX_NONE )
+	{
+		const ArchiveBlock& Block = pArchive->GetHeader()->Blocks[ pFile->dwBlockIndex ];
+		Range.lOffset = Block.dwDataOffset;
+		Range.lSize = Block.dwCompressedSize;
+	}
+	else
+	{
+		Range.lOffset = pFile->dwDataOffset;
+		Range.lSize = pFile->dwCompressedSize;
+	}
+	return VFS_TRUE;
+}
+
+// Prefetch the Ranges in their Order (each File is opened once for a Run of Ranges in it).
+static void PrefetchThread( PrefetchRangeList Ranges )
+{
+	CStdIOFile* pFile = NULL;
+	for( PrefetchRangeList::iterator iter = Ranges.begin(); iter != Ranges.end() && !g_bStopPrefetching.load( memory_order_relaxed ); iter++ )
+	{
+		if( pFile == NULL || pFile->GetPath() != ( *iter ).strFileName )
+		{
+			if( pFile != NULL )
+				pFile->Release();
+			pFile = static_cast< CStdIOFile* >( CStdIOFile::Open( ( *iter ).strFileName, VFS_READ ) );
+			if( pFile == NULL )
+				continue;
+		}
+
+		// Errors don't matter, the File will just be read on Demand.
+		pFile->Prefetch( ( *iter ).lOffset, ( *iter ).lSize == VFS_INVALID_LONG_VALUE ? pFile->GetSize() : ( *iter ).lSize );
+	}
+
+	if( pFile != NULL )
+		pFile->Release();
+}
+
+// Stop the Prefetch Thread (if it's running).
+static void StopPrefetching()
+{
+	if( !g_PrefetchThread.joinable() )
+		return;
+
+	g_bStopPrefetching.store( true, memory_order_relaxed );
+	g_PrefetchThread.join();
+	g_bStopPrefetching.store( false, memory_order_relaxed );
+}
+
+//============================================================================
+//    INTERFACE FUNCTIONS
+//============================================================================
+// Start Recording (the Trace is cleared).
+VFS_BOOL VFS_Trace_Start()
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	g_Trace.clear();
+	g_TracedFiles.clear();
+	g_bRecording = VFS_TRUE;
+
+	return VFS_TRUE;
+}
+
+// Stop Recording (the Trace is kept).
+VFS_BOOL VFS_Trace_Stop()
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	g_bRecording = VFS_FALSE;
+
+	return VFS_TRUE;
+}
+
+VFS_BOOL VFS_Trace_IsRecording()
+{
+	return g_bRecording;
+}
+
+// Get the recorded Trace.
+VFS_BOOL VFS_Trace_GetFiles( VFS_FileNameList& Files )
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	Files = g_Trace;
+
+	return VFS_TRUE;
+}
+
+// Save the recorded Trace (one File Name per Line).
+VFS_BOOL VFS_Trace_Save( const VFS_String& strTraceFileName )
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	VFS_String strTrace;
+	for( VFS_FileNameList::const_iterator iter = g_Trace.begin(); iter != g_Trace.end(); iter++ )
+	{
+		strTrace += *iter;
+		strTrace += VFS_TEXT( '\n' );
+	}
+
+	return VFS_File_WriteEntireFile( strTraceFileName, ( const VFS_BYTE* ) strTrace.data(), ( VFS_DWORD )( strTrace.size() * sizeof( VFS_CHAR ) ) );
+}
+
+// Load a Trace (empty Lines are skipped).
+VFS_BOOL VFS_Trace_Load( const VFS_String& strTraceFileName, VFS_FileNameList& Files )
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	VFS_EntityInfo Info;
+	if( !VFS_File_GetInfo( strTraceFileName, Info ) )
+		return VFS_FALSE;
+
+	VFS_String strTrace( Info.lSize / sizeof( VFS_CHAR ), VFS_TEXT( '\0' ) );
+	VFS_DWORD dwRead = 0;
+	if( !strTrace.empty() && !VFS_File_ReadEntireFile( strTraceFileName, ( VFS_BYTE* ) &*strTrace.begin(), ( VFS_DWORD )( strTrace.size() * sizeof( VFS_CHAR ) ), &dwRead ) )
+		return VFS_FALSE;
+	strTrace.resize( dwRead / sizeof( VFS_CHAR ) );
+
+	Files.clear();
+	VFS_String::size_type nStart = 0;
+	while( nStart < strTrace.size() )
+	{
+		VFS_String::size_type nEnd = strTrace.find( VFS_TEXT( '\n' ), nStart );
+		if( nEnd == VFS_String::npos )
+			nEnd = strTrace.size();
+		if( nEnd > nStart )
+			Files.push_back( strTrace.substr( nStart, nEnd - nStart ) );
+		nStart = nEnd + 1;
+	}
+
+	return VFS_TRUE;
+}
+
+// Prefetch the Files of a Trace. The Files are looked up here (Archives are opened on this Thread, the Archive Maps aren't
+// thread-safe), so the Prefetch Thread only reads Ranges of Standard Files; adjacent Ranges are merged.
+VFS_BOOL VFS_Trace_Prefetch( const VFS_FileNameList& Files )
+{
+	// Not initialized yet?
+	if( !IsInit() )
+	{
+		SetLastError( VFS_ERROR_NOT_INITIALIZED_YET );
+		return VFS_FALSE;
+	}
+
+	StopPrefetching();
+
+	PrefetchRangeList Ranges;
+	for( VFS_FileNameList::const_iterator iter = Files.begin(); iter != Files.end(); iter++ )
+	{
+		// Relative Names are looked up in the Root Paths.
+		PrefetchRange Range;
+		VFS_BOOL bFound = VFS_FALSE;
+		if( VFS_Util_IsAbsoluteFileName( *iter ) )
+			bFound = GetPrefetchRange( *iter, Range );
+		else
+		{
+			for( VFS_RootPathList::iterator root = GetRootPaths().begin(); root != GetRootPaths().end() && !bFound; root++ )
+				bFound = GetPrefetchRange( VFS_Path( *root, *iter ).Get(), Range );
+		}
+		if( !bFound )
+			continue;
+
+		// Members of the same Solid Block share their Range.
+		if( !Ranges.empty() && Ranges.back().strFileName == Range.strFileName && Ranges.back().lOffset == Range.lOffset && Ranges.back().lSize == Range.lSize )
+			continue;
+
+		if( !Ranges.empty() && Ranges.back().strFileName == Range.strFileName && Ranges.back().lSize != VFS_INVALID_LONG_VALUE &&
+			Range.lSize != VFS_INVALID_LONG_VALUE && Ranges.back().lOffset + Ranges.back().lSize == Range.lOffset )
+			Ranges.back().lSize += Range.lSize;
+		else
+			Ranges.push_back( Range );
+	}
+
+	// The Lookups shouldn't leave an Error behind.
+	SetLastError( VFS_ERROR_NONE );
+
+	if( !Ranges.empty() )
+		g_PrefetchThread = thread( PrefetchThread, move( Ranges ) );
+
+	return VFS_TRUE;
+}
+
+// Wait until the Prefetching is done.
+VFS_BOOL VFS_Trace_WaitForPrefetch()
+{
+	if( g_PrefetchThread.joinable() )
+		g_PrefetchThread.join();
+
+	return VFS_TRUE;
+}
+
+// Add an opened File to the Trace (only its first Open counts, the Names are compared ignoring the Case; Archive Files are opened by
+// the Archives themselves, so they are left out).
+void RecordAccess( const VFS_String& strAbsoluteFileName )
+{
+	if( !g_bRecording )
+		return;
+
+	VFS_String strExtension;
+	if( VFS_Util_GetExtension( strAbsoluteFileName, strExtension ) && EqualsNoCase( strExtension, VFS_ARCHIVE_FILE_EXTENSION ) )
+		return;
+
+	if( g_TracedFiles.insert( CHashMap< VFS_BYTE >::value_type( strAbsoluteFileName, VFS_TRUE ) ).second )
+		g_Trace.push_back( strAbsoluteFileName );
+}
+
+// Stop Recording and Prefetching.
+void ShutdownTrace()
+{
+	StopPrefetching();
+
+	g_bRecording = VFS_FALSE;
+	g_Trace.clear();
+	g_TracedFiles.clear();
+}
+
+//============================================================================
+//    INTERFACE CLASS BODIES
+//============================================================================
@@ -37,14 +37,55 @@
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
 //============================================================================
+static VFS_BOOL IsRootView( VFS_StringView strFileName );
+static VFS_StringView WithoutTrailingSeparatorView( VFS_StringView strFileName );
+static VFS_StringView GetNameView( VFS_StringView strFileName );
+
 //============================================================================
 //    IMPLEMENTATION PRIVATE FUNCTIONS
 //============================================================================
+// Determines if the specified File Name represents a Root Directory ("/" or "<drive letter>:/").
+static VFS_BOOL IsRootView( VFS_StringView strFileName )
+{
+	if( strFileName.size() == 1 && strFileName[ 0 ] == VFS_PATH_SEPARATOR )
+		return VFS_TRUE;
+
+	return strFileName.size() == 3 && isalpha( strFileName[ 0 ] ) && strFileName[ 1 ] == VFS_TEXT( ':' ) && strFileName[ 2 ] == VFS_PATH_SEPARATOR;
+}
+
+// Removes a trailing Path Separator Char (unless the File Name is a Root Directory).
+static VFS_StringView WithoutTrailingSeparatorView( VFS_StringView strFileName )
+{
+	if( strFileName.size() == 0 || IsRootView( strFileName ) || strFileName[ strFileName.size() - 1 ] != VFS_PATH_SEPARATOR )
+		return strFileName;
+
+	return strFileName.substr( 0, strFileName.size() - 1 );
+}
+
+// Returns the Name for a File Name (a Root Directory is its own Name).
+static VFS_StringView GetNameView( VFS_StringView strFileName )
+{
+	if( IsRootView( strFileName ) )
+		return strFileName;
+
+	if( strFileName.size() > 0 && strFileName[ strFileName.size() - 1 ] == VFS_PATH_SEPARATOR )
+		strFileName = strFileName.substr( 0, strFileName.size() - 1 );
+
+	// Is there a trailing backslash?
+	if( strFileName.rfind( VFS_PATH_SEPARATOR ) != VFS_StringView::npos )
+	{
+		// Remove all the text from the beginning to the trailing backslash.
+		strFileName = strFileName.substr( strFileName.rfind( VFS_PATH_SEPARATOR ) + 1 );
+	}
+
+	return strFileName;
+}
+
 //============================================================================
 //    INTERFACE FUNCTIONS
 //============================================================================
 // Returns the Path for a File Name.
-VFS_BOOL VFS_Util_GetPath( const VFS_String& strFileName, VFS_String& strPath )
+VFS_BOOL VFS_Util_GetPath( VFS_StringView strFileName, VFS_String& strPath )
 {
 	// Following exceptions:
 	// Path of "/" is ""
@@ -55,13 +96,13 @@ VFS_BOOL VFS_Util_GetPath( const VFS_String& strFileName, VFS_String& strPath )
 		strPath = VFS_TEXT( "" );
 		return VFS_TRUE;
 	}
-	strPath = WithoutTrailingSeparator( strFileName, VFS_FALSE );
+	strFileName = WithoutTrailingSeparatorView( strFileName );
 
 	// Is there a trailing backslash?
-	if( strPath.rfind( VFS_PATH_SEPARATOR ) != VFS_String::npos )
+	if( strFileName.rfind( VFS_PATH_SEPARATOR ) != VFS_StringView::npos )
 	{
 		// Remove all the text starting from the trailing backslash.
-		strPath = strPath.substr( 0, strPath.rfind( VFS_PATH_SEPARATOR ) );
+		strPath.assign( strFileName.data(), strFileName.rfind( VFS_PATH_SEPARATOR ) );
 	}
 	else
 	{
@@ -72,70 +113,53 @@ VFS_BOOL VFS_Util_GetPath( const VFS_String& strFileName, VFS_String& strPath )
 }
 
 // Returns the Name for a File Name.
-VFS_BOOL VFS_Util_GetName( const VFS_String& strFileName, VFS_String& strName )
+VFS_BOOL VFS_Util_GetName( VFS_StringView strFileName, VFS_String& strName )
 {
-	// Following exceptions:
-	// Name of "/" is "/"
-	// Name of (char)":/" is (char)":/"
-	if( ( strFileName.size() == 1 && strFileName[ 0 ] == VFS_PATH_SEPARATOR ) ||
-		( strFileName.size() == 3 && strFileName[ 1 ] == VFS_TEXT( ':' ) && strFileName[ 2 ] == VFS_PATH_SEPARATOR ) )
-	{
-		strName = strFileName;
-		return VFS_TRUE;
-	}
-
-	strName = WithoutTrailingSeparator( strFileName, VFS_TRUE );
-
-	// Is there a trailing backslash?
-	if( strName.rfind( VFS_PATH_SEPARATOR ) != VFS_String::npos )
-	{
-		// Remove all the text from the beginning to the trailing backslash.
-		strName = strName.substr( strName.rfind( VFS_PATH_SEPARATOR ) + 1 );
-	}
-
+	strFileName = GetNameView( strFileName );
+	strName.assign( strFileName.data(), strFileName.size() );
 	return VFS_TRUE;
 }
 
 // Returns the Base Name for a File Name.
-VFS_BOOL VFS_Util_GetBaseName( const VFS_String& strFileName, VFS_String& strBaseName )
+VFS_BOOL VFS_Util_GetBaseName( VFS_StringView strFileName, VFS_String& strBaseName )
 {
 	// Get the Name.
-	if( !VFS_Util_GetName( strFileName, strBaseName ) )
-		return VFS_FALSE;
+	strFileName = GetNameView( strFileName );
 
 	// Is there a point in the string
-	if( strBaseName.rfind( VFS_TEXT( '.' ) ) != VFS_String::npos )
+	if( strFileName.rfind( VFS_TEXT( '.' ) ) != VFS_StringView::npos )
 	{
 		// Remove the Extension.
-		strBaseName = strBaseName.substr( 0, strBaseName.rfind( VFS_TEXT( '.' ) ) );
+		strFileName = strFileName.substr( 0, strFileName.rfind( VFS_TEXT( '.' ) ) );
 	}
 
+	strBaseName.assign( strFileName.data(), strFileName.size() );
 	return VFS_TRUE;
 }
 
 // Returns the Extension for a File Name.
-VFS_BOOL VFS_Util_GetExtension( const VFS_String& strFileName, VFS_String& strExtension )
+VFS_BOOL VFS_Util_GetExtension( VFS_StringView strFileName, VFS_String& strExtension )
 {
 	// Get the Name.
-	if( !VFS_Util_GetName( strFileName, strExtension ) )
-		return VFS_FALSE;
+	strFileName = GetNameView( strFileName );
 
 	// Is there a point in the string
-	if( strExtension.rfind( VFS_TEXT( '.' ) ) != VFS_String::npos )
+	if( strFileName.rfind( VFS_TEXT( '.' ) ) != VFS_StringView::npos )
 	{
 		// Remove the Extension.
-		strExtension = strExtension.substr( strExtension.rfind( VFS_TEXT( '.' ) ) + 1 );
+		strFileName = strFileName.substr( strFileName.rfind( VFS_TEXT( '.' ) ) + 1 );
 	}
 	else
 	{
-		strExtension = VFS_TEXT( "" );
+		strFileName = VFS_StringView();
 	}
 
+	strExtension.assign( strFileName.data(), strFileName.size() );
 	return VFS_TRUE;
 }
 
 // Determines whether the specified file name is absolute.
-VFS_BOOL VFS_Util_IsAbsoluteFileName( const VFS_String& strFileName )
+VFS_BOOL VFS_Util_IsAbsoluteFileName( VFS_StringView strFileName )
 {
 	// There are two possibilities for an absolute File Name.
 	// - <path separator>.......
@@ -158,3 +182,56 @@ VFS_BOOL VFS_Util_IsAbsoluteFileName( const VFS_String& strFileName )
 //============================================================================
 //    INTERFACE CLASS BODIES
 //============================================================================
+// --- Path Class ---
+// Assignment.
+VFS_Path& VFS_Path::Assign( VFS_StringView strPath )
+{
+	m_strPath.assign( strPath.data(), strPath.size() );
+	return Normalize();
+}
+
+VFS_Path& VFS_Path::Assign( VFS_StringView strDir, VFS_StringView strName )
+{
+	// Join them (the Directory may or may not have a trailing Separator).
+	m_strPath.assign( strDir.data(), strDir.size() );
+	if( !m_strPath.empty() && !strName.empty() && m_strPath[ m_strPath.size() - 1 ] != VFS_PATH_SEPARATOR )
+		m_strPath += VFS_PATH_SEPARATOR;
+	m_strPath.append( strName.data(), strName.size() );
+	return Normalize();
+}
+
+// Information.
+VFS_BOOL VFS_Path::IsAbsolute() const
+{
+	return VFS_Util_IsAbsoluteFileName( m_strPath );
+}
+
+// Strip the trailing Separator, lower-case the Key and find the Components.
+VFS_Path& VFS_Path::Normalize()
+{
+	m_strPath.resize( WithoutTrailingSeparatorView( m_strPath ).size() );
+	m_strKey.assign( m_strPath );
+	ToLowerInPlace( m_strKey );
+	m_qwHash = HashPath( m_strKey );
+
+	// Root Directories are their own Name and have an empty Path.
+	VFS_String::size_type nSeparator = m_strPath.rfind( VFS_PATH_SEPARATOR );
+	if( IsRootView( m_strPath ) || nSeparator == VFS_String::npos )
+	{
+		m_dwPathLength = 0;
+		m_dwNameOffset = 0;
+	}
+	else
+	{
+		m_dwPathLength = ( VFS_DWORD )nSeparator;
+		m_dwNameOffset = ( VFS_DWORD )nSeparator + 1;
+	}
+
+	VFS_String::size_type nPoint = m_strPath.rfind( VFS_TEXT( '.' ) );
+	if( nPoint != VFS_String::npos && nPoint >= m_dwNameOffset )
+		m_dwExtensionOffset = ( VFS_DWORD )nPoint;
+	else
+		m_dwExtensionOffset = ( VFS_DWORD )m_strPath.size();
+
+	return *this;
+}
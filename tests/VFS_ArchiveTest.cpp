@@ -0,0 +1,275 @@
+//****************************************************************************
+//**
+//**    VFS_ARCHIVETEST.CPP
+//**    Round Trip and Corruption Tests for the Archive Formats 1.1 - 1.5
+//**
+//**	Project:	VFS
+//**	Component:	Tests
+//**
+//**	History:
+//**		19.10.2026		Created
+//****************************************************************************
+
+//============================================================================
+//    IMPLEMENTATION HEADERS
+//============================================================================
+#include "VFS.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <unistd.h>
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE DEFINITIONS / ENUMERATIONS / SIMPLE TYPEDEFS
+//============================================================================
+// Fail the current Test (with the Location and the last VFS Error) if the Condition doesn't hold.
+#define CHECK( bCondition ) \
+	do \
+	{ \
+		if( !( bCondition ) ) \
+		{ \
+			fprintf( stderr, "%s(%d): Check failed: %s (%s)\n", __FILE__, __LINE__, #bCondition, VFS_GetErrorString( VFS_GetLastError() ) ); \
+			return VFS_FALSE; \
+		} \
+	} \
+	while( 0 )
+
+// The Test Files (small ones end up inline or in Solid Blocks, the big one is stored on its own).
+struct TestFile {
+	const VFS_CHAR* pszName;
+	VFS_DWORD dwSize;
+};
+
+static const TestFile g_TestFiles[] = {
+	{ VFS_TEXT( "empty.bin" ), 0 },
+	{ VFS_TEXT( "tiny.bin" ), 10 },
+	{ VFS_TEXT( "sub/inline.bin" ), 90 },
+	{ VFS_TEXT( "sub/solid1.bin" ), 300 },
+	{ VFS_TEXT( "sub/deep/solid2.bin" ), 1000 },
+	{ VFS_TEXT( "sub/deep/solid3.bin" ), 3000 },
+	{ VFS_TEXT( "big.bin" ), 100000 }
+};
+static const VFS_DWORD NUM_TEST_FILES = sizeof( g_TestFiles ) / sizeof( g_TestFiles[ 0 ] );
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE STRUCTURES / UTILITY CLASSES
+//============================================================================
+// A Filter which XORs the Data with a Key (stored as its Configuration Data, so the Filter Configuration Sizes are used).
+class CXorFilter : public VFS_Filter {
+	VFS_BYTE m_byKey;
+
+	static VFS_BOOL Run( VFS_FilterReadProc Reader, VFS_FilterWriteProc Writer, VFS_BYTE byKey )
+	{
+		VFS_BYTE Buffer[ 256 ];
+		VFS_DWORD dwRead;
+		while( Reader( Buffer, sizeof( Buffer ), &dwRead ) && dwRead > 0 )
+		{
+			for( VFS_DWORD dwByte = 0; dwByte < dwRead; dwByte++ )
+				Buffer[ dwByte ] ^= byKey;
+			if( !Writer( Buffer, dwRead, NULL ) )
+				return VFS_FALSE;
+		}
+		return VFS_TRUE;
+	}
+
+public:
+	CXorFilter()
+	: m_byKey( 0x5A )
+	{
+	}
+
+	VFS_BOOL Encode( VFS_FilterReadProc Reader, VFS_FilterWriteProc Writer, const VFS_EntityInfo& /* DecodedInfo */ ) const
+	{
+		return Run( Reader, Writer, m_byKey );
+	}
+	VFS_BOOL Decode( VFS_FilterReadProc Reader, VFS_FilterWriteProc Writer, const VFS_EntityInfo& /* EncodedInfo */ ) const
+	{
+		return Run( Reader, Writer, m_byKey );
+	}
+
+	VFS_BOOL LoadConfigData( VFS_FilterReadProc Reader )
+	{
+		VFS_DWORD dwRead;
+		return Reader( &m_byKey, 1, &dwRead ) && dwRead == 1;
+	}
+	VFS_BOOL SaveConfigData( VFS_FilterWriteProc Writer ) const
+	{
+		return Writer( &m_byKey, 1, NULL );
+	}
+	VFS_DWORD GetConfigDataSize() const
+	{
+		return 1;
+	}
+
+	VFS_PCSTR GetName() const
+	{
+		return VFS_TEXT( "xor" );
+	}
+	VFS_PCSTR GetDescription() const
+	{
+		return VFS_TEXT( "XORs the Data with a Key" );
+	}
+};
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE DATA
+//============================================================================
+// The Directory the Tests run in (lower-case, since the VFS lower-cases the Root Paths).
+static VFS_String g_strRoot;
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE FUNCTION PROTOTYPES
+//============================================================================
+static std::vector< VFS_BYTE > GetContent( VFS_DWORD dwFile, VFS_DWORD dwSize );
+static VFS_BOOL CheckFile( const VFS_String& strFileName, const std::vector< VFS_BYTE >& Expected );
+static VFS_BOOL CreateTestArchive( const VFS_String& strName, const VFS_FilterNameList& Filters );
+static VFS_BOOL TestRoundTrip( const VFS_String& strName, const VFS_FilterNameList& Filters );
+static VFS_BOOL TestChecksumMismatch();
+
+//============================================================================
+//    IMPLEMENTATION PRIVATE FUNCTIONS
+//============================================================================
+// The Content of a Test File (differs from File to File, so mixed up Offsets are noticed).
+static std::vector< VFS_BYTE > GetContent( VFS_DWORD dwFile, VFS_DWORD dwSize )
+{
+	std::vector< VFS_BYTE > Content( dwSize );
+	for( VFS_DWORD dwByte = 0; dwByte < dwSize; dwByte++ )
+		Content[ dwByte ] = ( VFS_BYTE )( dwFile * 31 + dwByte * 7 + dwByte / 251 );
+	return Content;
+}
+
+// Read a File through the VFS and compare it.
+static VFS_BOOL CheckFile( const VFS_String& strFileName, const std::vector< VFS_BYTE >& Expected )
+{
+	std::vector< VFS_BYTE > Data;
+	CHECK( VFS_File_ReadEntireFile( strFileName, Data ) );
+	CHECK( Data == Expected );
+	return VFS_TRUE;
+}
+
+// Write the Test Files and create an Archive of them.
+static VFS_BOOL CreateTestArchive( const VFS_String& strName, const VFS_FilterNameList& Filters )
+{
+	VFS_FileNameMap Files;
+	for( VFS_DWORD dwFile = 0; dwFile < NUM_TEST_FILES; dwFile++ )
+	{
+		VFS_String strSource = g_strRoot + VFS_TEXT( "/src/" ) + g_TestFiles[ dwFile ].pszName;
+		std::vector< VFS_BYTE > Content = GetContent( dwFile, g_TestFiles[ dwFile ].dwSize );
+
+		VFS_String strDir;
+		CHECK( VFS_Util_GetPath( strSource, strDir ) );
+		CHECK( VFS_Dir_Exists( strDir ) || VFS_Dir_Create( strDir, VFS_TRUE ) );
+		CHECK( VFS_File_WriteEntireFile( strSource, Content.empty() ? NULL : &Content[ 0 ], ( VFS_DWORD )Content.size() ) );
+		Files[ strSource ] = g_TestFiles[ dwFile ].pszName;
+	}
+
+	CHECK( VFS_Archive_CreateFromFileList( g_strRoot + VFS_PATH_SEPARATOR + strName, Files, Filters ) );
+	return VFS_TRUE;
+}
+
+// Build an Archive with Solid Blocks and inline Files, read it back and extract it with several Threads.
+static VFS_BOOL TestRoundTrip( const VFS_String& strName, const VFS_FilterNameList& Filters )
+{
+	CHECK( VFS_Archive_SetSolidBlockSize( 8192 ) );
+	CHECK( VFS_Archive_SetInlineFileSizeLimit( 100 ) );
+	CHECK( CreateTestArchive( strName, Filters ) );
+
+	// The Archive has to use the Filters it was created with.
+	VFS_FilterNameList UsedFilters;
+	CHECK( VFS_Archive_GetUsedFilters( g_strRoot + VFS_PATH_SEPARATOR + strName, UsedFilters ) );
+	CHECK( UsedFilters.size() == Filters.size() );
+
+	// Read the Files through the Archive...
+	for( VFS_DWORD dwFile = 0; dwFile < NUM_TEST_FILES; dwFile++ )
+	{
+		VFS_String strFileName = g_strRoot + VFS_PATH_SEPARATOR + strName + VFS_PATH_SEPARATOR + g_TestFiles[ dwFile ].pszName;
+		CHECK( CheckFile( strFileName, GetContent( dwFile, g_TestFiles[ dwFile ].dwSize ) ) );
+	}
+
+	// ... and extract them (Archives with Filters are extracted by one Thread anyway).
+	VFS_String strTarget = g_strRoot + VFS_TEXT( "/x_" ) + strName;
+	CHECK( VFS_Archive_SetExtractionThreads( 4 ) );
+	CHECK( VFS_Archive_Extract( g_strRoot + VFS_PATH_SEPARATOR + strName, strTarget ) );
+	for( VFS_DWORD dwFile = 0; dwFile < NUM_TEST_FILES; dwFile++ )
+		CHECK( CheckFile( strTarget + VFS_PATH_SEPARATOR + g_TestFiles[ dwFile ].pszName, GetContent( dwFile, g_TestFiles[ dwFile ].dwSize ) ) );
+
+	CHECK( VFS_Archive_SetSolidBlockSize( 0 ) );
+	CHECK( VFS_Archive_SetInlineFileSizeLimit( 0 ) );
+	CHECK( VFS_Archive_Flush() );
+	return VFS_TRUE;
+}
+
+// Flip a Byte of the Data of a File and check that reading it fails.
+static VFS_BOOL TestChecksumMismatch()
+{
+	// The Data of the last File ends the Archive File (the VFS creates it with a lower-cased Name).
+	CHECK( CreateTestArchive( VFS_TEXT( "crc" ), VFS_FilterNameList() ) );
+	CHECK( VFS_Archive_Flush() );
+
+	VFS_String strArchiveFileName = g_strRoot + VFS_TEXT( "/crc." ) + VFS_ARCHIVE_FILE_EXTENSION;
+	for( VFS_String::size_type nChar = 0; nChar < strArchiveFileName.size(); nChar++ )
+		strArchiveFileName[ nChar ] = ( VFS_CHAR )tolower( strArchiveFileName[ nChar ] );
+
+	FILE* pFile = fopen( strArchiveFileName.c_str(), "r+b" );
+	CHECK( pFile != NULL );
+	VFS_BOOL bFlipped = fseek( pFile, -1, SEEK_END ) == 0;
+	int nByte = bFlipped ? fgetc( pFile ) : EOF;
+	bFlipped = nByte != EOF && fseek( pFile, -1, SEEK_END ) == 0 && fputc( nByte ^ 0x01, pFile ) != EOF;
+	CHECK( fclose( pFile ) == 0 && bFlipped );
+
+	// Find the File the Byte belongs to: it's the only one which can't be read.
+	VFS_DWORD dwMismatches = 0;
+	for( VFS_DWORD dwFile = 0; dwFile < NUM_TEST_FILES; dwFile++ )
+	{
+		VFS_String strFileName = g_strRoot + VFS_TEXT( "/crc/" ) + g_TestFiles[ dwFile ].pszName;
+		VFS_Handle hFile = VFS_File_Open( strFileName, VFS_READ );
+		if( hFile != VFS_INVALID_HANDLE_VALUE )
+		{
+			CHECK( VFS_File_Close( hFile ) );
+			continue;
+		}
+
+		CHECK( VFS_GetLastError() == VFS_ERROR_CHECKSUM_MISMATCH );
+		dwMismatches++;
+	}
+	CHECK( dwMismatches == 1 );
+
+	// The Extraction fails as well.
+	CHECK( !VFS_Archive_Extract( g_strRoot + VFS_TEXT( "/crc" ), g_strRoot + VFS_TEXT( "/x_crc" ) ) );
+	CHECK( VFS_GetLastError() == VFS_ERROR_CHECKSUM_MISMATCH );
+
+	CHECK( VFS_Archive_Flush() );
+	return VFS_TRUE;
+}
+
+//============================================================================
+//    INTERFACE FUNCTIONS
+//============================================================================
+int main()
+{
+	char szRoot[ 64 ];
+	snprintf( szRoot, sizeof( szRoot ), "/tmp/vfs_archive_test_%ld", ( long )getpid() );
+	g_strRoot = szRoot;
+
+	static CXorFilter XorFilter;
+	if( !VFS_Init() || !VFS_RegisterFilter( &XorFilter ) || !VFS_Dir_Create( g_strRoot ) || !VFS_AddRootPath( g_strRoot ) )
+	{
+		fprintf( stderr, "Couldn't initialize the VFS (%s)\n", VFS_GetErrorString( VFS_GetLastError() ) );
+		return EXIT_FAILURE;
+	}
+
+	VFS_FilterNameList Filters;
+	Filters.push_back( VFS_TEXT( "xor" ) );
+
+	VFS_BOOL bResult = TestRoundTrip( VFS_TEXT( "plain" ), VFS_FilterNameList() ) &&
+		TestRoundTrip( VFS_TEXT( "filtered" ), Filters ) &&
+		TestChecksumMismatch();
+
+	// Clean up.
+	VFS_Archive_Flush();
+	VFS_Dir_Delete( g_strRoot, VFS_TRUE );
+	VFS_Shutdown();
+
+	printf( bResult ? "All Tests passed\n" : "Tests failed\n" );
+	return bResult ? EXIT_SUCCESS : EXIT_FAILURE;
+}